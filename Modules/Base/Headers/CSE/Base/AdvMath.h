@@ -117,11 +117,14 @@
 #include "CSE/Base/MathFuncs.h"
 #include "CSE/Base/GLTypes.h"
 #include "CSE/Base/LinAlg.h"
+#include <array>
 #include <stack>
 #include <map>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <random>
+#include <span>
 #include <variant>
 
 #if defined _MSC_VER
@@ -235,6 +238,63 @@ public:
     void Run(Function1D Function, float64 MaxIterLog);
 };
 
+/**
+ * @brief 批量迭代器，同时对多组互相独立的初值(通道)进行迭代，所有通道的求值点合并为一次批量
+ * 函数调用。各通道同步迭代，收敛或出错的通道在每次迭代后被移出活动列表，不再参与后续的求值，
+ * 因此不会拖慢其他通道。
+ * @details 派生类自行保存每个通道的状态，各虚函数的Lanes参数为当前活动的通道编号(升序)：
+ *  - PreEvaluator: 为每个活动通道生成相同数量的求值点，按通道顺序依次追加到x中
+ *  - PostEvaluator: 根据函数值更新各通道的状态
+ *  - Conditioner: 终止检测，将需要结束的通道在Terminate中对应的位置置1，并自行记录其状态
+ *  - Finalize: 每次迭代结束后对仍在活动的通道调用
+ */
+class BatchedElementwiseIterator
+{
+public:
+    using BatchFuncType = std::function<void(std::span<const float64> x, std::span<float64> fx)>;
+
+protected:
+    uint64              Lanes         = 0;
+    uint64              IterCount     = 0;
+    uint64              EvaluateCount = 0;
+    std::vector<uint64> Iterations; // 每个通道结束时的迭代次数
+
+public:
+    virtual void PreEvaluator(std::span<const uint64> Lanes, std::vector<float64>& x) = 0;
+    virtual void PostEvaluator(std::span<const uint64> Lanes, std::span<const float64> x,
+        std::span<const float64> fx) = 0;
+    virtual void Conditioner(std::span<const uint64> Lanes, std::span<bool> Terminate) = 0;
+    virtual void Finalize(std::span<const uint64> Lanes) = 0;
+
+    void Run(BatchFuncType Function, float64 MaxIterLog);
+
+    /**
+     * @brief 与Run相同，但直接给出最大迭代次数
+     */
+    void RunIterations(BatchFuncType Function, uint64 MaxIter);
+
+    /**
+     * @brief 使用逐点函数运行，同一批的求值点在Threads个线程中计算
+     */
+    void Run(Function1D Function, float64 MaxIterLog, uint64 Threads = 1);
+};
+
+/**
+ * @brief 实际使用的线程数，不超过任务数量
+ * @param Threads 期望的线程数，为0时使用硬件支持的线程数
+ */
+uint64 __Parallel_Workers(uint64 Count, uint64 Threads = 0);
+
+/**
+ * @brief 将Count个相互独立的任务分配到多个线程中执行，任务在线程中抛出的异常会在调用线程
+ * 中重新抛出。只要每个任务只写入属于自己的结果，结果就与线程数和调度顺序无关。
+ * @param Task 任务函数，参数为任务编号和线程编号，线程编号小于__Parallel_Workers的返回值，
+ * 可用于索引每个线程独占的临时空间
+ * @param Threads 线程数，为0时使用硬件支持的线程数
+ */
+void __Parallel_For(uint64 Count, std::function<void(uint64 Task, uint64 Worker)> Task,
+    uint64 Threads = 0);
+
 
 /****************************************************************************************\
 *                                         特殊函数                                        *
@@ -469,7 +529,33 @@ public:
         void Finalize() override {}
     };
 
+    /**
+     * @brief 批量求导使用的迭代器，每个通道为一个独立的上述迭代器
+     */
+    class BatchIterator : public BatchedElementwiseIterator
+    {
+    public:
+        using Mybase = BatchedElementwiseIterator;
+        friend class Adaptive1stOrderFDDerivativeFunction;
+
+    protected:
+        std::vector<Iterator> Items;
+
+    public:
+        void PreEvaluator(std::span<const uint64> Lanes, std::vector<float64>& x) override;
+        void PostEvaluator(std::span<const uint64> Lanes, std::span<const float64> x,
+            std::span<const float64> fx) override;
+        void Conditioner(std::span<const uint64> Lanes, std::span<bool> Terminate) override;
+        void Finalize(std::span<const uint64> Lanes) override;
+    };
+
+    using BatchFuncType = BatchedElementwiseIterator::BatchFuncType;
+
 protected:
+    BatchFuncType BatchFunction; // 可选，批量求值版本的原函数
+
+    Iterator CreateIterator(float64 x, float64 fx)const;
+
     // 一些附加选项，懒得加getter和setter了
     float64       AbsoluteTolerence = 300; // 绝对误差的负对数，默认 -log(0x1p-2022) = 307.65265556858878150844115040843
     float64       RelativeTolerence = 7.5; // 相对误差的负对数，默认 -log(sqrt(0x1p-52)) ~= 7.8267798872635110755572112628368
@@ -486,7 +572,339 @@ public:
         DerivativeOrder = 1;
     }
 
+    /**
+     * @brief 额外提供批量求值的原函数，批量求导时所有点的所有采样合并为一次调用
+     */
+    Adaptive1stOrderFDDerivativeFunction(Function1D Function, BatchFuncType Batch)
+        : Adaptive1stOrderFDDerivativeFunction(Function)
+    {
+        BatchFunction = Batch;
+    }
+
     float64 operator()(float64 x)const override;
+
+    /**
+     * @brief 批量求导，各点同步迭代，已收敛的点不再求值
+     * @param Threads 没有批量函数时逐点求值使用的线程数
+     */
+    void operator()(std::span<const float64> x, std::span<float64> Out, uint64 Threads = 1)const;
+};
+
+// ------------------------------------------------------------------------------------- //
+
+/**
+ * @brief 多元向量函数的雅可比矩阵
+ * @details 对每个自变量分量分别扰动，所有扰动点一次性生成后统一求值：传入逐点函数时各点
+ * 在多个线程中并行计算(因此函数必须是线程安全的)，传入批量函数(Batched)时只调用一次。
+ * 支持以下几种差分方式：
+ *  - Forward: 向前差分，每列1次额外求值，截断误差O(h)
+ *  - Central: 中心差分，每列2次求值，截断误差O(h^2)
+ *  - ComplexStep: 复步长法，f'(x) = Im(f(x + ih)) / h，没有相减抵消，可以精确到机器精度，
+ *    但需要提供复数版本的函数。使用复数函数构造时，其他两种方式取复数函数的实部计算。
+ * 前两种可以再进行RichardsonLevels层理查森外推，每层步长减半并提高阶数。
+ *
+ * 步长根据截断误差的阶数p自动选取，h = ε^(1 / (p + 1)) * max(|x|, 1)，并且保证x + h - x
+ * 恰好等于h。
+ *
+ * 结果写入预先分配好的DynamicMatrix中，at(j, i)为第i个函数对第j个自变量的偏导数，即列数
+ * 为自变量个数，行数为函数个数。
+ *
+ * @example
+ *  JacobianEngine J([](std::span<const float64> x, std::span<float64> f)
+ *  {
+ *      f[0] = x[0] * x[1];
+ *      f[1] = sin(Angle::FromRadians(x[0]));
+ *  }, 2, 2);
+ *  DynamicMatrix<float64> Jac({2, 2});
+ *  J(std::vector<float64>{1, 2}, Jac);
+ */
+class JacobianEngine
+{
+public:
+    using FuncType = std::function<void(std::span<const float64> x, std::span<float64> fx)>;
+    using BatchFuncType = std::function<void(std::span<const float64> Points, std::span<float64> Values)>;
+    using ComplexFuncType = std::function<void(std::span<const complex64> x, std::span<complex64> fx)>;
+
+    enum MethodType
+    {
+        Forward, Central, ComplexStep
+    };
+
+protected:
+    FuncType        PointFunction;
+    BatchFuncType   BatchFunction;
+    ComplexFuncType ComplexFunction;
+    uint64          InputDims;
+    uint64          OutputDims;
+
+    JacobianEngine(uint64 InDims, uint64 OutDims) : InputDims(InDims), OutputDims(OutDims) {}
+
+    float64 RelativeStep()const;
+    void Evaluate(std::span<const float64> Points, std::span<float64> Values)const;
+
+public:
+    MethodType Method           = Central;
+    uint64     RichardsonLevels = 0;
+    uint64     Threads          = 0; // 逐点函数并行求值使用的线程数，为0时使用硬件支持的线程数
+
+    JacobianEngine(FuncType Func, uint64 InDims, uint64 OutDims);
+    JacobianEngine(ComplexFuncType Func, uint64 InDims, uint64 OutDims);
+
+    /**
+     * @brief 使用批量函数构造，批量函数的Points中依次存放若干个点，Values中依次存放对应的
+     * 函数值
+     */
+    static JacobianEngine Batched(BatchFuncType Func, uint64 InDims, uint64 OutDims);
+
+    uint64 Inputs()const {return InputDims;}
+    uint64 Outputs()const {return OutputDims;}
+
+    /**
+     * @param x 求导点
+     * @param Jacobian 输出，大小不符时自动调整
+     * @param fx x处的函数值，可选，向前差分时若已知可以省去一次求值
+     */
+    void operator()(std::span<const float64> x, DynamicMatrix<float64>& Jacobian,
+        std::span<const float64> fx = {})const;
+
+    /**
+     * @brief 梯度，仅用于标量函数(函数个数为1)
+     */
+    void Gradient(std::span<const float64> x, std::span<float64> Out,
+        std::optional<float64> fx = std::nullopt)const;
+};
+
+// ------------------------------------------------------------------------------------- //
+
+/**
+ * @brief 前向自动微分使用的截断泰勒级数(jet)，一次求值即可得到函数在某点的0到N阶导数
+ * @details 内部存储的是归一化的泰勒系数a_k = f^(k)(x) / k!，四则运算和初等函数均按泰勒级数
+ * 的递推关系计算，每种运算的开销为O(N^2)，没有截断误差。
+ *
+ * 被积/求根的函数需要写成泛型的形式(如auto参数的lambda)，这样同一个函数既可以传入float64，
+ * 也可以传入Dual。初等函数通过实参依赖查找调用，名称与Base库中的函数一致：exp, ln, log,
+ * pow, sqrt, cbrt, sin, cos, tan, sinh, cosh, tanh, abs。和Base库一样，三角函数的参数使用
+ * Angle的单位(默认为角度)，弧度参数请先乘以Angle::Radians。
+ *
+ * 比较运算只比较函数值，因此函数中可以包含分支，但分支处的导数取所在分支的导数。
+ *
+ * @example
+ *  auto f = [](auto x){return exp(x) * sin(x * Angle::Radians);};
+ *  auto y = f(Dual<float64, 3>::Variable(0.5));
+ *  cout << y.Value() << ' ' << y.Derivative(1) << ' ' << y.Derivative(3) << '\n';
+ */
+template<typename _Ty, std::size_t N>
+class Dual
+{
+public:
+    using value_type = _Ty;
+    static constexpr std::size_t Order = N;
+
+    std::array<_Ty, N + 1> Coefficients{}; // 归一化的泰勒系数
+
+    Dual() = default;
+    Dual(_Ty Value) {Coefficients[0] = Value;}
+
+    /**
+     * @brief 构造自变量，即一阶导数为1的jet
+     */
+    static Dual Variable(_Ty x)
+    {
+        Dual Result(x);
+        if constexpr (N >= 1) {Result.Coefficients[1] = 1;}
+        return Result;
+    }
+
+    _Ty Value()const {return Coefficients[0];}
+
+    _Ty Derivative(std::size_t k)const
+    {
+        _Ty Factorial = 1;
+        for (std::size_t i = 2; i <= k; ++i) {Factorial *= _Ty(i);}
+        return Coefficients[k] * Factorial;
+    }
+
+    _Ty operator[](std::size_t k)const {return Coefficients[k];}
+
+    // ---------------------------------- 运算 ---------------------------------- //
+
+    Dual operator+()const {return *this;}
+    Dual operator-()const
+    {
+        Dual Result;
+        for (std::size_t k = 0; k <= N; ++k) {Result.Coefficients[k] = -Coefficients[k];}
+        return Result;
+    }
+
+    Dual& operator+=(const Dual& r)
+    {
+        for (std::size_t k = 0; k <= N; ++k) {Coefficients[k] += r.Coefficients[k];}
+        return *this;
+    }
+
+    Dual& operator-=(const Dual& r)
+    {
+        for (std::size_t k = 0; k <= N; ++k) {Coefficients[k] -= r.Coefficients[k];}
+        return *this;
+    }
+
+    Dual& operator*=(const Dual& r) {return *this = *this * r;}
+    Dual& operator/=(const Dual& r) {return *this = *this / r;}
+
+    friend Dual operator+(Dual l, const Dual& r) {return l += r;}
+    friend Dual operator-(Dual l, const Dual& r) {return l -= r;}
+
+    friend Dual operator*(const Dual& l, const Dual& r)
+    {
+        Dual Result;
+        for (std::size_t k = 0; k <= N; ++k)
+        {
+            _Ty Sum = 0;
+            for (std::size_t j = 0; j <= k; ++j) {Sum += l.Coefficients[j] * r.Coefficients[k - j];}
+            Result.Coefficients[k] = Sum;
+        }
+        return Result;
+    }
+
+    friend Dual operator/(const Dual& l, const Dual& r)
+    {
+        Dual Result;
+        for (std::size_t k = 0; k <= N; ++k)
+        {
+            _Ty Sum = l.Coefficients[k];
+            for (std::size_t j = 1; j <= k; ++j) {Sum -= r.Coefficients[j] * Result.Coefficients[k - j];}
+            Result.Coefficients[k] = Sum / r.Coefficients[0];
+        }
+        return Result;
+    }
+
+    friend bool operator==(const Dual& l, const Dual& r) {return l.Value() == r.Value();}
+    friend auto operator<=>(const Dual& l, const Dual& r) {return l.Value() <=> r.Value();}
+
+    // --------------------------------- 初等函数 --------------------------------- //
+
+    friend Dual exp(const Dual& x)
+    {
+        Dual Result(_CSE exp(x.Coefficients[0]));
+        for (std::size_t k = 1; k <= N; ++k)
+        {
+            _Ty Sum = 0;
+            for (std::size_t j = 1; j <= k; ++j) {Sum += _Ty(j) * x.Coefficients[j] * Result.Coefficients[k - j];}
+            Result.Coefficients[k] = Sum / _Ty(k);
+        }
+        return Result;
+    }
+
+    friend Dual ln(const Dual& x)
+    {
+        Dual Result(_CSE ln(x.Coefficients[0]));
+        for (std::size_t k = 1; k <= N; ++k)
+        {
+            _Ty Sum = 0;
+            for (std::size_t j = 1; j < k; ++j) {Sum += _Ty(j) * Result.Coefficients[j] * x.Coefficients[k - j];}
+            Result.Coefficients[k] = (x.Coefficients[k] - Sum / _Ty(k)) / x.Coefficients[0];
+        }
+        return Result;
+    }
+
+    friend Dual log(const Dual& x) {return ln(x) / _Ty(_CSE ln(10.));}
+    friend Dual log(const Dual& x, _Ty Base) {return ln(x) / _Ty(_CSE ln(Base));}
+
+    friend Dual pow(const Dual& x, _Ty p)
+    {
+        // 非负整数次幂直接连乘，可以处理x = 0的情况
+        if (p >= 0 && p <= 64 && p == _CSE floor(p))
+        {
+            Dual Result(1), Base = x;
+            for (uint64 e = uint64(p); e; e >>= 1, Base = Base * Base)
+            {
+                if (e & 1) {Result = Result * Base;}
+            }
+            return Result;
+        }
+        Dual Result(_CSE pow(x.Coefficients[0], p));
+        for (std::size_t k = 1; k <= N; ++k)
+        {
+            _Ty Sum = 0;
+            for (std::size_t j = 1; j <= k; ++j)
+            {
+                Sum += ((p + 1) * _Ty(j) - _Ty(k)) * x.Coefficients[j] * Result.Coefficients[k - j];
+            }
+            Result.Coefficients[k] = Sum / (_Ty(k) * x.Coefficients[0]);
+        }
+        return Result;
+    }
+
+    friend Dual pow(const Dual& x, const Dual& p) {return exp(p * ln(x));}
+    friend Dual pow(_Ty x, const Dual& p) {return exp(p * _Ty(_CSE ln(x)));}
+    friend Dual sqrt(const Dual& x) {return pow(x, _Ty(0.5));}
+    friend Dual cbrt(const Dual& x) {return pow(x, _Ty(1) / _Ty(3));}
+
+    friend Dual abs(const Dual& x) {return x.Coefficients[0] < 0 ? -x : x;}
+
+    /**
+     * @brief 同时计算正弦和余弦(或双曲正弦和双曲余弦)，Sign为-1时为三角函数，1时为双曲函数
+     */
+    static void SinCos(const Dual& u, _Ty s0, _Ty c0, int Sign, Dual* s, Dual* c)
+    {
+        s->Coefficients.fill(0);
+        c->Coefficients.fill(0);
+        s->Coefficients[0] = s0;
+        c->Coefficients[0] = c0;
+        for (std::size_t k = 1; k <= N; ++k)
+        {
+            _Ty SSum = 0, CSum = 0;
+            for (std::size_t j = 1; j <= k; ++j)
+            {
+                SSum += _Ty(j) * u.Coefficients[j] * c->Coefficients[k - j];
+                CSum += _Ty(j) * u.Coefficients[j] * s->Coefficients[k - j];
+            }
+            s->Coefficients[k] = SSum / _Ty(k);
+            c->Coefficients[k] = Sign * CSum / _Ty(k);
+        }
+    }
+
+    friend Dual sin(const Dual& x)
+    {
+        Dual s, c, u = x / _Ty(Angle::Radians);
+        SinCos(u, _CSE sin(Angle(x.Coefficients[0])), _CSE cos(Angle(x.Coefficients[0])), -1, &s, &c);
+        return s;
+    }
+
+    friend Dual cos(const Dual& x)
+    {
+        Dual s, c, u = x / _Ty(Angle::Radians);
+        SinCos(u, _CSE sin(Angle(x.Coefficients[0])), _CSE cos(Angle(x.Coefficients[0])), -1, &s, &c);
+        return c;
+    }
+
+    friend Dual tan(const Dual& x)
+    {
+        Dual s, c, u = x / _Ty(Angle::Radians);
+        SinCos(u, _CSE sin(Angle(x.Coefficients[0])), _CSE cos(Angle(x.Coefficients[0])), -1, &s, &c);
+        return s / c;
+    }
+
+    friend Dual sinh(const Dual& x)
+    {
+        Dual s, c;
+        SinCos(x, _CSE sinh(x.Coefficients[0]), _CSE cosh(x.Coefficients[0]), 1, &s, &c);
+        return s;
+    }
+
+    friend Dual cosh(const Dual& x)
+    {
+        Dual s, c;
+        SinCos(x, _CSE sinh(x.Coefficients[0]), _CSE cosh(x.Coefficients[0]), 1, &s, &c);
+        return c;
+    }
+
+    friend Dual tanh(const Dual& x)
+    {
+        Dual s, c;
+        SinCos(x, _CSE sinh(x.Coefficients[0]), _CSE cosh(x.Coefficients[0]), 1, &s, &c);
+        return s / c;
+    }
 };
 
 /* ************************************************************************** *\
@@ -566,6 +984,10 @@ typedef class DefiniteIntegratingFunction
 {
 protected:
     virtual float64 Run(Function1D f, float64 a, float64 b)const = 0;
+
+    // 引擎可以直接处理无穷积分限时返回真，此时无穷积分限会原样传给Run，不做变量代换
+    virtual bool NativeInfiniteLimits()const {return false;}
+
 public:
     float64 operator()(Function1D f, float64 a, float64 b)const;
 }IntegralFunction;
@@ -677,6 +1099,65 @@ public:
     float64 GaussKronrodIntegrate(Function1D f, float64 a, float64 b, float64* LastError = nullptr, float64* L1Norm = nullptr)const;
 };
 
+/**
+ * @brief 预先计算的插值型积分权重
+ * @details 对一组固定的采样点(如固定的波长网格，时间网格等)只计算一次权重，之后对任意函数值
+ * 的积分都只需计算一次点积dot(w, y)。采样点按Level个区间一组分块，每块上使用经过该块所有
+ * 采样点的插值多项式积分，即非等距的牛顿-科特斯公式；最后不足一块的区间使用最后Level + 1个
+ * 采样点的插值多项式，只在剩余的区间上积分(Level为2时即辛普森公式的奇数区间修正)。
+ *
+ * 权重使用Fornberg递推计算插值多项式在块中点处的各阶导数再逐项积分得到，不需要求解(或求逆)
+ * 范德蒙矩阵，高阶时也比较稳定。
+ *
+ * 参考文献：
+ * [1] Fornberg B. Calculation of Weights in Finite Difference Formulas[J]. SIAM Review,
+ *     1998, 40(3): 685-691.
+ *
+ * @example
+ *  QuadratureWeights W(WavelengthGrid, 4);
+ *  for (auto& Spectrum : Spectra) {Flux.push_back(W(Spectrum));}
+ */
+class QuadratureWeights
+{
+protected:
+    std::vector<float64> Abscissas;
+    std::vector<float64> Weights;
+
+public:
+    QuadratureWeights() = default;
+
+    /**
+     * @param x 采样点，需单调
+     * @param Level 每块的区间数，采样点不够时自动降低
+     */
+    QuadratureWeights(std::span<const float64> x, uint64 Level = 2);
+
+    /**
+     * @brief Fornberg算法，计算经过节点x的插值多项式在z处的0到MaxOrder阶导数关于各节点函数
+     * 值的权重
+     * @return 矩阵，at(j, k)为第j个节点在k阶导数中的权重
+     */
+    static DynamicMatrix<float64> FornbergWeights(float64 z, std::span<const float64> x, uint64 MaxOrder);
+
+    /**
+     * @brief 经过节点x的插值多项式在[a, b]上积分时各节点函数值的权重
+     */
+    static void IntegralWeights(std::span<const float64> x, float64 a, float64 b, std::span<float64> Out);
+
+    uint64 size()const {return Weights.size();}
+    const std::vector<float64>& GetAbscissas()const {return Abscissas;}
+    const std::vector<float64>& GetWeights()const {return Weights;}
+
+    float64 Integrate(std::span<const float64> y)const;
+
+    /**
+     * @brief 批量积分，Y中依次存放Out.size()组函数值，每组长度与采样点数相同
+     */
+    void Integrate(std::span<const float64> Y, std::span<float64> Out, uint64 Threads = 0)const;
+
+    float64 operator()(std::span<const float64> y)const {return Integrate(y);}
+};
+
 struct __Newton_Cotes_Param_Table_Type
 {
     int64 Scale;
@@ -732,17 +1213,148 @@ public:
         std::vector<float64>* Weight, float64* Error);
 
     static bool IsEvenlySized(std::vector<vec2> Samples);
+    static bool IsEvenlySized(std::span<const float64> x);
 
     static float64 Trapezoidal(std::vector<vec2> Samples);
     static float64 Simpson(std::vector<vec2> Samples);
     static float64 Romberg(std::vector<vec2> Samples,
         DynamicMatrix<float64>* RichardsonExtrapolationTable = nullptr); // 严格来说，龙贝格积分也是此积分的一个子集
 
+    /**
+     * @brief 以下为针对大量采样数据的版本，自变量和函数值分开存放(x和y)，不复制数据，单次
+     * 遍历完成计算。只传入y和步长h的版本用于等距采样。
+     * 非等距采样的辛普森积分在区间数为奇数时最后一个区间使用二次插值修正，与上面的版本相同。
+     */
+    static float64 Trapezoidal(std::span<const float64> x, std::span<const float64> y);
+    static float64 Trapezoidal(std::span<const float64> y, float64 h);
+    static float64 Simpson(std::span<const float64> x, std::span<const float64> y);
+    static float64 Simpson(std::span<const float64> y, float64 h);
+    static float64 Romberg(std::span<const float64> x, std::span<const float64> y,
+        DynamicMatrix<float64>* RichardsonExtrapolationTable = nullptr);
+    static float64 Romberg(std::span<const float64> y, float64 h,
+        DynamicMatrix<float64>* RichardsonExtrapolationTable = nullptr);
+
+    /**
+     * @brief 累积积分，单次遍历输出积分函数在每个采样点上的值
+     * @param Out 输出，长度与y相同，Out[0]为初值，Out[i]为从x[0]到x[i]的积分加上初值
+     * @param Initial 初值
+     * @note 累积辛普森积分把每对相邻区间上的二次插值拆成前后两半，因此偶数下标处的值与复化
+     * 辛普森积分一致；区间数为奇数时最后一个区间使用前一个采样点，即SciPy中cumulative_simpson的做法。
+     */
+    static void CumulativeTrapezoidal(std::span<const float64> x, std::span<const float64> y,
+        std::span<float64> Out, float64 Initial = 0);
+    static void CumulativeTrapezoidal(std::span<const float64> y, float64 h,
+        std::span<float64> Out, float64 Initial = 0);
+    static void CumulativeSimpson(std::span<const float64> x, std::span<const float64> y,
+        std::span<float64> Out, float64 Initial = 0);
+    static void CumulativeSimpson(std::span<const float64> y, float64 h,
+        std::span<float64> Out, float64 Initial = 0);
+
+    /**
+     * @brief 对固定的采样点预先计算权重，块的大小与此对象的阶数相同
+     */
+    QuadratureWeights CompileWeights(std::span<const float64> x)const;
+
     float64 SingleIntegrate(std::vector<vec2> Samples)const;
     float64 CompositeIntegrate(std::vector<vec2> Samples)const;
     float64 DiscreteIntegrate(std::vector<vec2> Samples)const;
 };
 
+/**
+ * @brief 流式积分器，用于分块到达且总长度未知的采样数据(如遥测数据，OEM星历等)
+ * @details 样本逐个或分块传入，只保存首尾各MaxGregoryOrder + 1个样本和几个累加值，内存占用
+ * 与样本数无关。任意时刻都可以取出当前的梯形，辛普森或格雷戈里积分结果。
+ *
+ * 格雷戈里积分在梯形公式的基础上用首尾的差分进行端点修正，要求等距采样，步长取前两个样本
+ * 的间距；梯形和辛普森积分不要求等距。
+ *
+ * 多个线程各自处理相邻的几段数据时，可以按顺序使用merge将后一段合并到前一段上，两段之间的
+ * 那个区间以及跨越分界的辛普森区间对在合并时补上，结果与整段一次性计算相同。
+ *
+ * @example
+ *  StreamingIntegrator Integrator;
+ *  for (uint64 i = 0; i <= 100; ++i) {Integrator.Push(i / 100., exp(i / 100.));}
+ *  cout << Integrator.Gregory(4) << '\n';
+ *  输出：1.718281828459045(e - 1)
+ */
+class StreamingIntegrator
+{
+public:
+    static const uint64 MaxGregoryOrder = 5;
+    static const uint64 EndSamples = MaxGregoryOrder + 1;
+
+protected:
+    uint64                     Count = 0;
+    float64                    TrapezoidalSum = 0;
+    float64                    SimpsonPairSum[2] = {0, 0}; // 按区间对首个样本下标的奇偶分别累加
+    std::array<vec2, EndSamples> Head;
+    std::array<vec2, EndSamples> Tail; // 环形缓冲区，最后一个样本位于(Count - 1) % EndSamples
+
+    static float64 SimpsonPair(vec2 p0, vec2 p1, vec2 p2);
+    void PushTail(vec2 Sample);
+
+public:
+    StreamingIntegrator() = default;
+
+    void Push(float64 x, float64 y);
+    void Push(std::span<const float64> x, std::span<const float64> y);
+    void clear();
+    StreamingIntegrator& merge(const StreamingIntegrator& Next);
+
+    uint64 size()const {return Count;}
+    bool empty()const {return !Count;}
+    vec2 front(uint64 i = 0)const; // 第i个样本
+    vec2 back(uint64 i = 0)const; // 倒数第i + 1个样本
+
+    float64 Trapezoidal()const;
+    float64 Simpson()const;
+
+    /**
+     * @brief 格雷戈里积分
+     * @param Order 修正项数，0为梯形公式，最大为MaxGregoryOrder。样本不够时自动降阶。
+     * 修正Order项时对不超过Order次的多项式精确，Order为偶数时可达Order + 1次。
+     */
+    float64 Gregory(uint64 Order = 3)const;
+};
+
+/**
+ * @brief 双指数(tanh-sinh)积分
+ * @details 使用变量代换x = tanh(π/2 * sinh(t))将积分区间映射到整个实轴上，代换后的被积函
+ * 数在两端以双指数速度衰减，再使用梯形公式计算。由于节点在端点附近极为密集，所以此方法对
+ * 端点处存在奇点或导数发散的函数(如黎曼-刘维尔积分中的(x-t)^(α-1))效果远好于高斯积分。
+ * 半无穷区间使用exp-sinh代换，无穷区间使用sinh-sinh代换。
+ *
+ * 各层节点和权重在第一次使用时计算并存表，第k层的步长为第k-1层的一半，每层只计算新增的
+ * 奇数节点，之前的函数值全部复用。节点在端点附近存储的是到端点的距离，避免出现大数相减。
+ * 若被积函数在某侧的节点上返回非有限值，则此后该侧更靠外的节点不再计算。
+ *
+ * 「要不是看在双指数收敛的份上，谁愿意在端点上蹲着呢？」
+ *
+ * @example
+ *  计算1/sqrt(x)从0到1的积分：
+ *      TanhSinhQuadrature IntegralFunc;
+ *      cout << IntegralFunc([](float64 x){return 1. / sqrt(x);}, 0, 1) << '\n';
+ *  输出：2
+ */
+class TanhSinhQuadrature : public DefiniteIntegratingFunction
+{
+public:
+    using Mybase = DefiniteIntegratingFunction;
+    static const uint64 MaxTableLevels = 12;
+
+protected:
+    float64 Run(Function1D f, float64 a, float64 b)const override;
+    bool NativeInfiniteLimits()const override {return true;}
+
+public:
+    float64 Tolerence = 8; // 相邻两层结果之差的相对误差的负对数，最终精度约为此值的两倍
+    uint64  MaxLevels = 8;
+
+    float64 TanhSinh(Function1D f, float64 a, float64 b, float64* LastError = nullptr, float64* L1Norm = nullptr)const;
+    float64 ExpSinh(Function1D f, float64 a, float64* LastError = nullptr, float64* L1Norm = nullptr)const;
+    float64 SinhSinh(Function1D f, float64* LastError = nullptr, float64* L1Norm = nullptr)const;
+};
+
 using DefaultIntegratingFunction = GaussKronrodQuadrature;
 
 // ------------------------------------------------------------------------------------- //
@@ -860,15 +1472,107 @@ public:
 }RiemannLiouvilleDerivativeFunction;
 
 /**
- * @brief 多重积分
- * @details
- * 丹霞：这个工具实现的是仅使用一维的积分引擎计算二维甚至更高维的积分。不过它的延迟是非常
- * 不可控的，积分的维数和使用的积分引擎都可能影响。测试此功能时为它设计了9个用例，如下：
- * （为了省事，这里直接贴Latex了）
- *
- *  [初入江湖]
- *  (1) \f[\int^4_0 x^2 dx\f]
- *  (2) \f[\int^\infty_0 e^{-x} dx\f]
+ * @brief 低差异序列(拟随机序列)基类
+ * @details 序列中的每个点都可以通过下标直接生成，不依赖于上一个点，所以可以分批并行生成，
+ * 且结果与分批方式和线程数无关。生成的点位于单位超立方体(0, 1)^d内部，不会落在边界上。
+ */
+class QuasiRandomSequence
+{
+public:
+    virtual ~QuasiRandomSequence() {}
+
+    virtual uint64 Dimensions()const = 0;
+
+    /**
+     * @brief 生成序列中的第Index个点
+     * @param Index 点的下标
+     * @param Point 输出，长度至少为维数
+     */
+    virtual void Generate(uint64 Index, std::span<float64> Point)const = 0;
+
+    /**
+     * @brief 批量生成序列中从First开始的Count个点，点按行依次存放
+     */
+    virtual void Generate(uint64 First, uint64 Count, std::span<float64> Points)const;
+};
+
+/**
+ * @brief 索伯(Sobol)序列
+ * @details 方向数取自Joe和Kuo发表的new-joe-kuo-6.21201表，目前最高支持21维。指定随机种
+ * 子时对序列做欧文(Owen)嵌套均匀置乱，置乱使用Burley提出的基于哈希的实现，每个维度使用独
+ * 立的哈希种子，不需要额外存储置乱树。置乱后序列仍然保持(t, m, s)网格的性质，同时每个点
+ * 在单位超立方体上均匀分布，所以多个不同种子的序列可用于估计积分误差。
+ */
+class SobolSequence : public QuasiRandomSequence
+{
+public:
+    static const uint64 MaxDimensions = 21;
+    static const uint64 Bits          = 32;
+
+protected:
+    uint64 Dims;
+    std::vector<uint64> DirectionNumbers; // Dims * Bits
+    std::vector<uint64> ScrambleSeeds;    // 为空时不置乱
+
+public:
+    SobolSequence(uint64 Dimensions, bool Scramble = true, uint64 Seed = 0);
+
+    uint64 Dimensions()const override {return Dims;}
+    void Generate(uint64 Index, std::span<float64> Point)const override;
+    using QuasiRandomSequence::Generate;
+};
+
+/**
+ * @brief 霍尔顿(Halton)序列
+ * @details 第k维以第k个质数为基底做根式反演。指定随机种子时对每一维的每一位数字使用独立的
+ * 随机排列(置乱霍尔顿序列)，以消除高维时相邻质数基底之间的相关性。
+ */
+class HaltonSequence : public QuasiRandomSequence
+{
+protected:
+    uint64 Dims;
+    std::vector<uint64> Bases;
+    std::vector<uint64> DigitCounts;
+    std::vector<uint64> PermOffsets;
+    std::vector<uint64> Permutations; // 每维每位数字的排列，为空时不置乱
+
+public:
+    HaltonSequence(uint64 Dimensions, bool Scramble = true, uint64 Seed = 0);
+
+    uint64 Dimensions()const override {return Dims;}
+    void Generate(uint64 Index, std::span<float64> Point)const override;
+    using QuasiRandomSequence::Generate;
+};
+
+/**
+ * @brief 伪随机序列，与上面两个序列使用相同的接口，用于普通蒙特卡洛积分
+ * @details 使用基于计数器的哈希生成随机数，所以同样可以通过下标直接生成任意一个点。
+ */
+class PseudoRandomSequence : public QuasiRandomSequence
+{
+protected:
+    uint64 Dims;
+    uint64 Seed;
+
+public:
+    PseudoRandomSequence(uint64 Dimensions, uint64 Seed = 0)
+        : Dims(Dimensions), Seed(Seed) {}
+
+    uint64 Dimensions()const override {return Dims;}
+    void Generate(uint64 Index, std::span<float64> Point)const override;
+    using QuasiRandomSequence::Generate;
+};
+
+/**
+ * @brief 多重积分
+ * @details
+ * 丹霞：这个工具实现的是仅使用一维的积分引擎计算二维甚至更高维的积分。不过它的延迟是非常
+ * 不可控的，积分的维数和使用的积分引擎都可能影响。测试此功能时为它设计了9个用例，如下：
+ * （为了省事，这里直接贴Latex了）
+ *
+ *  [初入江湖]
+ *  (1) \f[\int^4_0 x^2 dx\f]
+ *  (2) \f[\int^\infty_0 e^{-x} dx\f]
  *
  *  [小有名气]
  *  (3) \f[\int^{x=2}_{x=0} \int^{y=1}_{y=0} x y^2 \,dy \,dx\f]
@@ -904,6 +1608,10 @@ public:
  * 高维积分而言，常用的解决办法是引入主动学习采样或稀疏网格以降低复杂度，或者更简单的随机
  * 采样，也就是蒙特卡洛算法。此处也将蒙特卡洛算法作为备用解决方案，但是此方法收敛速度较慢，
  * 需要较多的样本点才能到达较高的精度，但是与常规方法导致的炸维度相比是会快很多。
+ *
+ * 后来又补充了几种直接在多维空间中取点的方法：拟蒙特卡洛(适合4维以上)，根茨-马利克自适应
+ * 求积(适合2到6维左右的光滑函数)，以及可重复使用的张量积高斯网格(适合低维)。这几种方法都
+ * 支持批量计算和多线程，上面第(8)个积分使用根茨-马利克方法不到1秒即可算出。
  */
 class __Multidimensional_Integral
 {
@@ -914,13 +1622,57 @@ public:
     using BoundaryType  = std::variant<float64, FuncType>;
     using BoundPairType = std::pair<BoundaryType, BoundaryType>;
 
+    // 批量被积函数，Points中每Dims个数为一个点，Values为对应的函数值
+    using BatchFuncType = std::function<void(std::span<const float64> Points,
+        std::span<float64> Values)>;
+
+    enum SequenceType
+    {
+        Sobol,
+        Halton
+    };
+
 protected:
     static const DefaultEngine DefEngine;
     const SciCxx::DefiniteIntegratingFunction* Engine;
 
-    float64 UnpackBoundary(const BoundaryType& Func, const std::vector<float64>& Pinned)const;
-    float64 RecursiveIntergrate(FuncType Func, std::vector<float64> Pinned,
-        std::stack<BoundPairType> Remains)const;
+    static float64 UnpackBoundary(const BoundaryType& Func, const std::vector<float64>& Pinned);
+
+    /**
+     * @brief 将单位超立方体(0, 1)^d中的点映射到积分区域内，返回雅可比行列式
+     * @details 每一维按顺序映射，函数边界使用已映射的前几维计算，无穷边界使用与一维积分
+     * 相同的变量代换。
+     * @param Bounds 各维边界，第一维在最前
+     * @param Unit 单位超立方体中的点
+     * @param Point 输出，积分区域中的点
+     * @param Pinned 临时存储，用于计算函数边界，避免重复分配内存
+     */
+    static float64 MapFromUnitCube(const std::vector<BoundPairType>& Bounds,
+        std::span<const float64> Unit, std::span<float64> Point,
+        std::vector<float64>& Pinned);
+
+    static std::vector<BoundPairType> MergeBounds(vec2 BoundaryX,
+        const std::vector<BoundPairType>& OtherBounds);
+
+    using NodeGeneratorType = std::function<void(uint64 First, uint64 Count,
+        std::span<float64> Unit, std::span<float64> Weights)>;
+
+    /**
+     * @brief 分块计算加权和，每块内先由Generator生成单位超立方体中的节点和权重，映射后批量
+     * 计算函数值。返回每块的部分和，由调用者按顺序归约。
+     */
+    static std::vector<float64> WeightedBlockSums(const BatchFuncType& Func,
+        const std::vector<BoundPairType>& Bounds, uint64 Count,
+        NodeGeneratorType Generator, uint64 Threads);
+
+    static vec2 SequenceIntegrate(BatchFuncType Func, const std::vector<BoundPairType>& Bounds,
+        const std::vector<std::shared_ptr<QuasiRandomSequence>>& Sequences,
+        uint64 Samples, uint64 Threads);
+
+    static BatchFuncType MakeBatch(const FuncType& Func, uint64 Dims);
+    // Pinned为所有层共享的缓冲区，长度即为当前的层数
+    float64 RecursiveIntergrate(const FuncType& Func, std::vector<float64>& Pinned,
+        const std::vector<BoundPairType>& Bounds)const;
 
 public:
     __Multidimensional_Integral() : Engine(&DefEngine) {}
@@ -933,9 +1685,89 @@ public:
     float64 operator()(FuncType Func, vec2 BoundaryX,
         std::vector<BoundPairType> OtherBounds)const;
 
+    /**
+     * @brief 普通蒙特卡洛积分
+     * @param LogSamples 样本数量的常用对数
+     * @param Seed 随机种子
+     */
     static float64 MonteCarlo(FuncType Func, vec2 BoundaryX,
         std::vector<BoundPairType> OtherBounds, float64 LogSamples = 6,
-        uint64 Seed = std::random_device()()); // TODO
+        uint64 Seed = std::random_device()());
+
+    /**
+     * @brief 拟蒙特卡洛积分，使用若干组独立置乱的低差异序列(随机化拟蒙特卡洛)
+     * @details 每组序列给出一个积分的无偏估计，取平均值作为积分值，以各组估计值的标准误
+     * 差作为误差估计。样本分成固定大小的块在多个线程中计算，各块的部分和按块的顺序求和，
+     * 所以对同一个种子结果是确定的，与线程数无关。
+     * @param LogSamples 总样本数量的常用对数，每组序列的样本数向上取为2的整数次幂
+     * @param Replicates 独立置乱的序列组数，至少为2组时才能估计误差
+     * @param Seed 随机种子
+     * @param Sequence 使用的低差异序列
+     * @param Threads 线程数，为0时使用硬件支持的线程数
+     * @return x为积分值，y为误差估计(标准误差)
+     * @example 计算高维高斯积分：
+     *  auto Res = __Multidimensional_Integral::QuasiMonteCarlo(
+     *      [](std::vector<float64> x){return exp(-(x[0]*x[0] + x[1]*x[1] + x[2]*x[2]));},
+     *      {-inf, inf}, {MakeBound(-inf, inf), MakeBound(-inf, inf)});
+     */
+    static vec2 QuasiMonteCarlo(FuncType Func, vec2 BoundaryX,
+        std::vector<BoundPairType> OtherBounds, float64 LogSamples = 5,
+        uint64 Replicates = 8, uint64 Seed = 0, SequenceType Sequence = Sobol,
+        uint64 Threads = 0);
+
+    static vec2 QuasiMonteCarlo(BatchFuncType Func, vec2 BoundaryX,
+        std::vector<BoundPairType> OtherBounds, float64 LogSamples = 5,
+        uint64 Replicates = 8, uint64 Seed = 0, SequenceType Sequence = Sobol,
+        uint64 Threads = 0);
+
+    /**
+     * @brief 根茨-马利克(Genz-Malik)自适应求积，适用于2维以上的中等维数积分
+     * @details 每个子区域上使用7次的求积公式计算积分值，以嵌套的5次公式的差作为误差估计。
+     * 每次取出误差最大的若干个子区域，沿四阶差分最大的坐标轴对半分割，新的子区域在多个
+     * 线程中并行计算，每个子区域的所有节点作为一批交给被积函数。所有计算在单位超立方体上
+     * 进行，所以同样支持函数边界和无穷边界。每次分割的子区域数量与线程数无关，所以结果
+     * 是确定的。
+     * @param AbsTolNLog 绝对误差的负对数
+     * @param RelTolNLog 相对误差的负对数
+     * @param MaxEvalLog 最大函数计算次数的常用对数
+     * @param Threads 线程数，为0时使用硬件支持的线程数
+     * @return x为积分值，y为误差估计
+     */
+    static vec2 GenzMalik(BatchFuncType Func, vec2 BoundaryX,
+        std::vector<BoundPairType> OtherBounds, float64 AbsTolNLog = 10,
+        float64 RelTolNLog = 8, float64 MaxEvalLog = 6, uint64 Threads = 0);
+
+    static vec2 GenzMalik(FuncType Func, vec2 BoundaryX,
+        std::vector<BoundPairType> OtherBounds, float64 AbsTolNLog = 10,
+        float64 RelTolNLog = 8, float64 MaxEvalLog = 6, uint64 Threads = 0);
+
+    /**
+     * @brief 张量积高斯-勒让德求积网格
+     * @details 构造时计算所有节点(已映射到积分区域中)和对应的权重(已乘雅可比)，之后每次
+     * 积分只需要分块批量计算函数值并求加权和，不再分配内存。适合在同一区域上对多个被积
+     * 函数反复积分的情况。节点数量为各轴点数的乘积，维数较高时请使用拟蒙特卡洛或根茨-马
+     * 利克方法。
+     */
+    class TensorProductGrid
+    {
+    protected:
+        uint64               Dims;
+        std::vector<float64> Nodes;   // 每Dims个数为一个点
+        std::vector<float64> Weights;
+
+    public:
+        /**
+         * @param Points 每个轴上的高斯点数，只有一个值时所有轴使用相同的点数
+         */
+        TensorProductGrid(vec2 BoundaryX, std::vector<BoundPairType> OtherBounds,
+            std::vector<uint64> Points = {15});
+
+        uint64 Dimensions()const {return Dims;}
+        uint64 size()const {return Weights.size();}
+
+        float64 operator()(BatchFuncType Func, uint64 Threads = 0)const;
+        float64 operator()(FuncType Func, uint64 Threads = 0)const;
+    };
 };
 
 
@@ -976,11 +1808,19 @@ public:
  *      cout << "]\n";
  *
  *  将输出的数组使用matplotlib打印出来，即可看到函数图像
+ *
+ *  右端函数也可以写成原地形式，直接将导数写入预先分配的空间，避免每次求值时分配内存：
+ *      auto lotkavolterra = [a, b, c, d](float64 t, std::span<const float64> z, std::span<float64> dz)
+ *      {
+ *          dz[0] = a * z[0] - b * z[0] * z[1];
+ *          dz[1] = -c * z[1] + d * z[0] * z[1];
+ *      };
  */
 class OrdinaryDifferentialEquation
 {
 public:
     using Fty        = std::vector<float64>(float64 Scalar, std::vector<float64> Coeffs);
+    using InPlaceFty = void(float64 Scalar, std::span<const float64> Coeffs, std::span<float64> Derivatives);
     using ValueArray = std::vector<float64>;
     using StateType  = std::map<float64, ValueArray>;
 
@@ -1007,25 +1847,101 @@ public:
     {
         Processing = -1,
         Succeeded  = 0,
-        Failed     = 1
+        Failed     = 1,
+        Terminated = 2  // 因终止事件而提前结束
+    };
+
+    /**
+     * @brief 输出策略，决定求解过程中保留哪些采样点和稠密输出段
+     * @details 可选的模式：
+     *  - KeepAll：全部保留，默认行为
+     *  - KeepLast：只保留最后一个采样点和最后一段稠密输出
+     *  - RingBuffer：保留最近Capacity个采样点和Capacity段稠密输出
+     *  - Decimate：只在Times给出的时刻记录解，这些时刻须按求解方向排序，解由步内插值得到，
+     *    稠密输出只保留最后一段
+     *  - Stream：每个采样点交给StateCallback，每段稠密输出交给SegmentCallback，
+     *    自身只保留最后一个采样点和最后一段稠密输出
+     * 除KeepAll外，内存占用都与积分区间的长度无关，适合长时间的积分。
+     * 策略须在Init之前通过SetOutputPolicy设置。
+     */
+    struct OutputPolicy
+    {
+        enum ModeType
+        {
+            KeepAll,
+            KeepLast,
+            RingBuffer,
+            Decimate,
+            Stream
+        };
+
+        using StateCallbackType   = void(float64 x, std::span<const float64> y);
+        // 稠密输出段的区间、起点值和系数，系数的排列方式由各引擎自行规定
+        using SegmentCallbackType = void(float64 First, float64 Last,
+            std::span<const float64> Base, std::span<const float64> Coeffs);
+
+        ModeType                           Mode     = KeepAll;
+        uint64                             Capacity = 1;  // RingBuffer的容量
+        std::vector<float64>               Times;         // Decimate的输出时刻
+        std::function<StateCallbackType>   StateCallback;
+        std::function<SegmentCallbackType> SegmentCallback;
+
+        /**
+         * @brief 把采样点以文本形式逐行写入流，每行为"x y0 y1 ..."，流的生命周期由调用者保证
+         */
+        static OutputPolicy StreamToFile(std::ostream& File);
     };
 
 protected:
-    std::function<Fty>   Invoker;      // 原函数
-    enum StateCode       State;        // 当前状态
-    float64              EndPoint;     // 结束点
-    bool                 Direction;    // 求解方向，0表示正方向，1表示负方向
-    StateType            StateBuffer;  // 采样缓冲区
+    std::function<Fty>        Invoker;        // 原函数
+    std::function<InPlaceFty> InPlaceInvoker; // 原地形式的原函数，与Invoker二选一
+    enum StateCode            State;          // 当前状态
+    float64                   EndPoint;       // 结束点
+    bool                      Direction;      // 求解方向，0表示正方向，1表示负方向
+    StateType                 StateBuffer;    // 采样缓冲区
+    OutputPolicy              Output;         // 输出策略
+    uint64                    NextOutput = 0; // Decimate模式下下一个待输出的时刻
+    float64                   LastPoint  = __Float64::FromBytes(BIG_NAN_DOUBLE); // 最后一个采样点
+    float64                   PrevLastPoint = __Float64::FromBytes(BIG_NAN_DOUBLE); // 倒数第二个采样点
 
     virtual int Run() = 0;
 
+    /**
+     * @brief 计算右端函数并写入Out，优先使用原地形式
+     */
+    void Evaluate(float64 x, std::span<const float64> y, std::span<float64> Out)const;
+
+    /**
+     * @brief 在最近接受的一步内插值，供Decimate模式使用，x位于PrevPoint和CurrentPoint之间
+     */
+    virtual void InterpolateStep(float64 x, std::span<float64> Out);
+
+    /**
+     * @brief 记录初值，须在EndPoint和Direction确定之后调用
+     */
+    void BeginRecord(float64 x, std::span<const float64> y);
+
+    /**
+     * @brief 按输出策略记录一个已接受的采样点
+     */
+    void Record(float64 x, std::span<const float64> y);
+
+    /**
+     * @brief 写入和读取快照中属于本类的部分，派生类重写时须先调用基类的版本
+     */
+    virtual void SaveState(std::ostream& Out)const;
+    virtual void LoadState(std::istream& In);
+
 public:
     OrdinaryDifferentialEquation() {}
     OrdinaryDifferentialEquation(std::function<Fty> Right) : Invoker(Right) {}
+    OrdinaryDifferentialEquation(std::function<InPlaceFty> Right) : InPlaceInvoker(Right) {}
 
-    float64 CurrentPoint()const;
-    float64 PrevPoint()const;
+    float64 CurrentPoint()const {return LastPoint;}
+    float64 PrevPoint()const {return PrevLastPoint;}
     StateType Solutions()const {return StateBuffer;}
+    void SetOutputPolicy(OutputPolicy Policy) {Output = std::move(Policy);}
+    const OutputPolicy& GetOutputPolicy()const {return Output;}
     enum StateCode CurrentState()const {return State;}
     constexpr float64 size()const {return abs(CurrentPoint() - PrevPoint());}
 
@@ -1034,14 +1950,91 @@ public:
     void __cdecl InvokeRun() noexcept(0);
     virtual void SaveDenseOutput() = 0;
 
+    /**
+     * @brief 将求解器的全部状态(当前解、步长控制、工作空间、采样和稠密输出)写入二进制快照，
+     * 用于长时间积分的断点续算。快照由Restore读回后，继续求解的结果与未中断时逐位相同。
+     * @details 右端函数、雅可比矩阵、事件函数和输出策略的回调不写入快照，恢复时须先以相同的
+     * 函数和参数构造同类型的求解器(并添加相同的事件)，再调用Restore。数值按本机字节序写入，
+     * 快照只能在相同的平台上读取。流须以二进制模式打开。
+     * @example
+     *      std::ofstream Out("Orbit.ckpt", std::ios::binary);
+     *      Engine.Snapshot(Out);
+     *      ...
+     *      DormandPrinceODEEngine Resumed(Kepler, 6);
+     *      std::ifstream In("Orbit.ckpt", std::ios::binary);
+     *      Resumed.Restore(In);
+     *      while (Resumed.CurrentState() == Resumed.Processing) {Resumed.InvokeRun();}
+     */
+    void Snapshot(std::ostream& Out)const;
+
+    /**
+     * @brief 从Snapshot写入的快照恢复状态，求解器类型、方程个数或事件个数不一致时抛出异常。
+     * 抛出异常后求解器的状态不确定，须重新Init或Restore。
+     */
+    void Restore(std::istream& In);
+
     virtual ValueArray operator()(float64 x)const = 0;
 };
 
-/// @see __State_Vector_Planetary_Simulator
+/**
+ * @brief 固定步长辛积分器的基类，负责步长控制、采样记录和稠密输出
+ * @details 派生类只需实现单步推进Advance和求导Derivatives。最后一步会被截短以恰好落在终点上。
+ * 稠密输出由相邻两个采样点的值和导数做三次埃尔米特插值得到，精度为3阶，不影响积分本身的精度。
+ * @see __State_Vector_Planetary_Simulator
+ */
 class __Symplectic_Ordinary_Differential_Equation : public OrdinaryDifferentialEquation
 {
 public:
+    using SplitFty = InPlaceFty; // 拆分后的子系统，形如(t, q或p, 输出)
+
+protected:
+    float64    StepSize;  // 步长，取正值
+    float64    PrevT;     // 上一点
+    float64    CurrentT;  // 当前点
+    ValueArray PrevY;     // 上一点的解
+    ValueArray CurrentY;  // 当前解
+
+    /**
+     * @brief 以步长h推进一步，只更新CurrentY，CurrentT由调用者更新
+     */
+    virtual void Advance(float64 h) = 0;
+
+    /**
+     * @brief 计算状态向量的导数，仅用于稠密输出
+     */
+    virtual void Derivatives(float64 t, std::span<const float64> y, std::span<float64> Out)const = 0;
+
+    /**
+     * @brief 由两个采样点的值和导数做三次埃尔米特插值
+     */
+    void Hermite(float64 t0, std::span<const float64> y0, float64 t1, std::span<const float64> y1,
+        float64 x, std::span<float64> Out)const;
+
+    void InterpolateStep(float64 x, std::span<float64> Out)override;
+    void NextStep(); // 按步长推进一步并更新CurrentT
+    int Run()override;
+
+    void SaveState(std::ostream& Out)const override;
+    void LoadState(std::istream& In)override;
+
+public:
+    __Symplectic_Ordinary_Differential_Equation(float64 StepSize);
+
     virtual int SymplecticOrder()const = 0;
+
+    void Init(ValueArray InitState, float64 First, float64 Last)override;
+    void Clear()override;
+    void SaveDenseOutput()override {} // 插值直接由采样点计算，无需额外保存
+
+    /**
+     * @brief 推进一步但不把解记录到采样缓冲区，用法同RungeKuttaODEEngine::Step
+     */
+    StateCode Step();
+
+    float64 CurrentTime()const {return CurrentT;}
+    std::span<const float64> CurrentValue()const {return CurrentY;}
+
+    ValueArray operator()(float64 _Xx)const override;
 };
 
 extern const uint64  __RK23_C_Table[3];
@@ -1054,51 +2047,183 @@ extern const float64 __RK45_A_Table[30];
 extern const float64 __RK45_B_Table[6];
 extern const float64 __RK45_E_Table[7];
 extern const float64 __RK45_P_Table[28];
-#if 0
-extern const __float128 __DOP853_C_Table[16];
-extern const __float128 __DOP853_AB_Table[256];
-extern const __float128 __DOP853_E3_Table_Offset[6];
-extern const __float128 __DOP853_E5_Table[13];
-extern const __float128 __DOP853_D_Table[64];
-#endif
+extern const float64 __DOP853_C_Table[16];
+extern const float64 __DOP853_AB_Table[256];
+extern const float64 __DOP853_E3_Table[13];
+extern const float64 __DOP853_E5_Table[13];
+extern const float64 __DOP853_D_Table[64];
 
-class RungeKuttaODEEngine : public OrdinaryDifferentialEquation
+/**
+ * @brief 带稠密输出的单步法的基类，负责步进、采样记录和稠密输出段的存储与查找
+ * @details 派生类实现Advance(推进一步，更新PrevT, CurrentT, PrevY, CurrentY)和BuildSegment(由
+ * 最近一步计算插值系数)。稠密输出统一表示为 y = Base + h * Σ Q[k] * s^(k + 1)，其中
+ * s = (x - Start) / h，h = End - Start，Base为该段起点的解。
+ *
+ * 可以添加事件函数g(t, y)，每步结束后检查其符号是否改变，若改变则在该步的插值多项式上用
+ * 布伦特法求出g = 0的时刻，不需要额外计算右端函数(DOP853的插值本身需要3次额外的求值，
+ * 只在发生事件的步中计算)。终止事件发生时，最后一步截短到事件时刻，状态变为Terminated。
+ * @example 自由落体落地时停止：
+ *      RungeKutta4thOrderODEEngine Engine(Fall, 2);
+ *      Engine.AddEvent({[](float64 t, std::span<const float64> y){return y[0];}, -1, true});
+ *      Engine.Init({100, 0}, 0, 1000);
+ *      while (Engine.CurrentState() == Engine.Processing) {Engine.InvokeRun();}
+ *      float64 ImpactTime = Engine.Events().back().Time;
+ */
+class __Dense_Ordinary_Differential_Equation : public OrdinaryDifferentialEquation
 {
 public:
     using Mybase     = OrdinaryDifferentialEquation;
     using ValueArray = Mybase::ValueArray;
-    using StateType  = DynamicMatrix<float64>;
 
-    struct DenseOutput : public Mybase::DenseOutput
+    struct EventType
     {
-        using _Mybase  = Mybase::DenseOutput;
-        using QTblType = DynamicMatrix<float64>;
+        using Fty = float64(float64 t, std::span<const float64> y);
 
-        uint64     DenseOutputOrder;
-        QTblType   QTable;
-        ValueArray Base;
+        std::function<Fty> Function;
+        int                Direction = 0;     // 0为任意方向，1只检测由负变正，-1只检测由正变负
+        bool               Terminal  = false; // 发生时是否停止求解
+    };
 
-        DenseOutput() {}
-        DenseOutput(uint64 DenseOutputOrder, float64 First, float64 Last,
-            ValueArray BaseValue, QTblType QTbl)
-            : DenseOutputOrder(DenseOutputOrder), _Mybase(First, Last),
-            Base(BaseValue), QTable(QTbl) {}
+    struct EventRecord
+    {
+        uint64     Index; // 事件在添加顺序中的序号
+        float64    Time;
+        ValueArray State;
+    };
+
+protected:
+    uint64   DenseOutputOrder;
+    uint64   EquationCount;
 
-        ValueArray operator()(float64 _Xx)const override;
+    // 稠密输出按求解顺序平铺存储，第i段覆盖[SegmentStarts[i], SegmentEnds[i]]。
+    // Base按[段][分量]排列，Q按[段][分量][阶]排列，使每个分量的系数连续以便用霍纳法求值
+    std::vector<float64> SegmentStarts;
+    std::vector<float64> SegmentEnds;
+    std::vector<float64> SegmentBase;
+    std::vector<float64> SegmentCoeffs;
+    uint64               SegmentHead = 0; // 容量有限时按环形缓冲区存放，此为最早一段的位置
 
-        friend struct RungeKuttaODEEngine;
-    };
+    float64    PrevT, CurrentT;
+    ValueArray PrevY, CurrentY;
+
+    ValueArray StepCoeffs;      // 当前步的插值系数，供InterpolateStep使用
+    float64    StepCoeffsPoint; // StepCoeffs对应的步的终点
+
+    std::vector<EventType>   EventList;
+    ValueArray               EventValues; // 各事件函数在CurrentT处的值
+    std::vector<EventRecord> EventLog;
+
+    __Dense_Ordinary_Differential_Equation(std::function<Fty> Right,
+        uint64 DenseOutputOrder, uint64 EquationCount) : Mybase(Right),
+        DenseOutputOrder(DenseOutputOrder), EquationCount(EquationCount) {}
+
+    __Dense_Ordinary_Differential_Equation(std::function<InPlaceFty> Right,
+        uint64 DenseOutputOrder, uint64 EquationCount) : Mybase(Right),
+        DenseOutputOrder(DenseOutputOrder), EquationCount(EquationCount) {}
+
+    /**
+     * @brief 设置区间和初值，分配公共的工作空间并记录初值
+     */
+    void BeginIntegration(const ValueArray& InitState, float64 First, float64 Last);
+
+    /**
+     * @brief 根据初值处的导数估计初始步长(Hairer, Norsett, Wanner, 1993, II.4)，须在BeginIntegration之后调用
+     * @param f0 初值处的导数
+     * @param ErrorOrder 误差估计的阶数
+     */
+    float64 SelectInitialStep(std::span<const float64> f0, float64 ErrorOrder,
+        float64 RelToler, float64 AbsToler)const;
+
+    virtual int Advance() = 0; // 推进一步，只更新工作空间
+    int Run()override;
+
+    /**
+     * @brief 检查最近一步内发生的事件并按时间顺序记录，遇到终止事件时把该步截短到事件时刻
+     * @return 是否发生了终止事件
+     */
+    bool LocateEvents();
+
+    using Mybase::Evaluate;
+
+    /**
+     * @brief 由当前步计算插值系数，第j个分量的第k阶系数写入Q[j * DenseOutputOrder + k]
+     */
+    virtual void BuildSegment(float64* Q) = 0;
+
+    void InterpolateStep(float64 x, std::span<float64> Out)override;
+
+    /**
+     * @brief 以[PrevT, CurrentT]为区间追加一段稠密输出，容量由输出策略决定，满时覆盖最早的一段
+     * @return 新段系数的起始地址
+     */
+    float64* AppendSegment();
+
+    uint64 SegmentSlot(uint64 Index)const; // 第Index段在存储中的位置
+
+    /**
+     * @brief 查找包含x的段，从Hint处开始倍增搜索，连续查找相近的点时接近常数时间
+     * @param Hint 起始段，超出范围时退化为二分查找
+     */
+    uint64 FindSegment(float64 x, uint64 Hint)const;
+
+    void EvaluateSegment(uint64 Index, float64 x, float64* Out)const;
+
+    void SaveState(std::ostream& Out)const override;
+    void LoadState(std::istream& In)override;
+
+public:
+    void Clear()override;
+    void SaveDenseOutput()override;
+
+    /**
+     * @brief 推进一步但不把解记录到采样缓冲区，Init之后的反复调用不会分配内存。
+     * 当前的解通过CurrentTime和CurrentValue读取。
+     * @return 推进后的状态
+     */
+    StateCode Step();
+
+    float64 CurrentTime()const {return CurrentT;}
+    std::span<const float64> CurrentValue()const {return CurrentY;}
+
+    uint64 SegmentCount()const {return SegmentStarts.size();}
+
+    /**
+     * @brief 添加事件，须在Init之前调用。初值处恰好为0的事件函数不视为发生了事件。
+     */
+    void AddEvent(EventType Event) {EventList.push_back(std::move(Event));}
+    void ClearEvents() {EventList.clear();}
+    const std::vector<EventRecord>& Events()const {return EventLog;}
+
+    ValueArray operator()(float64 _Xx)const override;
+
+    /**
+     * @brief 批量计算稠密输出，时间点已排序时只需遍历一次分段
+     * @param Times 时间点，按求解方向排序时最快，乱序也能得到正确结果
+     * @param Output 输出，大小为Times.size() * EquationCount，第i个时间点的解位于
+     * [i * EquationCount, (i + 1) * EquationCount)
+     */
+    void Evaluate(std::span<const float64> Times, std::span<float64> Output)const;
+};
+
+class RungeKuttaODEEngine : public __Dense_Ordinary_Differential_Equation
+{
+public:
+    using Mybase     = __Dense_Ordinary_Differential_Equation;
+    using ValueArray = Mybase::ValueArray;
+    using StateType  = DynamicMatrix<float64>;
 
     constexpr static const float64 MinFactor  = 0.2;
     constexpr static const float64 MaxFactor  = 10.;
     constexpr static const float64 FactorSafe = 0.9;
 
+    float64        RelTolerNLog = 3;
+    float64        AbsTolerNLog = 6;
+    float64        MaxStep      = __Float64::FromBytes(POS_INF_DOUBLE);
+
 protected:
     uint32_t ErrorEsitmatorOrder;
     uint32_t StepTakenOrder;
     uint32_t NStages;
-    uint64   DenseOutputOrder;
-    uint64   EquationCount;
 
     const float64* CTable;
     const float64* ATable;
@@ -1106,80 +2231,896 @@ protected:
     const float64* ETable;
     const float64* PTable;
 
-    std::map<float64, DenseOutput> Interpolants;
+    uint64         ATableStride;  // A表每行的元素个数
+
+    // 工作空间，在Init中分配，此后的步进过程不再分配内存
+    ValueArray     NewY;
+    ValueArray     CurrentFx;
+    ValueArray     StageY;        // 各级的中间状态
+    ValueArray     ErrorScale;
+    StateType      KTable;        // 每一列为一级的导数，按列连续存放
+
+    float64        AbsStep;
+    const float64  ErrExponent  = ErrorEsitmatorOrder + 1;
+
+    float64 RMSNorm(std::vector<float64> Input);
+
+    void SetInitStep();
+
+    RungeKuttaODEEngine(std::function<Fty> Right,
+        uint32_t ErrorEsitmatorOrder, uint32_t StepTakenOrder, uint32_t NStages,
+        uint64 DenseOutputOrder, uint64 EquationCount) : Mybase(Right, DenseOutputOrder, EquationCount),
+        ErrorEsitmatorOrder(ErrorEsitmatorOrder), StepTakenOrder(StepTakenOrder), NStages(NStages),
+        CurrentFx(EquationCount), KTable({NStages + 1, EquationCount}) {}
+
+    RungeKuttaODEEngine(std::function<InPlaceFty> Right,
+        uint32_t ErrorEsitmatorOrder, uint32_t StepTakenOrder, uint32_t NStages,
+        uint64 DenseOutputOrder, uint64 EquationCount) : Mybase(Right, DenseOutputOrder, EquationCount),
+        ErrorEsitmatorOrder(ErrorEsitmatorOrder), StepTakenOrder(StepTakenOrder), NStages(NStages),
+        CurrentFx(EquationCount), KTable({NStages + 1, EquationCount}) {}
+
+    /**
+     * @brief 由KTable和ErrorScale计算误差的范数，小于1时接受此步
+     */
+    virtual float64 ErrorNorm(float64 h)const;
+
+    int Advance()override;
+    void BuildSegment(float64* Q)override;
+
+    void SaveState(std::ostream& Out)const override;
+    void LoadState(std::istream& In)override;
+
+public:
+    void Init(ValueArray InitState, float64 First, float64 Last)override;
+    virtual void Init(ValueArray InitState, float64 First, float64 Last, float64 InitStep);
+    void Clear()override;
+};
+
+typedef class RungeKutta2ndOrderODEEngine : public RungeKuttaODEEngine
+{
+public:
+    using Mybase = RungeKuttaODEEngine;
+
+protected:
+    void SetTables()
+    {
+        CTable = (float64*)__RK23_C_Table;
+        ATable = (float64*)__RK23_A_Table;
+        BTable = (float64*)__RK23_B_Table;
+        ETable = (float64*)__RK23_E_Table;
+        PTable = (float64*)__RK23_P_Table;
+        ATableStride = 3;
+    }
+
+public:
+    RungeKutta2ndOrderODEEngine(std::function<Fty> Function, uint64 EquationCount) :
+        Mybase(Function, 2, 3, 3, 3, EquationCount) {SetTables();}
+    RungeKutta2ndOrderODEEngine(std::function<InPlaceFty> Function, uint64 EquationCount) :
+        Mybase(Function, 2, 3, 3, 3, EquationCount) {SetTables();}
+
+    void Init(ValueArray InitState, float64 First, float64 Last,
+        float64 InitStep = __Float64::FromBytes(BIG_NAN_DOUBLE))override
+    {
+        Mybase::Init(InitState, First, Last, InitStep);
+    }
+}BogackiShampineODEEngine;
+
+typedef class RungeKutta4thOrderODEEngine : public RungeKuttaODEEngine
+{
+public:
+    using Mybase = RungeKuttaODEEngine;
+
+protected:
+    void SetTables()
+    {
+        CTable = __RK45_C_Table;
+        ATable = __RK45_A_Table;
+        BTable = __RK45_B_Table;
+        ETable = __RK45_E_Table;
+        PTable = __RK45_P_Table;
+        ATableStride = 5;
+    }
+
+public:
+    RungeKutta4thOrderODEEngine(std::function<Fty> Function, uint64 EquationCount) :
+        Mybase(Function, 4, 5, 6, 4, EquationCount) {SetTables();}
+    RungeKutta4thOrderODEEngine(std::function<InPlaceFty> Function, uint64 EquationCount) :
+        Mybase(Function, 4, 5, 6, 4, EquationCount) {SetTables();}
+
+    void Init(ValueArray InitState, float64 First, float64 Last,
+        float64 InitStep = __Float64::FromBytes(BIG_NAN_DOUBLE))override
+    {
+        Mybase::Init(InitState, First, Last, InitStep);
+    }
+}DormandPrinceODEEngine, RungeKuttaDPODEEngine, DOPRIODEEngine;
+
+/**
+ * @brief 8(5, 3)阶多尔芒-普林斯方法(DOP853)，译自SciPy。误差由5阶和3阶两个估计组合而成，
+ * 稠密输出为7阶，需要在每步额外计算3级。适用于1e-10至1e-13这样的高精度长时间积分，此时
+ * 所需步数比RK45少得多。默认容差与其他引擎相同，须在Init之前设置RelTolerNLog和AbsTolerNLog。
+ * @note 稠密输出在SaveDenseOutput中转换为与其他龙格-库塔方法相同的幂级数形式
+ */
+typedef class RungeKutta8thOrderODEEngine : public RungeKuttaODEEngine
+{
+public:
+    using Mybase = RungeKuttaODEEngine;
+
+protected:
+    ValueArray ExtraK; // 稠密输出的附加级，3 * EquationCount
+
+    float64 ErrorNorm(float64 h)const override;
+    void BuildSegment(float64* Q)override;
+
+    void SaveState(std::ostream& Out)const override;
+    void LoadState(std::istream& In)override;
+
+    void SetTables()
+    {
+        CTable = __DOP853_C_Table;
+        ATable = __DOP853_AB_Table;
+        BTable = __DOP853_AB_Table + 12 * 16;
+        ETable = __DOP853_E5_Table;
+        PTable = nullptr;
+        ATableStride = 16;
+    }
+
+public:
+    RungeKutta8thOrderODEEngine(std::function<Fty> Function, uint64 EquationCount) :
+        Mybase(Function, 7, 8, 12, 7, EquationCount) {SetTables();}
+    RungeKutta8thOrderODEEngine(std::function<InPlaceFty> Function, uint64 EquationCount) :
+        Mybase(Function, 7, 8, 12, 7, EquationCount) {SetTables();}
+
+    void Init(ValueArray InitState, float64 First, float64 Last,
+        float64 InitStep = __Float64::FromBytes(BIG_NAN_DOUBLE))override
+    {
+        ExtraK.resize(3 * EquationCount);
+        Mybase::Init(InitState, First, Last, InitStep);
+    }
+}DOP853ODEEngine;
+
+using DefaultODEEngine = RungeKutta4thOrderODEEngine;
+
+// ------------------------------------------------------------------------------------- //
+
+/**
+ * @brief 隐式(刚性)求解器的基类，负责雅可比矩阵的计算和保存
+ * @details 雅可比矩阵J的第i行第j列为∂f_i/∂y_j，存放在J.at(j, i)中，与JacobianEngine一致。
+ * 未提供解析雅可比矩阵时使用向前差分计算。雅可比矩阵和牛顿迭代矩阵的LU分解在步与步之间
+ * 尽量复用，只有在牛顿迭代收敛变慢或失败时才重新计算。
+ */
+class __Implicit_Ordinary_Differential_Equation : public __Dense_Ordinary_Differential_Equation
+{
+public:
+    using Mybase      = __Dense_Ordinary_Differential_Equation;
+    using JacobianFty = void(float64 t, std::span<const float64> y, DynamicMatrix<float64>& J);
+
+    constexpr static const float64 MinFactor = 0.2;
+    constexpr static const float64 MaxFactor = 10.;
+
+    float64 RelTolerNLog = 3; // 同时决定牛顿迭代的收敛阈值
+    float64 AbsTolerNLog = 6;
+    float64 MaxStep      = __Float64::FromBytes(POS_INF_DOUBLE);
+
+protected:
+    std::function<JacobianFty> JacobianFunction; // 解析雅可比矩阵，可选
+    DynamicMatrix<float64>     Jacobian;
+    ValueArray                 CurrentFx;
+    uint64                     JacobianCount      = 0;
+    uint64                     DecompositionCount = 0;
+
+    float64 AbsStep;
+    float64 NewtonToler;  // 牛顿迭代的收敛阈值，由相对误差决定
+
+    __Implicit_Ordinary_Differential_Equation(std::function<Fty> Right, std::function<JacobianFty> Jac,
+        uint64 DenseOutputOrder, uint64 EquationCount) : Mybase(Right, DenseOutputOrder, EquationCount),
+        JacobianFunction(Jac), Jacobian({EquationCount, EquationCount}) {}
+
+    __Implicit_Ordinary_Differential_Equation(std::function<InPlaceFty> Right, std::function<JacobianFty> Jac,
+        uint64 DenseOutputOrder, uint64 EquationCount) : Mybase(Right, DenseOutputOrder, EquationCount),
+        JacobianFunction(Jac), Jacobian({EquationCount, EquationCount}) {}
+
+    /**
+     * @brief 公共的初始化：记录初值、计算初值处的导数和雅可比矩阵、估计初始步长
+     */
+    void BeginImplicit(const ValueArray& InitState, float64 First, float64 Last, float64 ErrorOrder);
+
+    /**
+     * @brief 重新计算雅可比矩阵
+     * @param fx y处的导数，可选，用于减少差分的求值次数
+     */
+    void UpdateJacobian(float64 t, std::span<const float64> y, std::span<const float64> fx = {});
+
+    float64 RMSNorm(std::span<const float64> x, std::span<const float64> Scale)const;
+
+    void SaveState(std::ostream& Out)const override;
+    void LoadState(std::istream& In)override;
+
+public:
+    void Clear()override;
+
+    uint64 JacobianEvaluations()const {return JacobianCount;}
+    uint64 Decompositions()const {return DecompositionCount;}
+};
+
+/**
+ * @brief 5阶3级Radau IIA隐式龙格-库塔方法，译自SciPy。适用于刚性问题，L稳定。
+ * @details 每步求解3n维的非线性配置方程组，经变换后化为一个n维实线性方程组和一个n维复线性
+ * 方程组，分别使用固定的LU分解做简化牛顿迭代。误差估计为3阶，稠密输出为3阶。
+ * @example 范德波尔振子(μ = 1000)：
+ *      auto vdp = [](float64 t, std::span<const float64> y, std::span<float64> dy)
+ *      {
+ *          dy[0] = y[1];
+ *          dy[1] = 1000 * (1 - y[0] * y[0]) * y[1] - y[0];
+ *      };
+ *      RadauODEEngine Engine(vdp, 2);
+ *      Engine.Init({2, 0}, 0, 3000);
+ *      while (Engine.CurrentState() == Engine.Processing) {Engine.InvokeRun();}
+ */
+typedef class RadauIIAODEEngine : public __Implicit_Ordinary_Differential_Equation
+{
+public:
+    using Mybase = __Implicit_Ordinary_Differential_Equation;
+
+    constexpr static const uint64 NewtonMaxIter = 6;
+
+protected:
+    ValueArray                        LUReal;
+    std::vector<complex64>            LUComplex;
+    std::vector<uint64>               PivotsReal;
+    std::vector<uint64>               PivotsComplex;
+    bool                              LUValid         = false;
+    bool                              CurrentJacobian = true; // 雅可比矩阵是否在当前点计算
+    bool                              HasDenseOutput  = false;
+    float64                           AbsStepOld;   // 为NaN时表示没有
+    float64                           ErrorNormOld; // 为NaN时表示没有
+
+    // 工作空间，Z, W, F按[级][分量]排列
+    ValueArray             Z, Z0, W, DeltaW, F, Scale, NewY, NewFx, ErrorVec, Tmp;
+    std::vector<complex64> ComplexTmp;
+    ValueArray             DenseQ; // 最近一步的插值系数，按[分量][阶]排列，y = PrevY + Σ DenseQ[k] * s^(k + 1)
+
+    void Decompose(float64 h);
+    bool SolveCollocation(float64 t, float64 h, uint64& Iterations, float64& Rate);
+
+    int Advance()override;
+    void BuildSegment(float64* Q)override;
+
+    void SaveState(std::ostream& Out)const override;
+    void LoadState(std::istream& In)override;
+
+public:
+    RadauIIAODEEngine(std::function<Fty> Function, uint64 EquationCount,
+        std::function<JacobianFty> Jac = nullptr) : Mybase(Function, Jac, 3, EquationCount) {}
+    RadauIIAODEEngine(std::function<InPlaceFty> Function, uint64 EquationCount,
+        std::function<JacobianFty> Jac = nullptr) : Mybase(Function, Jac, 3, EquationCount) {}
+
+    void Init(ValueArray InitState, float64 First, float64 Last)override;
+}RadauODEEngine;
+
+/**
+ * @brief 1至5阶变阶变步长的后向差分公式(BDF)，使用准常步长的差分形式，译自SciPy。
+ * 适用于刚性问题，每步只需求解一个n维方程组，大规模刚性问题时通常比Radau更快。
+ * @details 解的历史以后向差分D存储，步长改变时对D做线性变换。阶数在连续若干步等步长之后
+ * 根据相邻阶的误差估计自动调整。稠密输出为当前阶数的插值多项式。
+ */
+typedef class BackwardDifferentiationODEEngine : public __Implicit_Ordinary_Differential_Equation
+{
+public:
+    using Mybase = __Implicit_Ordinary_Differential_Equation;
+
+    constexpr static const uint64 MaxOrder      = 5;
+    constexpr static const uint64 NewtonMaxIter = 4;
+
+protected:
+    ValueArray          Differences; // 后向差分，按[阶][分量]排列，共MaxOrder + 3行
+    uint64              Order      = 1;
+    uint64              EqualSteps = 0;
+    ValueArray          LU;
+    std::vector<uint64> Pivots;
+    bool                LUValid = false;
+
+    // 工作空间
+    ValueArray YPredict, Psi, Scale, NewY, Correction, Delta, F;
+    ValueArray DenseD;   // 最近一步的插值多项式，按[阶][分量]排列
+    uint64     DenseOrder;
+
+    void ChangeDifferences(uint64 Order, float64 Factor);
+    bool SolveSystem(float64 t, float64 c, uint64& Iterations);
+
+    int Advance()override;
+    void BuildSegment(float64* Q)override;
+
+    void SaveState(std::ostream& Out)const override;
+    void LoadState(std::istream& In)override;
+
+public:
+    BackwardDifferentiationODEEngine(std::function<Fty> Function, uint64 EquationCount,
+        std::function<JacobianFty> Jac = nullptr) : Mybase(Function, Jac, MaxOrder, EquationCount) {}
+    BackwardDifferentiationODEEngine(std::function<InPlaceFty> Function, uint64 EquationCount,
+        std::function<JacobianFty> Jac = nullptr) : Mybase(Function, Jac, MaxOrder, EquationCount) {}
+
+    void Init(ValueArray InitState, float64 First, float64 Last)override;
+
+    uint64 CurrentOrder()const {return Order;}
+}BDFODEEngine;
+
+/**
+ * @brief 变步长变阶(1至12阶)的亚当斯-巴什福思-莫尔顿预测-校正方法，以Nordsieck向量存储历史，
+ * 适用于右端函数计算代价高的光滑非刚性问题，如带高阶引力场或第三体摄动的轨道。
+ * @details 每步以Nordsieck向量的泰勒外推作为预测值(相当于亚当斯-巴什福思公式)，再做两次
+ * 亚当斯-莫尔顿校正(PECEC)，每步只需计算2次右端函数，而DormandPrinceODEEngine需要6次。
+ * 变步长时直接缩放Nordsieck向量，阶数和步长的调整方式与LSODE相同。
+ * 起步时用Dormand-Prince方法以等步长走3步，由4个导数值构造4阶的Nordsieck向量。
+ * 稠密输出直接取自Nordsieck向量表示的多项式，不需要额外计算。
+ * @note 此方法的稳定域较小，不适用于刚性问题，刚性问题请使用RadauODEEngine或BDFODEEngine
+ */
+class AdamsODEEngine : public __Dense_Ordinary_Differential_Equation
+{
+public:
+    using Mybase = __Dense_Ordinary_Differential_Equation;
+
+    constexpr static const uint64 MaxOrder     = 12;
+    constexpr static const uint64 StartupOrder = 4;
+
+    float64 RelTolerNLog = 3;
+    float64 AbsTolerNLog = 6;
+    float64 MaxStep      = __Float64::FromBytes(POS_INF_DOUBLE);
+
+protected:
+    ValueArray Nordsieck;      // 按[阶][分量]排列，第j行为h^j * y^(j) / j!，共MaxOrder + 2行
+    ValueArray Predicted;      // 预测的Nordsieck向量
+    ValueArray Correction;     // 本步的校正量
+    ValueArray PrevCorrection; // 上一步的校正量，用于估计升阶后的误差
+    ValueArray NewFx, Scale;
+    float64    StepSize;       // Nordsieck向量对应的步长，带符号
+    uint64     Order;
+    uint64     StepsAtOrder;   // 上次改变步长或阶数后的步数
+    float64    PendingEta;     // 下一步开始时对步长的缩放
+    uint64     PendingOrder;   // 下一步使用的阶数
+
+    // 起步阶段由龙格-库塔方法算出的点，以及对应的导数
+    ValueArray StartupT, StartupY, StartupFx;
+    float64    StartupStep;
+    uint64     StartupIndex;   // 已经返回的起步步数，起步完成后为StartupOrder
+
+    /**
+     * @brief 用Dormand-Prince方法以等步长走StartupOrder - 1步，并构造Nordsieck向量
+     * @return 步长过小无法满足精度时返回false
+     */
+    bool Startup();
+
+    /**
+     * @brief 步长变为Eta倍，第j行乘以Eta^j
+     */
+    void Rescale(float64 Eta);
+
+    int Advance()override;
+    void BuildSegment(float64* Q)override;
+
+    void SaveState(std::ostream& Out)const override;
+    void LoadState(std::istream& In)override;
+
+public:
+    AdamsODEEngine(std::function<Fty> Function, uint64 EquationCount)
+        : Mybase(Function, MaxOrder, EquationCount) {}
+    AdamsODEEngine(std::function<InPlaceFty> Function, uint64 EquationCount)
+        : Mybase(Function, MaxOrder, EquationCount) {}
+
+    void Init(ValueArray InitState, float64 First, float64 Last)override;
+    void Clear()override;
+
+    uint64 CurrentOrder()const {return Order;}
+};
+
+// ------------------------------------------------------------------------------------- //
+
+/**
+ * @brief 龙格-库塔系数表的编译期描述，供FixedRungeKuttaEngine使用，系数直接取自上面的表
+ */
+struct __RK23_Tableau
+{
+    static constexpr uint64 ErrorOrder = 2;
+    static constexpr uint64 Stages     = 3;
+    static constexpr uint64 DenseOrder = 3;
+    static constexpr uint64 AStride    = 3;
+    static const float64* C() {return (const float64*)__RK23_C_Table;}
+    static const float64* A() {return (const float64*)__RK23_A_Table;}
+    static const float64* B() {return (const float64*)__RK23_B_Table;}
+    static const float64* E() {return (const float64*)__RK23_E_Table;}
+    static const float64* P() {return (const float64*)__RK23_P_Table;}
+};
+
+struct __RK45_Tableau
+{
+    static constexpr uint64 ErrorOrder = 4;
+    static constexpr uint64 Stages     = 6;
+    static constexpr uint64 DenseOrder = 4;
+    static constexpr uint64 AStride    = 5;
+    static const float64* C() {return __RK45_C_Table;}
+    static const float64* A() {return __RK45_A_Table;}
+    static const float64* B() {return __RK45_B_Table;}
+    static const float64* E() {return __RK45_E_Table;}
+    static const float64* P() {return __RK45_P_Table;}
+};
+
+/**
+ * @brief 定长的龙格-库塔引擎，适用于方程个数在编译期已知的小型方程组(如6维轨道、12维姿态、
+ * 42维的状态与状态转移矩阵)。状态保存在std::array中，级数和方程个数都是编译期常量，各级的
+ * 线性组合为定长循环，便于编译器展开和向量化。算法与RungeKuttaODEEngine相同，但不记录历史，
+ * 只保留最近一步的稠密输出。
+ * @tparam N 方程个数
+ * @tparam Tableau 系数表，可选__RK23_Tableau和__RK45_Tableau
+ * @tparam _Func 右端函数的类型，传入具体的函数对象类型(如lambda)时可以被内联
+ * @example
+ *      auto Kepler = [](float64 t, const std::array<float64, 6>& y, std::array<float64, 6>& f)
+ *      {
+ *          float64 r3 = pow(y[0] * y[0] + y[1] * y[1] + y[2] * y[2], 1.5);
+ *          f = {y[3], y[4], y[5], -y[0] / r3, -y[1] / r3, -y[2] / r3};
+ *      };
+ *      FixedRungeKuttaEngine<6, __RK45_Tableau, decltype(Kepler)> Engine(Kepler);
+ *      Engine.Init({1, 0, 0, 0, 1, 0}, 0, 100);
+ *      while (Engine.Step() == Engine.Processing) {...}
+ */
+template<std::size_t N, typename Tableau = __RK45_Tableau,
+    typename _Func = std::function<void(float64, const std::array<float64, N>&, std::array<float64, N>&)>>
+class FixedRungeKuttaEngine
+{
+public:
+    using StateType = std::array<float64, N>;
+    using StateCode = OrdinaryDifferentialEquation::StateCode;
+    static constexpr StateCode Processing = OrdinaryDifferentialEquation::Processing;
+    static constexpr StateCode Succeeded  = OrdinaryDifferentialEquation::Succeeded;
+    static constexpr StateCode Failed     = OrdinaryDifferentialEquation::Failed;
+
+    static constexpr uint64  Stages      = Tableau::Stages;
+    static constexpr float64 ErrExponent = Tableau::ErrorOrder + 1;
+
+protected:
+    _Func     Function;
+    StateCode State = Succeeded;
+    float64   EndPoint, Direction;
+    float64   PrevT, CurrentT, AbsStep;
+    StateType PrevY, CurrentY, NewY, CurrentFx, StageY;
+    std::array<StateType, Stages + 1> K; // 各级导数
+
+    // 误差估计的加权均方根
+    float64 ErrorNorm(const StateType& y, const StateType& yNew, float64 h)const
+    {
+        const float64* E = Tableau::E();
+        float64 RelToler = pow(10, -RelTolerNLog), AbsToler = pow(10, -AbsTolerNLog);
+        float64 Sum = 0;
+        for (std::size_t j = 0; j < N; ++j)
+        {
+            float64 Error = 0;
+            for (std::size_t k = 0; k <= Stages; ++k) {Error += K[k][j] * E[k];}
+            Sum += pow(Error * h / (AbsToler + max(abs(y[j]), abs(yNew[j])) * RelToler), 2);
+        }
+        return sqrt(Sum / float64(N));
+    }
+
+    // 初始步长，与RungeKuttaODEEngine::SetInitStep相同
+    float64 InitialStep()
+    {
+        float64 RelToler = pow(10, -RelTolerNLog), AbsToler = pow(10, -AbsTolerNLog);
+        StateType Scale, y1, f1;
+        float64 d0 = 0, d1 = 0, d2 = 0;
+        for (std::size_t j = 0; j < N; ++j)
+        {
+            Scale[j] = AbsToler + abs(CurrentY[j]) * RelToler;
+            d0 += pow(CurrentY[j] / Scale[j], 2);
+            d1 += pow(CurrentFx[j] / Scale[j], 2);
+        }
+        d0 = sqrt(d0 / N);
+        d1 = sqrt(d1 / N);
+        float64 h0 = (d0 < 1E-5 || d1 < 1E-5) ? 1E-6 : 0.01 * d0 / d1;
+        for (std::size_t j = 0; j < N; ++j) {y1[j] = CurrentY[j] + h0 * Direction * CurrentFx[j];}
+        Function(CurrentT + h0 * Direction, y1, f1);
+        for (std::size_t j = 0; j < N; ++j) {d2 += pow((f1[j] - CurrentFx[j]) / Scale[j], 2);}
+        d2 = sqrt(d2 / N) / h0;
+        float64 h1 = (d1 <= 1E-15 && d2 <= 1E-15) ? max(1E-6, h0 * 1E-3) :
+            pow(0.01 / max(d1, d2), 1. / ErrExponent);
+        return min(100 * h0, h1);
+    }
+
+public:
+    float64 RelTolerNLog = 3;
+    float64 AbsTolerNLog = 6;
+    float64 MaxStep      = __Float64::FromBytes(POS_INF_DOUBLE);
+
+    FixedRungeKuttaEngine(_Func Func) : Function(std::move(Func)) {}
+
+    void Init(const StateType& InitState, float64 First, float64 Last,
+        float64 InitStep = __Float64::FromBytes(BIG_NAN_DOUBLE))
+    {
+        PrevT = CurrentT = First;
+        EndPoint = Last;
+        Direction = Last < First ? -1 : 1;
+        PrevY = CurrentY = InitState;
+        Function(First, CurrentY, CurrentFx);
+        State = Processing;
+        AbsStep = isnan(InitStep) ? InitialStep() : InitStep;
+    }
+
+    /**
+     * @brief 推进一步，不分配内存
+     * @return 推进后的状态
+     */
+    StateCode Step()
+    {
+        if (State != Processing) {throw std::logic_error("Engine is finished.");}
+        if (CurrentT == EndPoint)
+        {
+            State = Succeeded;
+            return State;
+        }
+
+        const float64 *C = Tableau::C(), *A = Tableau::A(), *B = Tableau::B();
+        float64 t = CurrentT;
+        float64 MinStep = 10. * abs(nextafter(t, Direction * std::numeric_limits<float64>::infinity()) - t);
+        float64 AbsH = AbsStep > MaxStep ? MaxStep : (AbsStep < MinStep ? MinStep : AbsStep);
+        bool Reject = 0;
+
+        while (true)
+        {
+            if (AbsH < MinStep)
+            {
+                State = Failed;
+                return State;
+            }
+            float64 NextT = t + Direction * AbsH;
+            if (Direction * (NextT - EndPoint) > 0) {NextT = EndPoint;}
+            float64 h = NextT - t;
+
+            K[0] = CurrentFx;
+            for (std::size_t i = 1; i < Stages; ++i)
+            {
+                StageY = CurrentY;
+                for (std::size_t k = 0; k < i; ++k)
+                {
+                    float64 a = h * A[i * Tableau::AStride + k];
+                    for (std::size_t j = 0; j < N; ++j) {StageY[j] += a * K[k][j];}
+                }
+                Function(t + C[i] * h, StageY, K[i]);
+            }
+            NewY = CurrentY;
+            for (std::size_t k = 0; k < Stages; ++k)
+            {
+                float64 b = h * B[k];
+                for (std::size_t j = 0; j < N; ++j) {NewY[j] += b * K[k][j];}
+            }
+            Function(t + h, NewY, K[Stages]);
+
+            float64 Error = ErrorNorm(CurrentY, NewY, h);
+            if (Error < 1)
+            {
+                float64 Factor = Error == 0 ? RungeKuttaODEEngine::MaxFactor :
+                    min(RungeKuttaODEEngine::MaxFactor, RungeKuttaODEEngine::FactorSafe * pow(Error, -1. / ErrExponent));
+                if (Reject) {Factor = min(1., Factor);}
+                AbsStep = AbsH * Factor;
+                PrevT = t;
+                CurrentT = NextT;
+                PrevY = CurrentY;
+                CurrentY = NewY;
+                CurrentFx = K[Stages];
+                if (CurrentT == EndPoint) {State = Succeeded;}
+                return State;
+            }
+            AbsH *= max(RungeKuttaODEEngine::MinFactor, RungeKuttaODEEngine::FactorSafe * pow(Error, -1. / ErrExponent));
+            Reject = 1;
+        }
+    }
+
+    /**
+     * @brief 一直推进到终点
+     */
+    StateCode Run()
+    {
+        while (State == Processing) {Step();}
+        return State;
+    }
+
+    StateCode CurrentState()const {return State;}
+    float64 CurrentTime()const {return CurrentT;}
+    float64 PrevTime()const {return PrevT;}
+    const StateType& CurrentValue()const {return CurrentY;}
+
+    /**
+     * @brief 最近一步内的稠密输出，x应位于PrevTime和CurrentTime之间
+     */
+    StateType operator()(float64 x)const
+    {
+        const float64* P = Tableau::P();
+        float64 h = CurrentT - PrevT;
+        float64 s = h ? (x - PrevT) / h : 0;
+        StateType Result = PrevY;
+        float64 Power = s * h;
+        for (std::size_t i = 0; i < Tableau::DenseOrder; ++i, Power *= s)
+        {
+            for (std::size_t k = 0; k <= Stages; ++k)
+            {
+                float64 q = Power * P[k * Tableau::DenseOrder + i];
+                for (std::size_t j = 0; j < N; ++j) {Result[j] += q * K[k][j];}
+            }
+        }
+        return Result;
+    }
+};
+
+// ------------------------------------------------------------------------------------- //
+
+/**
+ * @brief 可分离哈密顿系统H(q, p) = T(p) + V(q)的辛积分器
+ * @details 状态向量的前半部分为广义坐标q，后半部分为广义动量(或速度)p。漂移函数由p计算
+ * dq/dt = ∂T/∂p，踢动函数由q计算dp/dt = -∂V/∂q。每一步由若干次漂移和踢动交替组成，系数
+ * 由蛙跳法按吉田的方法组合而成。辛积分器的能量误差有界而不随时间累积，适用于长时间的轨道积分。
+ * 支持以下格式：
+ *  - Leapfrog：蛙跳(Störmer-Verlet)法，2阶，每步1次踢动
+ *  - ForestRuth：Forest-Ruth法，4阶，每步3次踢动，与吉田的三重跳跃4阶格式相同
+ *  - Yoshida6：吉田6阶格式(解A)，每步7次踢动
+ *  - Yoshida8：吉田8阶格式(解D)，每步15次踢动
+ * @example 谐振子：
+ *      auto Drift = [](float64 t, std::span<const float64> p, std::span<float64> dq) {dq[0] = p[0];};
+ *      auto Kick = [](float64 t, std::span<const float64> q, std::span<float64> dp) {dp[0] = -q[0];};
+ *      SymplecticODEEngine Engine(Drift, Kick, 1, 0.01, SymplecticODEEngine::Yoshida6);
+ *      Engine.Init({1, 0}, 0, 1000);
+ *      while (Engine.CurrentState() == Engine.Processing) {Engine.InvokeRun();}
+ */
+class SymplecticODEEngine : public __Symplectic_Ordinary_Differential_Equation
+{
+public:
+    using Mybase = __Symplectic_Ordinary_Differential_Equation;
+
+    enum SchemeType
+    {
+        Leapfrog,
+        ForestRuth,
+        Yoshida4 = ForestRuth,
+        Yoshida6,
+        Yoshida8
+    };
+
+protected:
+    std::function<SplitFty> Drift;       // dq/dt = f(t, p)
+    std::function<SplitFty> Kick;        // dp/dt = g(t, q)
+    uint64                  Dimensions;  // 坐标个数，状态向量长度为其2倍
+    SchemeType              Scheme;
+    ValueArray              DriftCoeffs; // 比KickCoeffs多一项
+    ValueArray              KickCoeffs;
+    ValueArray              Increment;   // 工作空间
+
+    void Advance(float64 h)override;
+    void Derivatives(float64 t, std::span<const float64> y, std::span<float64> Out)const override;
+
+    void SaveState(std::ostream& Out)const override;
+    void LoadState(std::istream& In)override;
+
+public:
+    SymplecticODEEngine(std::function<SplitFty> DriftFunc, std::function<SplitFty> KickFunc,
+        uint64 Dimensions, float64 StepSize, SchemeType Scheme = ForestRuth);
+
+    int SymplecticOrder()const override;
+    void Init(ValueArray InitState, float64 First, float64 Last)override;
+};
+
+/**
+ * @brief 维斯多姆-霍尔曼(Wisdom-Holman)混合变量辛映射，用于近开普勒的N体系统
+ * @details 将哈密顿量拆分为开普勒部分和相互作用部分，开普勒部分用普适变量的f和g函数精确
+ * 求解，相互作用部分以"踢-漂-踢"的形式施加，2阶。由于开普勒运动被精确积分，步长取最短轨道
+ * 周期的几十分之一即可。
+ * 状态向量的前3N个分量为N个天体的位置，后3N个为速度。坐标系(雅可比坐标或日心坐标)由调用者
+ * 选定，GravParams为每个天体开普勒问题的引力参数μ，Perturbation由全部位置计算该坐标系下
+ * 相互作用部分的加速度。每步只计算一次相互作用，上一步末尾的加速度会留到下一步使用。
+ */
+class WisdomHolmanEngine : public __Symplectic_Ordinary_Differential_Equation
+{
+public:
+    using Mybase = __Symplectic_Ordinary_Differential_Equation;
+
+protected:
+    std::function<SplitFty> Perturbation;
+    ValueArray              GravParams;
+    uint64                  BodyCount;
+    ValueArray              Acceleration; // 当前位置处的相互作用加速度
 
-    ValueArray     CurrentFx;
-    StateType      KTable;
+    void Advance(float64 h)override;
+    void Derivatives(float64 t, std::span<const float64> y, std::span<float64> Out)const override;
 
-    float64        RelTolerNLog = 3;
-    float64        AbsTolerNLog = 6;
-    float64        MaxStep      = __Float64::FromBytes(POS_INF_DOUBLE);
-    float64        AbsStep;
-    const float64  ErrExponent  = ErrorEsitmatorOrder + 1;
+    void SaveState(std::ostream& Out)const override;
+    void LoadState(std::istream& In)override;
 
-    float64 RMSNorm(std::vector<float64> Input);
+public:
+    WisdomHolmanEngine(std::function<SplitFty> Perturbation, ValueArray GravParams, float64 StepSize);
 
-    void SetInitStep();
+    /**
+     * @brief 用普适变量求解二体问题，将位置和速度沿开普勒轨道推进dt，椭圆和双曲轨道均适用
+     * @param GravParam 引力参数μ
+     * @param Position 位置，3个分量
+     * @param Velocity 速度，3个分量
+     * @param dt 时间间隔
+     */
+    static void KeplerDrift(float64 GravParam, float64* Position, float64* Velocity, float64 dt);
 
-    RungeKuttaODEEngine(std::function<Fty> Right,
-        uint32_t ErrorEsitmatorOrder, uint32_t StepTakenOrder, uint32_t NStages,
-        uint64 DenseOutputOrder, uint64 EquationCount) : Mybase(Right),
-        ErrorEsitmatorOrder(ErrorEsitmatorOrder), StepTakenOrder(StepTakenOrder), NStages(NStages),
-        DenseOutputOrder(DenseOutputOrder), EquationCount(EquationCount),
-        CurrentFx(EquationCount), KTable({NStages + 1, EquationCount}) {}
+    int SymplecticOrder()const override {return 2;}
+    void Init(ValueArray InitState, float64 First, float64 Last)override;
+};
 
-    int Run()override;
+// ------------------------------------------------------------------------------------- //
 
+/**
+ * @brief 系综常微分方程求解器，以同一个右端函数从大量初值同时积分，用于蒙特卡洛散布分析、
+ * 碎片云演化等问题
+ * @details 采用RK45(多尔芒-普林斯)方法，每个成员独立地控制步长，步长控制策略与
+ * RungeKutta4thOrderODEEngine相同。成员按BlockSize分组，组间并行；组内以结构数组的形式
+ * 存放，所有成员同步地逐级求值，右端函数每次收到一整组成员，对成员的循环是连续的，便于编译器
+ * 向量化。到达终点或失败的成员会被移出所在的组，不再参与计算。
+ * 批量右端函数的参数：
+ *  - Times：各成员的时刻，其长度即本次调用的成员数m
+ *  - States：各成员的解，第i个成员的第j个分量位于[j * m + i]
+ *  - Derivatives：导数，排列方式同States
+ * @example 10000个谐振子：
+ *      auto F = [](std::span<const float64> t, std::span<const float64> y, std::span<float64> dy)
+ *      {
+ *          uint64 m = t.size();
+ *          for (uint64 i = 0; i < m; ++i)
+ *          {
+ *              dy[i] = y[m + i];
+ *              dy[m + i] = -y[i];
+ *          }
+ *      };
+ *      EnsembleODEEngine Engine(F, 2);
+ *      Engine.Threads = 0;
+ *      Engine.Init(InitStates, 10000, 0, 100); // InitStates同样按[j * 10000 + i]排列
+ *      Engine.Run();
+ *      auto y = Engine.Solution(42);
+ */
+class EnsembleODEEngine
+{
 public:
-    void Init(ValueArray InitState, float64 First, float64 Last)override;
-    virtual void Init(ValueArray InitState, float64 First, float64 Last, float64 InitStep);
-    void Clear()override;
-    void SaveDenseOutput()override;
+    using BatchFty   = void(std::span<const float64> Times, std::span<const float64> States,
+        std::span<float64> Derivatives);
+    using InPlaceFty = OrdinaryDifferentialEquation::InPlaceFty;
+    using ValueArray = std::vector<float64>;
+    using StateCode  = OrdinaryDifferentialEquation::StateCode;
 
-    ValueArray operator()(float64 _Xx)const override;
+    constexpr static const float64 MinFactor  = RungeKuttaODEEngine::MinFactor;
+    constexpr static const float64 MaxFactor  = RungeKuttaODEEngine::MaxFactor;
+    constexpr static const float64 FactorSafe = RungeKuttaODEEngine::FactorSafe;
+
+protected:
+    std::function<BatchFty> Function;
+    uint64                  EquationCount;
+    uint64                  MemberCount = 0;
+    float64                 FirstPoint;
+    float64                 EndPoint;
+    ValueArray              States;       // 第i个成员的第j个分量位于[j * MemberCount + i]
+    ValueArray              Times;        // 各成员的当前时刻
+    std::vector<StateCode>  MemberStates; // 各成员的状态
+    std::vector<uint64>     StepCounts;   // 各成员接受的步数
+
+    void RunBlock(uint64 Begin, uint64 End);
+
+public:
+    float64 RelTolerNLog = 3;
+    float64 AbsTolerNLog = 6;
+    float64 MaxStep      = __Float64::FromBytes(POS_INF_DOUBLE);
+    uint64  BlockSize    = 256; // 每组的成员数
+    uint64  Threads      = 1;   // 线程数，为0时使用硬件支持的线程数
+
+    EnsembleODEEngine(std::function<BatchFty> Func, uint64 EquationCount)
+        : Function(Func), EquationCount(EquationCount) {}
+
+    /**
+     * @brief 由单个成员的右端函数构造，批量求值时逐个成员调用
+     */
+    EnsembleODEEngine(std::function<InPlaceFty> Func, uint64 EquationCount);
+
+    /**
+     * @param InitStates 初值，第i个成员的第j个分量位于[j * MemberCount + i]
+     * @param MemberCount 成员数
+     * @param First 积分起点
+     * @param Last 积分终点
+     */
+    void Init(std::span<const float64> InitStates, uint64 MemberCount, float64 First, float64 Last);
+
+    /**
+     * @brief 把全部成员积分到终点
+     */
+    void Run();
+
+    uint64 size()const {return MemberCount;}
+    std::span<const float64> Solutions()const {return States;}
+    ValueArray Solution(uint64 Member)const;
+    float64 CurrentPoint(uint64 Member)const {return Times[Member];}
+    StateCode CurrentState(uint64 Member)const {return MemberStates[Member];}
+    uint64 StepCount(uint64 Member)const {return StepCounts[Member];}
 };
 
-typedef class RungeKutta2ndOrderODEEngine : public RungeKuttaODEEngine
+// ------------------------------------------------------------------------------------- //
+
+/**
+ * @brief Parareal时间并行求解器，把积分区间等分为若干段，用廉价的粗求解器串行地传播各段的
+ * 初值，用精确的细求解器并行地积分各段，反复修正直到各段的初值收敛。
+ * @details 第k次迭代的修正公式为
+ *      U[i+1] = G(U[i]) + F(U_old[i]) - G(U_old[i])
+ * 其中G为粗求解器，F为细求解器。第k次迭代后前k段的结果已与串行的细求解完全相同，因此最多迭代
+ * Slices次。迭代K次的理论加速比约为Slices / K(忽略粗求解的时间)，粗求解器越接近细求解器，
+ * 所需的迭代次数越少。求解器由工厂函数创建，每个线程各持有一个细求解器，求解器内部的采样只保留
+ * 最后一点。收敛判据为相邻两次迭代中各段初值变化的均方根范数(按RelTolerNLog和AbsTolerNLog
+ * 缩放)小于1，此容差应比细求解器本身的容差宽松。
+ * @example 用容差为1e-5的RK45作为粗求解器，容差为1e-10的DOP853作为细求解器(粗求解器过于
+ * 粗糙时，长时间的轨道积分可能不收敛)：
+ *      PararealODESolver Solver(
+ *          [&]
+ *          {
+ *              auto Coarse = std::make_unique<RungeKutta4thOrderODEEngine>(Func, 4);
+ *              Coarse->RelTolerNLog = 5;
+ *              Coarse->AbsTolerNLog = 5;
+ *              return Coarse;
+ *          },
+ *          [&]
+ *          {
+ *              auto Fine = std::make_unique<DOP853ODEEngine>(Func, 4);
+ *              Fine->RelTolerNLog = 10;
+ *              Fine->AbsTolerNLog = 10;
+ *              return Fine;
+ *          });
+ *      Solver.Slices = 16;
+ *      Solver.Run(InitState, 0, 3E4);
+ *      auto y = Solver.FinalState();
+ *      auto Speedup = Solver.Speedup();
+ */
+class PararealODESolver
 {
 public:
-    using Mybase = RungeKuttaODEEngine;
+    using ValueArray    = std::vector<float64>;
+    using EngineFactory = std::function<std::unique_ptr<OrdinaryDifferentialEquation>()>;
 
-    RungeKutta2ndOrderODEEngine(std::function<Fty> Function, uint64 EquationCount) :
-        Mybase(Function, 2, 3, 3, 3, EquationCount) {}
+protected:
+    EngineFactory CoarseFactory;
+    EngineFactory FineFactory;
+    uint64        EquationCount = 0;
+    ValueArray    SliceTimes;      // 各段的起止点，共Slices + 1个
+    ValueArray    SliceStates;     // 各段起点的解，第i段的第j个分量位于[i * EquationCount + j]
+    uint64        Iterations  = 0;
+    bool          IsConverged = false;
+    float64       WallSeconds   = 0; // 求解的总耗时
+    float64       SerialSeconds = 0; // 第一次迭代中各段细求解的耗时之和，即串行细求解的耗时估计
 
-    void Init(ValueArray InitState, float64 First, float64 Last,
-        float64 InitStep = __Float64::FromBytes(BIG_NAN_DOUBLE))override
-    {
-        CTable = (float64*)__RK23_C_Table;
-        ATable = (float64*)__RK23_A_Table;
-        BTable = (float64*)__RK23_B_Table;
-        ETable = (float64*)__RK23_E_Table;
-        PTable = (float64*)__RK23_P_Table;
-        Mybase::Init(InitState, First, Last, InitStep);
-    }
-}BogackiShampineODEEngine;
+    /**
+     * @brief 用求解器把y0从t0积分到t1，返回终点的解，失败时抛出异常
+     */
+    static ValueArray Propagate(OrdinaryDifferentialEquation& Engine, const ValueArray& y0, float64 t0, float64 t1);
 
-typedef class RungeKutta4thOrderODEEngine : public RungeKuttaODEEngine
-{
 public:
-    using Mybase = RungeKuttaODEEngine;
+    uint64  Slices        = 0; // 段数，为0时使用线程数
+    uint64  Threads       = 0; // 线程数，为0时使用硬件支持的线程数
+    uint64  MaxIterations = 0; // 最大迭代次数，为0时不限制(至多Slices次)
+    float64 RelTolerNLog  = 6;
+    float64 AbsTolerNLog  = 6;
 
-    RungeKutta4thOrderODEEngine(std::function<Fty> Function, uint64 EquationCount) :
-        Mybase(Function, 4, 5, 6, 4, EquationCount) {}
+    PararealODESolver(EngineFactory Coarse, EngineFactory Fine)
+        : CoarseFactory(Coarse), FineFactory(Fine) {}
 
-    void Init(ValueArray InitState, float64 First, float64 Last,
-        float64 InitStep = __Float64::FromBytes(BIG_NAN_DOUBLE))override
-    {
-        CTable = __RK45_C_Table;
-        ATable = __RK45_A_Table;
-        BTable = __RK45_B_Table;
-        ETable = __RK45_E_Table;
-        PTable = __RK45_P_Table;
-        Mybase::Init(InitState, First, Last, InitStep);
-    }
-}DormandPrinceODEEngine, RungeKuttaDPODEEngine, DOPRIODEEngine;
+    /**
+     * @brief 从First积分到Last
+     * @return 是否在最大迭代次数内收敛
+     */
+    bool Run(ValueArray InitState, float64 First, float64 Last);
 
-using DefaultODEEngine = RungeKutta4thOrderODEEngine;
+    bool Converged()const {return IsConverged;}
+    uint64 IterationCount()const {return Iterations;}
+    float64 WallTime()const {return WallSeconds;}
+    float64 SerialTime()const {return SerialSeconds;}
+
+    /**
+     * @brief 相对于串行细求解的加速比估计，即SerialTime() / WallTime()
+     */
+    float64 Speedup()const {return SerialSeconds / WallSeconds;}
+
+    std::span<const float64> Times()const {return SliceTimes;}
+    ValueArray State(uint64 Slice)const;
+    ValueArray FinalState()const {return State(SliceTimes.size() - 1);}
+};
 
 // ------------------------------------------------------------------------------------- //
 
@@ -1189,14 +3130,17 @@ using DefaultODEEngine = RungeKutta4thOrderODEEngine;
  * @param Coeffs 初值，值的个数即方程个数
  * @param First 积分起点
  * @param Last 积分终点
+ * @param Policy 输出策略，默认保留全部采样点和稠密输出
  * @return 常微分方程的函数指针
  */
-template<typename Engine> requires std::is_base_of_v<OrdinaryDifferentialEquation, Engine>
+template<typename Engine, typename FuncType = std::function<OrdinaryDifferentialEquation::Fty>>
+requires std::is_base_of_v<OrdinaryDifferentialEquation, Engine>
 std::shared_ptr<OrdinaryDifferentialEquation>
-CreateODEFunction(std::function<OrdinaryDifferentialEquation::Fty> Func,
-    OrdinaryDifferentialEquation::ValueArray Coeffs, float64 First, float64 Last)
+CreateODEFunction(FuncType Func, OrdinaryDifferentialEquation::ValueArray Coeffs, float64 First, float64 Last,
+    OrdinaryDifferentialEquation::OutputPolicy Policy = {})
 {
     OrdinaryDifferentialEquation* Eng = new Engine(Func, Coeffs.size());
+    Eng->SetOutputPolicy(std::move(Policy));
     Eng->Init(Coeffs, First, Last);
     while (Eng->CurrentState() == Eng->Processing)
     {
@@ -1274,6 +3218,173 @@ public:
     vec2 operator()(Function1D Func)const override;
 };
 
+// ------------------------------------------------------------------------------------- //
+
+/**
+ * @brief 多元极小值算法的基类。目标函数既可以是逐点函数，也可以是批量函数，批量函数的
+ * Points中依次存放若干个Dims维的点，Values中依次存放对应的函数值。未提供批量函数时，同一
+ * 批的点在Threads个线程中求值。
+ * @note 各算法的工作空间在构造时按维数分配，重复求解同样维数的问题时不再分配内存。
+ */
+class MultivariateMinimizer
+{
+public:
+    using ObjectiveType      = std::function<float64(std::span<const float64> x)>;
+    using BatchObjectiveType = std::function<void(std::span<const float64> Points, std::span<float64> Values)>;
+
+    struct ResultType
+    {
+        std::vector<float64> x;             // 极小值点
+        float64              fx;            // 极小值
+        uint64               Iterations = 0;
+        uint64               FuncCalls  = 0; // 目标函数的求值点数(含数值求导)
+        bool                 Converged  = 0;
+    };
+
+protected:
+    ObjectiveType      Objective;
+    BatchObjectiveType BatchObjective;
+    uint64             Dims;
+    mutable uint64     FuncCalls = 0;
+
+    MultivariateMinimizer(ObjectiveType Func, BatchObjectiveType BatchFunc, uint64 Dims)
+        : Objective(Func), BatchObjective(BatchFunc), Dims(Dims)
+    {
+        if (!Dims) {throw std::logic_error("Dimension must be positive.");}
+    }
+
+    void Evaluate(std::span<const float64> Points, std::span<float64> Values)const;
+    float64 Evaluate(std::span<const float64> x)const;
+
+public:
+    uint64 Threads = 0; // 逐点函数并行求值使用的线程数，为0时使用硬件支持的线程数
+
+    uint64 Dimensions()const {return Dims;}
+
+    virtual ResultType operator()(std::span<const float64> x0) = 0;
+};
+
+/**
+ * @brief 内尔德-米德单纯形算法，译自SciPy，使用Gao和Han提出的与维数相关的自适应系数。
+ * 初始单纯形和收缩步的各个顶点互相独立，合并为一次批量求值。
+ */
+class NelderMeadMinimizer : public MultivariateMinimizer
+{
+public:
+    using Mybase = MultivariateMinimizer;
+
+protected:
+    DynamicMatrix<float64> Simplex;     // at(k, i)为第k个顶点的第i个坐标，每个顶点连续存放
+    std::vector<float64>   Values;      // 各顶点的函数值
+    std::vector<uint64>    Order;       // 按函数值升序排列的顶点编号
+    std::vector<float64>   Centroid;    // 除最差顶点外的形心
+    std::vector<float64>   Trial;       // 反射点
+    std::vector<float64>   Trial2;      // 扩展或收缩点
+    std::vector<float64>   Batch;       // 收缩时需要批量求值的顶点
+    std::vector<float64>   BatchValues;
+
+    void SortSimplex();
+    void MoveToward(std::span<float64> Out, float64 Coeff)const; // Out = (1 + Coeff) * 形心 - Coeff * 最差顶点
+
+public:
+    float64 XTolerence   = 4; // 单纯形大小的负对数
+    float64 FTolerence   = 4; // 函数值差的负对数
+    float64 MaxIteration = 0; // 最大迭代次数的对数，为0时使用200倍维数
+    bool    Adaptive     = 1; // 是否使用与维数相关的系数
+
+    NelderMeadMinimizer(ObjectiveType Func, uint64 Dims);
+    NelderMeadMinimizer(BatchObjectiveType Func, uint64 Dims);
+
+    ResultType operator()(std::span<const float64> x0)override;
+};
+
+/**
+ * @brief 有限内存BFGS算法，使用满足强沃尔夫条件的线搜索。未提供梯度函数时使用中心差分的
+ * JacobianEngine计算梯度，差分点通过批量求值一次算完。
+ * @example
+ *      LBFGSMinimizer Minimizer([](std::span<const float64> x)
+ *      {
+ *          return pow(1 - x[0], 2) + 100 * pow(x[1] - x[0] * x[0], 2);
+ *      }, 2);
+ *      auto Result = Minimizer(std::vector<float64>{-1.2, 1}); // 极小值点为(1, 1)
+ */
+class LBFGSMinimizer : public MultivariateMinimizer
+{
+public:
+    using Mybase       = MultivariateMinimizer;
+    using GradientType = std::function<void(std::span<const float64> x, std::span<float64> Grad)>;
+
+protected:
+    GradientType           Gradient;
+    JacobianEngine         NumericalGradient;
+    DynamicMatrix<float64> S, Y; // 最近的位移和梯度差，按列循环存放
+    std::vector<float64>   Rho, Alpha;
+    std::vector<float64>   Grad, NewGrad, Direction, NewX;
+    std::vector<float64>   NewS, NewY; // 本步的位移和梯度差，曲率检查通过后才写入S和Y
+    uint64                 Stored = 0, Newest = 0; // 已保存的历史数量和最新一列的位置
+
+    void ComputeGradient(std::span<const float64> x, float64 fx, std::span<float64> Out);
+    float64 LineSearch(std::span<const float64> x, float64 fx, float64 Slope, float64& NewF);
+
+public:
+    uint64  HistorySize  = 10;
+    float64 GTolerence   = 5;    // 梯度无穷范数的负对数
+    float64 FTolerence   = 14.5; // 函数值相对下降量的负对数
+    float64 MaxIteration = 4;    // 最大迭代次数的对数
+    float64 WolfeC1      = 1e-4; // 充分下降条件的系数
+    float64 WolfeC2      = 0.9;  // 曲率条件的系数
+
+    LBFGSMinimizer(ObjectiveType Func, uint64 Dims, GradientType GradFunc = nullptr);
+    LBFGSMinimizer(BatchObjectiveType Func, uint64 Dims, GradientType GradFunc = nullptr);
+
+    ResultType operator()(std::span<const float64> x0)override;
+};
+
+/**
+ * @brief 列文伯格-马夸特算法，用于非线性最小二乘问题，即求使 1/2 * Σ r_i(x)^2 最小的x。
+ * 雅可比矩阵由JacobianEngine计算，可以通过Jacobian成员修改求导方法。阻尼系数按Nielsen
+ * 的策略更新，正规方程使用楚列斯基分解求解。
+ * @note 结果中的fx为残差平方和的一半
+ */
+class LevenbergMarquardtMinimizer : public MultivariateMinimizer
+{
+public:
+    using Mybase       = MultivariateMinimizer;
+    using ResidualType = JacobianEngine::FuncType;
+
+protected:
+    ResidualType           Residual;
+    uint64                 Residuals;
+    DynamicMatrix<float64> J, Normal, Factor; // 雅可比矩阵、JᵀJ和阻尼后的系数矩阵的楚列斯基分解
+    std::vector<float64>   r, NewR, Gradient, Scale, Step, NewX;
+
+    LevenbergMarquardtMinimizer(JacobianEngine Engine, ResidualType Func, uint64 Dims, uint64 Residuals);
+
+    void EvaluateResidual(std::span<const float64> x, std::span<float64> Out);
+
+public:
+    JacobianEngine Jacobian;
+    float64 GTolerence   = 10; // 梯度无穷范数的负对数
+    float64 XTolerence   = 10; // 相对步长的负对数
+    float64 FTolerence   = 10; // 残差平方和相对下降量的负对数
+    float64 MaxIteration = 3;  // 最大迭代次数的对数
+    float64 InitialDamping = 1e-3; // 初始阻尼系数与JᵀJ最大对角元之比
+
+    /**
+     * @param Func 残差函数，输入Dims个参数，输出Residuals个残差
+     */
+    LevenbergMarquardtMinimizer(ResidualType Func, uint64 Dims, uint64 Residuals);
+
+    /**
+     * @brief 使用批量残差函数构造，Points中依次存放若干组参数，Values中依次存放对应的残差
+     */
+    static LevenbergMarquardtMinimizer Batched(JacobianEngine::BatchFuncType Func, uint64 Dims, uint64 Residuals);
+
+    uint64 Outputs()const {return Residuals;}
+
+    ResultType operator()(std::span<const float64> x0)override;
+};
+
 
 /****************************************************************************************\
 *                                         反函数                                         *
@@ -1339,6 +3450,82 @@ protected:
 static const vec2 __Whole_Line =
     {__Float64::FromBytes(NEG_INF_DOUBLE), __Float64::FromBytes(POS_INF_DOUBLE)};
 
+/**
+ * @brief 批量布伦特求根器，对多组互相独立的区间同步执行与BrentInverseFunction::QSolve
+ * 相同的布伦特算法。每次迭代中所有未收敛通道的求值点合并为一次批量函数调用，已收敛或
+ * 出错的通道不再参与求值。每个通道的结果与单独调用QSolve完全相同。
+ * @details 每个通道求解f(x) = Target，其中f为共用的原函数，Target为各通道的目标值(默认
+ * 为0，即求根)。若已知区间端点处的函数值，可用SetEndpointValues传入以节省一次求值。
+ * @example
+ *      std::vector<vec2> Brackets(1000, {0, 10});
+ *      std::vector<float64> y(1000), x(1000);
+ *      ... // 填充目标值
+ *      BatchedBrentRootFinder Solver(Brackets, y);
+ *      Solver.Run(BatchFunc, 2);
+ *      Solver.GetRoots(x);
+ */
+class BatchedBrentRootFinder : public BatchedElementwiseIterator
+{
+public:
+    using Mybase = BatchedElementwiseIterator;
+    friend class BrentInverseFunction;
+
+    enum StateType
+    {
+        InProgress   = 1,
+        Finished     = 0,
+        SignError    = -1, // 区间两端函数值同号
+        NotConverged = -2  // 达到最大迭代次数仍未收敛
+    };
+
+protected:
+    struct LaneState
+    {
+        float64   xpre, xcur, xblk = 0;
+        float64   fpre, fcur, fblk = 0;
+        float64   spre = 0, scur = 0;
+        float64   Target = 0;
+        StateType State  = InProgress;
+    };
+
+    std::vector<LaneState> States;
+    float64 AbsTolerence;
+    float64 RelTolerence;
+    bool    EndpointsEvaluated = 0;
+
+    void Start(LaneState& Lane);   // 两端函数值已知后检查符号并迈出第一步
+    void Advance(LaneState& Lane); // 对应QSolve中的一次循环
+
+public:
+    /**
+     * @param Brackets 每个通道的求根区间
+     * @param Targets 每个通道的目标值，为空时全部为0
+     * @param AbsTolerence 绝对误差的负对数
+     * @param RelTolerence 相对误差的负对数
+     */
+    BatchedBrentRootFinder(std::span<const vec2> Brackets, std::span<const float64> Targets = {},
+        float64 AbsTolerence = 11.69897, float64 RelTolerence = 15.0515);
+
+    /**
+     * @brief 传入区间端点处的原函数值(不减去目标值)，x对应区间起点，y对应终点
+     */
+    void SetEndpointValues(std::span<const vec2> Values);
+
+    void PreEvaluator(std::span<const uint64> Lanes, std::vector<float64>& x) override;
+    void PostEvaluator(std::span<const uint64> Lanes, std::span<const float64> x,
+        std::span<const float64> fx) override;
+    void Conditioner(std::span<const uint64> Lanes, std::span<bool> Terminate) override;
+    void Finalize(std::span<const uint64>) override {}
+
+    StateType Status(uint64 Lane)const;
+
+    /**
+     * @brief 输出各通道的根，失败的通道输出NaN
+     * @return 失败的通道数
+     */
+    uint64 GetRoots(std::span<float64> Out)const;
+};
+
 /**
  * @brief 布伦特反函数，译自pynverse，并转写为独立的类。
  *
@@ -1364,8 +3551,10 @@ class BrentInverseFunction : public InverseFunction
 {
 public:
     using Mybase        = InverseFunction;
+    using BatchFuncType = BatchedElementwiseIterator::BatchFuncType;
 
 protected:
+    BatchFuncType BatchFunction; // 可选，批量求值版本的原函数
     vec2    Domain;     // 定义域
     bvec2   OpenDomain; // 区间类型
     vec2    Range;      // 值域
@@ -1375,6 +3564,7 @@ protected:
 
     vec2 GetReferencePoints(vec2 Domain)const;
     vec2 GetReferenceValues(vec2 Domain, int Trend)const;
+    void CheckRange(float64 x, vec2 RefValues, int Trend)const;
 
 public:
     /**
@@ -1393,12 +3583,41 @@ public:
         CheckParameters();
     }
 
+    /**
+     * @brief 同上，并额外提供批量求值版本的原函数，供批量求反函数值时使用
+     */
+    BrentInverseFunction(Function1D Func, BatchFuncType BatchFunc, vec2 Domain = __Whole_Line,
+        bvec2 OpenDomain = {0, 0}, vec2 Range = __Whole_Line)
+        : BrentInverseFunction(Func, Domain, OpenDomain, Range)
+    {
+        BatchFunction = BatchFunc;
+    }
+
     float64 operator()(float64 x)const override;
 
+    /**
+     * @brief 批量求反函数值。先同步地为每个值向外扩展出有根区间，再使用批量布伦特算法
+     * 求解，所有通道的求值合并为批量调用。
+     * @param x 反函数的参数
+     * @param Out 输出，大小与x相同
+     * @param Threads 未提供批量原函数时，逐点求值使用的线程数
+     * @note 结果与单点版本在容差范围内一致，但由于单点版本使用极小化算法，两者不保证逐位相同
+     */
+    void operator()(std::span<const float64> x, std::span<float64> Out, uint64 Threads = 1)const;
+
     // 快速求解函数(SciPy移植)
     static float64 QSolve(Function1D Func, vec2 Domain,
         float64 AbsTolerence = 11.69897, float64 RelTolerence = 15.0515, float64 MaxIterCount = 2,
         uint64* IterCount = nullptr, uint64* FuncCalls = nullptr);
+
+    /**
+     * @brief 批量版本的快速求解函数，同时求解多个区间内的根，失败时与单点版本一样抛出异常
+     * @param IterCount 批量迭代的次数(即批量函数的调用次数)
+     * @param FuncCalls 函数求值的总点数
+     */
+    static void QSolve(BatchFuncType Func, std::span<const vec2> Domains, std::span<float64> Out,
+        float64 AbsTolerence = 11.69897, float64 RelTolerence = 15.0515, float64 MaxIterCount = 2,
+        uint64* IterCount = nullptr, uint64* FuncCalls = nullptr);
 };
 
 /**
@@ -1484,10 +3703,14 @@ public:
 
 protected:
     std::vector<Function1D> DerivativeFunctions; // n阶导函数
+    std::function<void(float64 x, std::span<float64> Derivatives)> JetFunction; // 一次求出0到n阶导数
+    uint64  JetOrder          = 0;
     float64 AbsoluteTolerence = 7.83; // 绝对误差的负对数，默认1.48e-8
     float64 RelativeTolerence = __Float64::FromBytes(POS_INF_DOUBLE); // 相对误差的负对数，默认0
     float64 MaxIteration      = 1.7;  // 最大迭代次数的对数
 
+    HouseholderIteratorGroup() = default;
+
 public:
     HouseholderIteratorGroup(std::vector<Function1D> Functions, float64 RefX)
     {
@@ -1502,7 +3725,36 @@ public:
         ReferencePoint = RefX;
     }
 
-    uint64 Order()const {return DerivativeFunctions.size();}
+    /**
+     * @brief 使用自动微分构造N阶迭代，函数需为泛型函数，接受Dual<float64, N>并返回同类型的值。
+     * 每次迭代只需求值一次即可得到函数值和全部导数，不需要另外提供导函数。
+     * @example
+     *  求解x^3 - 2x - 5 = 0(哈雷迭代)：
+     *      auto Solver = HouseholderIteratorGroup::FromJet<2>(
+     *          [](auto x){return x * x * x - 2. * x - 5.;}, 2);
+     *      cout << Solver(0) << '\n';
+     *  输出：2.0945514815423265
+     */
+    template<std::size_t N, typename _Func>
+    static HouseholderIteratorGroup FromJet(_Func Func, float64 RefX)
+    {
+        static_assert(N >= 1, "At least first derivative is required.");
+        HouseholderIteratorGroup Engine;
+        Engine.OriginalFunction = [Func](float64 x)
+        {
+            return float64(Func(Dual<float64, N>(x)).Value());
+        };
+        Engine.JetFunction = [Func](float64 x, std::span<float64> Derivatives)
+        {
+            Dual<float64, N> y = Func(Dual<float64, N>::Variable(x));
+            for (std::size_t k = 0; k <= N; ++k) {Derivatives[k] = y.Derivative(k);}
+        };
+        Engine.JetOrder = N;
+        Engine.ReferencePoint = RefX;
+        return Engine;
+    }
+
+    uint64 Order()const {return JetFunction ? JetOrder : DerivativeFunctions.size();}
 
     float64 Run(float64 x = 0, uint64* IterCount = nullptr, uint64* FCallCount = nullptr)const;
     float64 operator()(float64 x) const override;
@@ -1515,6 +3767,109 @@ public:
         float64 AbsTol = 7.83, float64 RelTol = __Float64::FromBytes(POS_INF_DOUBLE));
 };
 
+
+/****************************************************************************************\
+*                                        函数逼近                                        *
+\****************************************************************************************/
+
+/**
+ * @brief 切比雪夫代理函数，仿照Chebfun，将一个计算量较大的一元函数在有界区间上用分段切比雪夫
+ * 插值多项式代替，构造完成后每次求值只需计算一次多项式。
+ * @details 构造时在每段上依次使用17, 33, 65...个第二类切比雪夫点(cos(jπ/n))插值，点数加倍时
+ * 之前的函数值全部复用。当尾部的系数都小于容差乘以整个区间上函数值的最大绝对值时认为已收敛，
+ * 并舍去尾部可以忽略的系数；达到最大次数仍不收敛时，每次从中点二分误差最大的一段，直到全部收敛、
+ * 达到最大段数或段宽小于区间长度的MinRelativeWidth倍。奇点附近可能无法收敛，此时Converged返回false。
+ *
+ * 求值使用Clenshaw递推；导数和不定积分直接对切比雪夫系数进行递推，结果仍为切比雪夫代理函数；
+ * 求根使用友矩阵(colleague matrix)的特征值，次数较高的段先二分以降低求解特征值的开销；
+ * 特征值迭代不收敛时改为查找变号并用布伦特法求根。
+ *
+ * 参考文献：
+ * [1] Trefethen L N. Approximation Theory and Approximation Practice[M]. SIAM, 2013.
+ * [2] Boyd J P. Finding the Zeros of a Univariate Equation: Proxy Rootfinders, Chebyshev
+ *     Interpolation, and the Companion Matrix[J]. SIAM Review, 2013, 55(2): 375-396.
+ *
+ * 「先磨刀，后砍柴。」
+ *
+ * @example
+ *  ChebyshevApproximation f([](float64 x){return exp(x) * sin(Angle::FromRadians(5 * x));}, 0, 3);
+ *  cout << f(1.5) << ' ' << f.Integral()(3) << ' ' << f.Roots().size() << '\n';
+ */
+class ChebyshevApproximation
+{
+public:
+    constexpr static const float64 MinRelativeWidth = 1e-12;
+
+    struct Segment
+    {
+        float64              Lower;
+        float64              Upper;
+        std::vector<float64> Coefficients; // 切比雪夫系数，升幂排列
+    };
+
+protected:
+    std::vector<Segment> Segments; // 按区间顺序排列，首尾相接
+    bool                 FullyConverged = 0;
+
+    static std::vector<float64> ValuesToCoefficients(std::span<const float64> Values);
+    static float64 Clenshaw(std::span<const float64> Coeffs, float64 t);
+
+    /**
+     * @brief 在[a, b]上构造一段，VScale为目前已知的函数值的最大绝对值，会被更新
+     * @param Error 尾部系数的最大绝对值
+     * @return 是否收敛
+     */
+    static bool Fit(Function1D Func, float64 a, float64 b, float64 Tol, uint64 MaxDegree,
+        float64& VScale, Segment* Out, float64* Error = nullptr);
+    void Build(Function1D Func, float64 a, float64 b, float64 Tol, uint64 MaxDegree, uint64 MaxSegments);
+    static void SegmentRoots(const Segment& Seg, std::vector<float64>& Roots, uint64 Depth = 0);
+    const Segment& Locate(float64 x)const;
+
+    ChebyshevApproximation() = default;
+
+public:
+    /**
+     * @param Func 被逼近的函数
+     * @param a, b 区间
+     * @param Tolerence 相对容差的负对数
+     * @param MaxDegree 每段的最大次数
+     * @param MaxSegments 最大段数
+     */
+    ChebyshevApproximation(Function1D Func, float64 a, float64 b, float64 Tolerence = 14,
+        uint64 MaxDegree = 256, uint64 MaxSegments = 64);
+
+    /**
+     * @brief 使用给定的分段系数构造
+     */
+    ChebyshevApproximation(std::vector<Segment> Pieces);
+
+    vec2 Domain()const {return {Segments.front().Lower, Segments.back().Upper};}
+    uint64 size()const {return Segments.size();}
+    const std::vector<Segment>& GetSegments()const {return Segments;}
+    uint64 Degree()const; // 各段中的最大次数
+    bool Converged()const {return FullyConverged;} // 是否所有段都达到了容差
+
+    float64 operator()(float64 x)const;
+    void operator()(std::span<const float64> x, std::span<float64> Out)const;
+
+    ChebyshevApproximation Derivative()const;
+
+    /**
+     * @brief 不定积分，在区间左端点处为0
+     */
+    ChebyshevApproximation Integral()const;
+
+    /**
+     * @brief 整个区间上的定积分
+     */
+    float64 Integrate()const;
+
+    /**
+     * @brief 区间内的所有实根，升序排列
+     */
+    std::vector<float64> Roots()const;
+};
+
 _SCICXX_END
 
 _CSE_END
@@ -0,0 +1,572 @@
+#include "CSE/Base/AdvMath.h"
+
+_CSE_BEGIN
+_SCICXX_BEGIN
+
+////////////////////////////////// 切比雪夫逼近 //////////////////////////////////
+
+// 第二类切比雪夫点cos(jπ/n)，角度直接以角度制计算
+static float64 __Chebyshev_Point(uint64 j, uint64 n)
+{
+    return cos(Angle(180. * float64(j) / float64(n)));
+}
+
+std::vector<float64> ChebyshevApproximation::ValuesToCoefficients(std::span<const float64> Values)
+{
+    // c_k = (2 / n) * Σ'' f_j * cos(jkπ / n)，首尾两项取一半
+    uint64 n = Values.size() - 1;
+    if (!n) {return {Values[0]};}
+    std::vector<float64> CosTable(2 * n);
+    for (uint64 m = 0; m < 2 * n; ++m) {CosTable[m] = __Chebyshev_Point(m, n);}
+
+    std::vector<float64> Coeffs(n + 1);
+    for (uint64 k = 0; k <= n; ++k)
+    {
+        float64 Sum = (Values[0] + Values[n] * CosTable[(n * k) % (2 * n)]) / 2.;
+        for (uint64 j = 1; j < n; ++j)
+        {
+            Sum += Values[j] * CosTable[(j * k) % (2 * n)];
+        }
+        Coeffs[k] = 2. * Sum / float64(n);
+    }
+    Coeffs[0] /= 2.;
+    Coeffs[n] /= 2.;
+    return Coeffs;
+}
+
+float64 ChebyshevApproximation::Clenshaw(std::span<const float64> Coeffs, float64 t)
+{
+    float64 b1 = 0, b2 = 0;
+    for (uint64 k = Coeffs.size() - 1; k >= 1; --k)
+    {
+        float64 b0 = Coeffs[k] + 2. * t * b1 - b2;
+        b2 = b1;
+        b1 = b0;
+    }
+    return Coeffs[0] + t * b1 - b2;
+}
+
+bool ChebyshevApproximation::Fit(Function1D Func, float64 a, float64 b, float64 Tol, uint64 MaxDegree,
+    float64& VScale, Segment* Out, float64* Error)
+{
+    float64 Mid = (a + b) / 2., Half = (b - a) / 2.;
+    auto Evaluate = [&](uint64 j, uint64 n)
+    {
+        float64 y = Func(Mid + Half * __Chebyshev_Point(j, n));
+        if (!std::isfinite(y)) {throw std::logic_error("Function is not finite on the interval.");}
+        return y;
+    };
+
+    uint64 n = 16;
+    std::vector<float64> Values(n + 1);
+    for (uint64 j = 0; j <= n; ++j) {Values[j] = Evaluate(j, n);}
+
+    Out->Lower = a;
+    Out->Upper = b;
+    while (true)
+    {
+        Out->Coefficients = ValuesToCoefficients(Values);
+        // 阈值相对于整个区间上的函数值，而不是本段的函数值
+        for (float64 v : Values) {VScale = max(VScale, abs(v));}
+        float64 Threshold = Tol * VScale;
+
+        // 尾部若干项全部小于阈值时认为收敛
+        uint64 Tail = max(3ull, n / 8);
+        float64 TailMax = 0;
+        for (uint64 k = n + 1 - Tail; k <= n; ++k)
+        {
+            TailMax = max(TailMax, abs(Out->Coefficients[k]));
+        }
+        if (Error) {*Error = TailMax;}
+        if (TailMax <= Threshold)
+        {
+            uint64 Last = n;
+            while (Last > 0 && abs(Out->Coefficients[Last]) <= Threshold) {--Last;}
+            Out->Coefficients.resize(Last + 1);
+            return 1;
+        }
+        if (2 * n > MaxDegree) {return 0;}
+
+        // 点数加倍，原有的点恰好是新点中的偶数项
+        std::vector<float64> NewValues(2 * n + 1);
+        for (uint64 j = 0; j <= n; ++j) {NewValues[2 * j] = Values[j];}
+        for (uint64 j = 1; j < 2 * n; j += 2) {NewValues[j] = Evaluate(j, 2 * n);}
+        Values = std::move(NewValues);
+        n *= 2;
+    }
+}
+
+void ChebyshevApproximation::Build(Function1D Func, float64 a, float64 b, float64 Tol, uint64 MaxDegree, uint64 MaxSegments)
+{
+    // 每次二分误差最大的未收敛段，宽度小于MinRelativeWidth * (b - a)的段不再二分。
+    // 奇点附近的段无法收敛时，段数不会全部耗费在宽度只有几个ULP的区间上
+    float64 MinWidth = MinRelativeWidth * (b - a);
+    float64 VScale = 0;
+    std::vector<float64> Errors(1);
+    std::vector<uint8_t> Done(1);
+    Segments.resize(1);
+    Done[0] = Fit(Func, a, b, Tol, MaxDegree, VScale, &Segments[0], &Errors[0]);
+
+    while (Segments.size() < MaxSegments)
+    {
+        uint64 Worst = Segments.size();
+        for (uint64 i = 0; i < Segments.size(); ++i)
+        {
+            if (Done[i] || Segments[i].Upper - Segments[i].Lower < 2. * MinWidth) {continue;}
+            if (Worst == Segments.size() || Errors[i] > Errors[Worst]) {Worst = i;}
+        }
+        if (Worst == Segments.size()) {break;}
+
+        float64 Lower = Segments[Worst].Lower, Upper = Segments[Worst].Upper;
+        float64 Mid = (Lower + Upper) / 2.;
+        Segment Left, Right;
+        float64 LeftError, RightError;
+        bool LeftDone = Fit(Func, Lower, Mid, Tol, MaxDegree, VScale, &Left, &LeftError);
+        bool RightDone = Fit(Func, Mid, Upper, Tol, MaxDegree, VScale, &Right, &RightError);
+        Segments[Worst] = std::move(Left);
+        Errors[Worst] = LeftError;
+        Done[Worst] = LeftDone;
+        Segments.insert(Segments.begin() + Worst + 1, std::move(Right));
+        Errors.insert(Errors.begin() + Worst + 1, RightError);
+        Done.insert(Done.begin() + Worst + 1, RightDone);
+    }
+
+    FullyConverged = std::find(Done.begin(), Done.end(), 0) == Done.end();
+}
+
+ChebyshevApproximation::ChebyshevApproximation(Function1D Func, float64 a, float64 b,
+    float64 Tolerence, uint64 MaxDegree, uint64 MaxSegments)
+{
+    if (!(a < b)) {throw std::logic_error("Interval is invalid.");}
+    if (!std::isfinite(a) || !std::isfinite(b)) {throw std::logic_error("Interval must be bounded.");}
+    Build(Func, a, b, pow(10, -Tolerence), max(MaxDegree, 16ull), max(MaxSegments, 1ull));
+}
+
+ChebyshevApproximation::ChebyshevApproximation(std::vector<Segment> Pieces)
+    : Segments(std::move(Pieces)), FullyConverged(1)
+{
+    if (Segments.empty()) {throw std::logic_error("At least one segment is required.");}
+}
+
+uint64 ChebyshevApproximation::Degree()const
+{
+    uint64 Result = 0;
+    for (const auto& Seg : Segments) {Result = max(Result, uint64(Seg.Coefficients.size() - 1));}
+    return Result;
+}
+
+const ChebyshevApproximation::Segment& ChebyshevApproximation::Locate(float64 x)const
+{
+    // 区间外的点使用两端的段外推
+    auto it = std::lower_bound(Segments.begin(), Segments.end(), x,
+        [](const Segment& Seg, float64 x){return Seg.Upper < x;});
+    return it == Segments.end() ? Segments.back() : *it;
+}
+
+float64 ChebyshevApproximation::operator()(float64 x)const
+{
+    const Segment& Seg = Locate(x);
+    float64 t = (2. * x - (Seg.Lower + Seg.Upper)) / (Seg.Upper - Seg.Lower);
+    return Clenshaw(Seg.Coefficients, t);
+}
+
+void ChebyshevApproximation::operator()(std::span<const float64> x, std::span<float64> Out)const
+{
+    if (x.size() != Out.size()) {throw std::logic_error("Size of output mismatch.");}
+    for (uint64 i = 0; i < x.size(); ++i) {Out[i] = (*this)(x[i]);}
+}
+
+ChebyshevApproximation ChebyshevApproximation::Derivative()const
+{
+    ChebyshevApproximation Result;
+    Result.FullyConverged = FullyConverged;
+    for (const auto& Seg : Segments)
+    {
+        // c'_(k-1) = c'_(k+1) + 2k * c_k
+        const auto& c = Seg.Coefficients;
+        uint64 n = c.size() - 1;
+        Segment d{Seg.Lower, Seg.Upper, std::vector<float64>(max(n, 1ull), 0.)};
+        for (uint64 k = n; k >= 1; --k)
+        {
+            d.Coefficients[k - 1] = (k + 1 < n ? d.Coefficients[k + 1] : 0.) + 2. * float64(k) * c[k];
+        }
+        if (n) {d.Coefficients[0] /= 2.;}
+        float64 Scale = 2. / (Seg.Upper - Seg.Lower);
+        for (auto& v : d.Coefficients) {v *= Scale;}
+        Result.Segments.push_back(std::move(d));
+    }
+    return Result;
+}
+
+ChebyshevApproximation ChebyshevApproximation::Integral()const
+{
+    ChebyshevApproximation Result;
+    Result.FullyConverged = FullyConverged;
+    float64 Constant = 0;
+    for (const auto& Seg : Segments)
+    {
+        // ∫T_0 = T_1, ∫T_k = T_(k+1) / 2(k+1) - T_(k-1) / 2(k-1)
+        const auto& c = Seg.Coefficients;
+        uint64 n = c.size() - 1;
+        auto At = [&c, n](uint64 k){return k <= n ? c[k] : 0.;};
+        Segment I{Seg.Lower, Seg.Upper, std::vector<float64>(n + 2, 0.)};
+        float64 Scale = (Seg.Upper - Seg.Lower) / 2.;
+        I.Coefficients[1] = Scale * (At(0) - At(2) / 2.);
+        for (uint64 k = 2; k <= n + 1; ++k)
+        {
+            I.Coefficients[k] = Scale * (At(k - 1) - At(k + 1)) / (2. * float64(k));
+        }
+        // 左端点处(t = -1)的值等于之前各段的积分之和
+        float64 Left = 0;
+        for (uint64 k = 1; k <= n + 1; ++k) {Left += (k & 1) ? -I.Coefficients[k] : I.Coefficients[k];}
+        I.Coefficients[0] = Constant - Left;
+        Constant = Clenshaw(I.Coefficients, 1);
+        Result.Segments.push_back(std::move(I));
+    }
+    return Result;
+}
+
+float64 ChebyshevApproximation::Integrate()const
+{
+    float64 Sum = 0;
+    for (const auto& Seg : Segments)
+    {
+        float64 SegSum = 0;
+        for (uint64 k = 0; k < Seg.Coefficients.size(); k += 2)
+        {
+            SegSum += Seg.Coefficients[k] * 2. / (1. - float64(k * k));
+        }
+        Sum += SegSum * (Seg.Upper - Seg.Lower) / 2.;
+    }
+    return Sum;
+}
+
+// ---------------------------------- 求根 ---------------------------------- //
+
+// 平衡矩阵，减小特征值的舍入误差，参见Numerical Recipes中的balanc
+static void __Balance_Matrix(std::vector<float64>& A, uint64 n)
+{
+    auto a = [&](uint64 i, uint64 j) -> float64& {return A[i * n + j];};
+    const float64 Radix = 2, SqrRadix = Radix * Radix;
+    bool Done = 0;
+    while (!Done)
+    {
+        Done = 1;
+        for (uint64 i = 0; i < n; ++i)
+        {
+            float64 r = 0, c = 0;
+            for (uint64 j = 0; j < n; ++j)
+            {
+                if (j == i) {continue;}
+                c += abs(a(j, i));
+                r += abs(a(i, j));
+            }
+            if (!c || !r) {continue;}
+            float64 g = r / Radix, f = 1, s = c + r;
+            while (c < g)
+            {
+                f *= Radix;
+                c *= SqrRadix;
+            }
+            g = r * Radix;
+            while (c > g)
+            {
+                f /= Radix;
+                c /= SqrRadix;
+            }
+            if ((c + r) / f < 0.95 * s)
+            {
+                Done = 0;
+                for (uint64 j = 0; j < n; ++j) {a(i, j) /= f;}
+                for (uint64 j = 0; j < n; ++j) {a(j, i) *= f;}
+            }
+        }
+    }
+}
+
+// 上海森堡矩阵的特征值，带原点位移的QR算法，参见Numerical Recipes中的hqr
+// 迭代次数过多时返回false
+static bool __Hessenberg_Eigenvalues(std::vector<float64>& A, uint64 n,
+    std::vector<float64>& wr, std::vector<float64>& wi)
+{
+    // 以下沿用原算法从1开始的下标
+    auto a = [&](int64 i, int64 j) -> float64& {return A[(i - 1) * n + (j - 1)];};
+    wr.assign(n + 1, 0);
+    wi.assign(n + 1, 0);
+
+    float64 anorm = 0;
+    for (int64 i = 1; i <= int64(n); ++i)
+    {
+        for (int64 j = max(i - 1, 1ll); j <= int64(n); ++j) {anorm += abs(a(i, j));}
+    }
+
+    int64 nn = n, l = 0;
+    float64 t = 0, p = 0, q = 0, r = 0, s = 0, w = 0, x = 0, y = 0, z = 0;
+    while (nn >= 1)
+    {
+        uint64 its = 0;
+        do
+        {
+            for (l = nn; l >= 2; --l)
+            {
+                s = abs(a(l - 1, l - 1)) + abs(a(l, l));
+                if (s == 0) {s = anorm;}
+                if (abs(a(l, l - 1)) + s == s)
+                {
+                    a(l, l - 1) = 0;
+                    break;
+                }
+            }
+            x = a(nn, nn);
+            if (l == nn)
+            {
+                wr[nn] = x + t;
+                wi[nn--] = 0;
+            }
+            else
+            {
+                y = a(nn - 1, nn - 1);
+                w = a(nn, nn - 1) * a(nn - 1, nn);
+                if (l == nn - 1)
+                {
+                    p = 0.5 * (y - x);
+                    q = p * p + w;
+                    z = sqrt(abs(q));
+                    x += t;
+                    if (q >= 0)
+                    {
+                        z = p + (p >= 0 ? abs(z) : -abs(z));
+                        wr[nn - 1] = wr[nn] = x + z;
+                        if (z) {wr[nn] = x - w / z;}
+                        wi[nn - 1] = wi[nn] = 0;
+                    }
+                    else
+                    {
+                        wr[nn - 1] = wr[nn] = x + p;
+                        wi[nn - 1] = -(wi[nn] = z);
+                    }
+                    nn -= 2;
+                }
+                else
+                {
+                    if (its == 60) {return 0;}
+                    if (its == 10 || its == 20)
+                    {
+                        // 特殊位移
+                        t += x;
+                        for (int64 i = 1; i <= nn; ++i) {a(i, i) -= x;}
+                        s = abs(a(nn, nn - 1)) + abs(a(nn - 1, nn - 2));
+                        y = x = 0.75 * s;
+                        w = -0.4375 * s * s;
+                    }
+                    ++its;
+                    int64 m = nn - 2;
+                    for (; m >= l; --m)
+                    {
+                        z = a(m, m);
+                        r = x - z;
+                        s = y - z;
+                        p = (r * s - w) / a(m + 1, m) + a(m, m + 1);
+                        q = a(m + 1, m + 1) - z - r - s;
+                        r = a(m + 2, m + 1);
+                        s = abs(p) + abs(q) + abs(r);
+                        p /= s;
+                        q /= s;
+                        r /= s;
+                        if (m == l) {break;}
+                        float64 u = abs(a(m, m - 1)) * (abs(q) + abs(r));
+                        float64 v = abs(p) * (abs(a(m - 1, m - 1)) + abs(z) + abs(a(m + 1, m + 1)));
+                        if (u + v == v) {break;}
+                    }
+                    for (int64 i = m + 2; i <= nn; ++i)
+                    {
+                        a(i, i - 2) = 0;
+                        if (i != m + 2) {a(i, i - 3) = 0;}
+                    }
+                    for (int64 k = m; k <= nn - 1; ++k)
+                    {
+                        if (k != m)
+                        {
+                            p = a(k, k - 1);
+                            q = a(k + 1, k - 1);
+                            r = 0;
+                            if (k != nn - 1) {r = a(k + 2, k - 1);}
+                            if ((x = abs(p) + abs(q) + abs(r)) != 0)
+                            {
+                                p /= x;
+                                q /= x;
+                                r /= x;
+                            }
+                        }
+                        s = sqrt(p * p + q * q + r * r);
+                        if (p < 0) {s = -s;}
+                        if (s != 0)
+                        {
+                            if (k == m)
+                            {
+                                if (l != m) {a(k, k - 1) = -a(k, k - 1);}
+                            }
+                            else {a(k, k - 1) = -s * x;}
+                            p += s;
+                            x = p / s;
+                            y = q / s;
+                            z = r / s;
+                            q /= p;
+                            r /= p;
+                            for (int64 j = k; j <= nn; ++j)
+                            {
+                                p = a(k, j) + q * a(k + 1, j);
+                                if (k != nn - 1)
+                                {
+                                    p += r * a(k + 2, j);
+                                    a(k + 2, j) -= p * z;
+                                }
+                                a(k + 1, j) -= p * y;
+                                a(k, j) -= p * x;
+                            }
+                            int64 mmin = nn < k + 3 ? nn : k + 3;
+                            for (int64 i = l; i <= mmin; ++i)
+                            {
+                                p = x * a(i, k) + y * a(i, k + 1);
+                                if (k != nn - 1)
+                                {
+                                    p += z * a(i, k + 2);
+                                    a(i, k + 2) -= p * r;
+                                }
+                                a(i, k + 1) -= p * q;
+                                a(i, k) -= p;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        while (l < nn - 1);
+    }
+    wr.erase(wr.begin());
+    wi.erase(wi.begin());
+    return 1;
+}
+
+// 特征值求解失败时的后备方法：在加密的切比雪夫点上查找变号，再用布伦特法求根
+static void __Chebyshev_Bracketing_Roots(const std::vector<float64>& c, std::vector<float64>& t,
+    float64 (*Evaluate)(std::span<const float64>, float64))
+{
+    uint64 m = 4 * c.size();
+    auto f = [&](float64 x){return Evaluate(c, x);};
+    float64 x0 = -1, f0 = f(x0);
+    if (f0 == 0) {t.push_back(x0);}
+    for (uint64 j = m; j-- > 0;)
+    {
+        float64 x1 = __Chebyshev_Point(j, m), f1 = f(x1);
+        if (f1 == 0) {t.push_back(x1);}
+        else if (f0 != 0 && (f0 < 0) != (f1 < 0))
+        {
+            t.push_back(BrentInverseFunction::QSolve(f, {x0, x1}, 15.6536, 15.6536));
+        }
+        x0 = x1;
+        f0 = f1;
+    }
+}
+
+void ChebyshevApproximation::SegmentRoots(const Segment& Seg, std::vector<float64>& Roots, uint64 Depth)
+{
+    // 舍去尾部可以忽略的系数
+    std::vector<float64> c = Seg.Coefficients;
+    float64 Scale = 0;
+    for (float64 v : c) {Scale += abs(v);}
+    if (!Scale) {return;}
+    while (c.size() > 1 && abs(c.back()) <= 1e-15 * Scale) {c.pop_back();}
+    uint64 n = c.size() - 1;
+    if (!n) {return;}
+
+    float64 Mid = (Seg.Lower + Seg.Upper) / 2., Half = (Seg.Upper - Seg.Lower) / 2.;
+
+    // 次数太高时二分，每半段上的插值对原多项式是精确的
+    if (n > 50 && Depth < 8)
+    {
+        for (int Side = 0; Side < 2; ++Side)
+        {
+            Segment Child;
+            Child.Lower = Side ? Mid : Seg.Lower;
+            Child.Upper = Side ? Seg.Upper : Mid;
+            std::vector<float64> Values(n + 1);
+            for (uint64 j = 0; j <= n; ++j)
+            {
+                float64 x = (Child.Lower + Child.Upper) / 2. + (Child.Upper - Child.Lower) / 2. * __Chebyshev_Point(j, n);
+                Values[j] = Clenshaw(c, (x - Mid) / Half);
+            }
+            Child.Coefficients = ValuesToCoefficients(Values);
+            SegmentRoots(Child, Roots, Depth + 1);
+        }
+        return;
+    }
+
+    std::vector<float64> t;
+    if (n == 1) {t.push_back(-c[0] / c[1]);}
+    else
+    {
+        // 友矩阵的转置，为上海森堡矩阵
+        std::vector<float64> H(n * n, 0.);
+        auto h = [&](uint64 i, uint64 j) -> float64& {return H[i * n + j];};
+        h(1, 0) = 1;
+        for (uint64 k = 1; k < n - 1; ++k)
+        {
+            h(k - 1, k) = 0.5;
+            h(k + 1, k) = 0.5;
+        }
+        h(n - 2, n - 1) = 0.5;
+        for (uint64 j = 0; j < n; ++j) {h(j, n - 1) -= c[j] / (2. * c[n]);}
+
+        std::vector<float64> wr, wi;
+        __Balance_Matrix(H, n);
+        if (__Hessenberg_Eigenvalues(H, n, wr, wi))
+        {
+            for (uint64 i = 0; i < n; ++i)
+            {
+                if (abs(wi[i]) <= 1e-8 && abs(wr[i]) <= 1. + 1e-8) {t.push_back(wr[i]);}
+            }
+        }
+        else {__Chebyshev_Bracketing_Roots(c, t, Clenshaw);}
+    }
+
+    // 使用牛顿迭代修正
+    std::vector<float64> dc(max(n, 1ull), 0.);
+    for (uint64 k = n; k >= 1; --k)
+    {
+        dc[k - 1] = (k + 1 < n ? dc[k + 1] : 0.) + 2. * float64(k) * c[k];
+    }
+    if (n) {dc[0] /= 2.;}
+    for (float64 Root : t)
+    {
+        if (abs(Root) > 1. + 1e-8) {continue;}
+        for (int i = 0; i < 2; ++i)
+        {
+            float64 df = Clenshaw(dc, Root);
+            if (!df) {break;}
+            float64 Step = Clenshaw(c, Root) / df;
+            if (abs(Step) > 1e-6) {break;}
+            Root -= Step;
+        }
+        Roots.push_back(Mid + Half * clamp(Root, -1., 1.));
+    }
+}
+
+std::vector<float64> ChebyshevApproximation::Roots()const
+{
+    std::vector<float64> Result;
+    for (const auto& Seg : Segments) {SegmentRoots(Seg, Result);}
+    std::sort(Result.begin(), Result.end());
+
+    // 去掉相邻段在分界点处重复求出的根
+    float64 Width = Segments.back().Upper - Segments.front().Lower;
+    std::vector<float64> Unique;
+    for (float64 x : Result)
+    {
+        if (Unique.empty() || x - Unique.back() > 1e-12 * Width) {Unique.push_back(x);}
+    }
+    return Unique;
+}
+
+_SCICXX_END
+_CSE_END
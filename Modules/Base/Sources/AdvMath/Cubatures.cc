@@ -0,0 +1,766 @@
+#include "CSE/Base/AdvMath.h"
+#include "CSE/Base/ConstLists.h"
+
+_CSE_BEGIN
+_SCICXX_BEGIN
+
+#include "Cubatures_Sobol.tbl"
+
+//////////////////////////////////// 哈希工具 ///////////////////////////////////
+
+// SplitMix64，用于从种子派生出互不相关的子种子和计数器随机数
+static uint64 __SplitMix64(uint64 x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+static uint64 __Reverse_Bits32(uint64 x)
+{
+    x = ((x >> 1) & 0x55555555ull) | ((x & 0x55555555ull) << 1);
+    x = ((x >> 2) & 0x33333333ull) | ((x & 0x33333333ull) << 2);
+    x = ((x >> 4) & 0x0F0F0F0Full) | ((x & 0x0F0F0F0Full) << 4);
+    x = ((x >> 8) & 0x00FF00FFull) | ((x & 0x00FF00FFull) << 8);
+    x = ((x >> 16) & 0x0000FFFFull) | ((x & 0x0000FFFFull) << 16);
+    return x;
+}
+
+// Laine-Karras置换，Burley改进的版本。此置换中每一位只受更低的位影响，
+// 所以将位反转后再置换即等价于一次欧文嵌套均匀置乱。
+static uint64 __Laine_Karras_Permutation(uint64 x, uint64 Seed)
+{
+    const uint64 Mask = 0xFFFFFFFFull;
+    x ^= (x * 0x3D20ADEAull) & Mask;
+    x = (x + Seed) & Mask;
+    x = (x * ((Seed >> 16) | 1)) & Mask;
+    x ^= (x * 0x05526C56ull) & Mask;
+    x ^= (x * 0x53A22864ull) & Mask;
+    return x;
+}
+
+static const float64 __Pow2_32 = 4294967296.;
+static const float64 __Pow2_53 = 9007199254740992.;
+
+//////////////////////////////////// 低差异序列 ///////////////////////////////////
+
+void QuasiRandomSequence::Generate(uint64 First, uint64 Count, std::span<float64> Points)const
+{
+    uint64 Dims = Dimensions();
+    if (Points.size() < Count * Dims) {throw std::logic_error("Output buffer is too small.");}
+    for (uint64 i = 0; i < Count; ++i)
+    {
+        Generate(First + i, Points.subspan(i * Dims, Dims));
+    }
+}
+
+SobolSequence::SobolSequence(uint64 Dimensions, bool Scramble, uint64 Seed)
+    : Dims(Dimensions), DirectionNumbers(Dimensions * Bits)
+{
+    if (!Dims || Dims > MaxDimensions)
+    {
+        throw std::logic_error("Sobol sequence supports 1 to 21 dimensions.");
+    }
+
+    // 第1维为范德科皮特序列
+    for (uint64 k = 0; k < Bits; ++k)
+    {
+        DirectionNumbers[k] = 1ull << (Bits - 1 - k);
+    }
+
+    for (uint64 d = 1; d < Dims; ++d)
+    {
+        const uint64* Row = __Sobol_Direction_Table[d - 1];
+        uint64 s = Row[0], a = Row[1];
+        uint64* V = DirectionNumbers.data() + d * Bits;
+        for (uint64 k = 0; k < min(s, Bits); ++k)
+        {
+            V[k] = Row[2 + k] << (Bits - 1 - k);
+        }
+        for (uint64 k = s; k < Bits; ++k)
+        {
+            V[k] = V[k - s] ^ (V[k - s] >> s);
+            for (uint64 j = 1; j < s; ++j)
+            {
+                if ((a >> (s - 1 - j)) & 1) {V[k] ^= V[k - j];}
+            }
+        }
+    }
+
+    if (Scramble)
+    {
+        ScrambleSeeds.resize(Dims);
+        for (uint64 d = 0; d < Dims; ++d)
+        {
+            ScrambleSeeds[d] = __SplitMix64(Seed ^ __SplitMix64(d)) & 0xFFFFFFFFull;
+        }
+    }
+}
+
+void SobolSequence::Generate(uint64 Index, std::span<float64> Point)const
+{
+    if (Index >> Bits) {throw std::logic_error("Sobol sequence index out of range.");}
+    for (uint64 d = 0; d < Dims; ++d)
+    {
+        const uint64* V = DirectionNumbers.data() + d * Bits;
+        uint64 x = 0;
+        for (uint64 i = Index, k = 0; i; i >>= 1, ++k)
+        {
+            if (i & 1) {x ^= V[k];}
+        }
+        if (!ScrambleSeeds.empty())
+        {
+            x = __Reverse_Bits32(x);
+            x = __Laine_Karras_Permutation(x, ScrambleSeeds[d]);
+            x = __Reverse_Bits32(x);
+        }
+        // 取格子中心，避免出现0
+        Point[d] = (float64(x) + 0.5) / __Pow2_32;
+    }
+}
+
+HaltonSequence::HaltonSequence(uint64 Dimensions, bool Scramble, uint64 Seed)
+    : Dims(Dimensions)
+{
+    if (!Dims) {throw std::logic_error("Dimension of Halton sequence can't be zero.");}
+
+    // 前Dims个质数
+    for (uint64 n = 2; Bases.size() < Dims; ++n)
+    {
+        bool IsPrime = true;
+        for (uint64 p : Bases)
+        {
+            if (p * p > n) {break;}
+            if (n % p == 0) {IsPrime = false; break;}
+        }
+        if (IsPrime) {Bases.push_back(n);}
+    }
+
+    // 每一维保留的位数，使最后一位的权重低于双精度的分辨率
+    uint64 Total = 0;
+    for (uint64 b : Bases)
+    {
+        DigitCounts.push_back(uint64(ceil(53. / log(float64(b), 2.))));
+        PermOffsets.push_back(Total);
+        Total += DigitCounts.back() * b;
+    }
+
+    if (Scramble)
+    {
+        Permutations.resize(Total);
+        for (uint64 d = 0; d < Dims; ++d)
+        {
+            std::mt19937_64 Engine(__SplitMix64(Seed ^ __SplitMix64(d)));
+            uint64 b = Bases[d];
+            for (uint64 k = 0; k < DigitCounts[d]; ++k)
+            {
+                uint64* Perm = Permutations.data() + PermOffsets[d] + k * b;
+                for (uint64 i = 0; i < b; ++i) {Perm[i] = i;}
+                for (uint64 i = b - 1; i > 0; --i)
+                {
+                    std::swap(Perm[i], Perm[Engine() % (i + 1)]);
+                }
+            }
+        }
+    }
+}
+
+void HaltonSequence::Generate(uint64 Index, std::span<float64> Point)const
+{
+    for (uint64 d = 0; d < Dims; ++d)
+    {
+        uint64 b = Bases[d];
+        float64 InvBase = 1. / float64(b), Weight = InvBase, Value = 0;
+        if (Permutations.empty())
+        {
+            // 不置乱时跳过原点
+            for (uint64 i = Index + 1; i; i /= b)
+            {
+                Value += float64(i % b) * Weight;
+                Weight *= InvBase;
+            }
+        }
+        else
+        {
+            // 置乱后末尾的0也会被置换，所以需要计算所有位
+            const uint64* Perm = Permutations.data() + PermOffsets[d];
+            for (uint64 k = 0, i = Index; k < DigitCounts[d]; ++k, i /= b)
+            {
+                Value += float64(Perm[k * b + i % b]) * Weight;
+                Weight *= InvBase;
+            }
+        }
+        Point[d] = clamp(Value, 1. / __Pow2_53, 1. - 1. / __Pow2_53);
+    }
+}
+
+void PseudoRandomSequence::Generate(uint64 Index, std::span<float64> Point)const
+{
+    uint64 Base = __SplitMix64(Seed ^ __SplitMix64(Index));
+    for (uint64 d = 0; d < Dims; ++d)
+    {
+        uint64 x = __SplitMix64(Base + d);
+        Point[d] = (float64(x >> 11) + 0.5) / __Pow2_53;
+    }
+}
+
+//////////////////////////////////// 拟蒙特卡洛 ///////////////////////////////////
+
+float64 __Multidimensional_Integral::MapFromUnitCube(const std::vector<BoundPairType>& Bounds,
+    std::span<const float64> Unit, std::span<float64> Point, std::vector<float64>& Pinned)
+{
+    float64 Jacobian = 1;
+    Pinned.clear();
+    for (uint64 i = 0; i < Bounds.size(); ++i)
+    {
+        float64 a = UnpackBoundary(Bounds[i].first, Pinned);
+        float64 b = UnpackBoundary(Bounds[i].second, Pinned);
+        float64 u = Unit[i], x, w;
+        if (b < a)
+        {
+            std::swap(a, b);
+            Jacobian = -Jacobian;
+        }
+
+        if (a == b)
+        {
+            x = a;
+            w = 0;
+        }
+        else if (isinf(a) && isinf(b))
+        {
+            float64 t = 2. * u - 1.;
+            x = t / (1. - t * t);
+            w = 2. * (1. + t * t) / pow(1. - t * t, 2);
+        }
+        else if (isinf(b))
+        {
+            x = a + u / (1. - u);
+            w = 1. / pow(1. - u, 2);
+        }
+        else if (isinf(a))
+        {
+            x = b - (1. - u) / u;
+            w = 1. / (u * u);
+        }
+        else
+        {
+            x = a + (b - a) * u;
+            w = b - a;
+        }
+
+        Point[i] = x;
+        Pinned.push_back(x);
+        Jacobian *= w;
+    }
+    return Jacobian;
+}
+
+std::vector<__Multidimensional_Integral::BoundPairType>
+__Multidimensional_Integral::MergeBounds(vec2 BoundaryX, const std::vector<BoundPairType>& OtherBounds)
+{
+    std::vector<BoundPairType> Bounds;
+    Bounds.reserve(OtherBounds.size() + 1);
+    Bounds.push_back({BoundaryX.x, BoundaryX.y});
+    Bounds.insert(Bounds.end(), OtherBounds.begin(), OtherBounds.end());
+    return Bounds;
+}
+
+__Multidimensional_Integral::BatchFuncType
+__Multidimensional_Integral::MakeBatch(const FuncType& Func, uint64 Dims)
+{
+    return [Func, Dims](std::span<const float64> Points, std::span<float64> Values)
+    {
+        std::vector<float64> Point(Dims);
+        for (uint64 i = 0; i < Values.size(); ++i)
+        {
+            std::copy(Points.begin() + i * Dims, Points.begin() + (i + 1) * Dims, Point.begin());
+            Values[i] = Func(Point);
+        }
+    };
+}
+
+std::vector<float64> __Multidimensional_Integral::WeightedBlockSums(const BatchFuncType& Func,
+    const std::vector<BoundPairType>& Bounds, uint64 Count, NodeGeneratorType Generator,
+    uint64 Threads)
+{
+    // 每块的点数是固定的，与线程数无关，保证结果可以复现
+    const uint64 BlockSize = 256;
+    uint64 Dims = Bounds.size();
+    uint64 Blocks = (Count + BlockSize - 1) / BlockSize;
+
+    struct Workspace
+    {
+        std::vector<float64> Unit, Points, Weights, Values, Pinned;
+    };
+    std::vector<Workspace> Workspaces(__Parallel_Workers(Blocks, Threads));
+    for (auto& w : Workspaces)
+    {
+        w.Unit.resize(BlockSize * Dims);
+        w.Points.resize(BlockSize * Dims);
+        w.Weights.resize(BlockSize);
+        w.Values.resize(BlockSize);
+        w.Pinned.reserve(Dims);
+    }
+
+    std::vector<float64> PartialSums(Blocks);
+    __Parallel_For(Blocks, [&](uint64 Block, uint64 Worker)
+    {
+        Workspace& w = Workspaces[Worker];
+        uint64 First = Block * BlockSize;
+        uint64 Size = min(BlockSize, Count - First);
+
+        std::span<float64> Unit(w.Unit.data(), Size * Dims);
+        std::span<float64> Points(w.Points.data(), Size * Dims);
+        std::span<float64> Weights(w.Weights.data(), Size);
+        Generator(First, Size, Unit, Weights);
+        for (uint64 i = 0; i < Size; ++i)
+        {
+            Weights[i] *= MapFromUnitCube(Bounds, Unit.subspan(i * Dims, Dims),
+                Points.subspan(i * Dims, Dims), w.Pinned);
+        }
+
+        Func(Points, std::span<float64>(w.Values.data(), Size));
+
+        float64 Sum = 0;
+        for (uint64 i = 0; i < Size; ++i)
+        {
+            // 权重为0的点(退化区间)不参与计算，避免0乘无穷
+            if (Weights[i] != 0) {Sum += w.Values[i] * Weights[i];}
+        }
+        PartialSums[Block] = Sum;
+    }, Threads);
+
+    return PartialSums;
+}
+
+vec2 __Multidimensional_Integral::SequenceIntegrate(BatchFuncType Func,
+    const std::vector<BoundPairType>& Bounds,
+    const std::vector<std::shared_ptr<QuasiRandomSequence>>& Sequences,
+    uint64 Samples, uint64 Threads)
+{
+    uint64 Replicates = Sequences.size();
+    std::vector<float64> Estimates(Replicates);
+    for (uint64 r = 0; r < Replicates; ++r)
+    {
+        auto Sums = WeightedBlockSums(Func, Bounds, Samples,
+            [&Seq = *Sequences[r]](uint64 First, uint64 Count, std::span<float64> Unit, std::span<float64> Weights)
+        {
+            Seq.Generate(First, Count, Unit);
+            std::fill(Weights.begin(), Weights.end(), 1.);
+        }, Threads);
+
+        // 按固定顺序归约
+        float64 Sum = 0;
+        for (float64 i : Sums) {Sum += i;}
+        Estimates[r] = Sum / float64(Samples);
+    }
+
+    float64 Mean = 0;
+    for (float64 e : Estimates) {Mean += e;}
+    Mean /= float64(Replicates);
+    if (Replicates < 2) {return {Mean, __Float64::FromBytes(BIG_NAN_DOUBLE)};}
+
+    float64 Var = 0;
+    for (float64 e : Estimates) {Var += (e - Mean) * (e - Mean);}
+    Var /= float64(Replicates - 1);
+    return {Mean, sqrt(Var / float64(Replicates))};
+}
+
+vec2 __Multidimensional_Integral::QuasiMonteCarlo(BatchFuncType Func, vec2 BoundaryX,
+    std::vector<BoundPairType> OtherBounds, float64 LogSamples, uint64 Replicates,
+    uint64 Seed, SequenceType Sequence, uint64 Threads)
+{
+    auto Bounds = MergeBounds(BoundaryX, OtherBounds);
+    uint64 Dims = Bounds.size();
+    if (!Replicates) {Replicates = 1;}
+
+    uint64 Samples = max(uint64(ceil(pow(10, LogSamples) / float64(Replicates))), 1ull);
+    if (Sequence == Sobol)
+    {
+        // 索伯序列的前2^m个点构成(t, m, s)网格，所以样本数取为2的整数次幂
+        uint64 Pow2 = 1;
+        while (Pow2 < Samples) {Pow2 <<= 1;}
+        Samples = Pow2;
+    }
+
+    std::vector<std::shared_ptr<QuasiRandomSequence>> Sequences;
+    for (uint64 r = 0; r < Replicates; ++r)
+    {
+        uint64 SubSeed = __SplitMix64(Seed + r);
+        if (Sequence == Sobol)
+        {
+            Sequences.push_back(std::make_shared<SobolSequence>(Dims, true, SubSeed));
+        }
+        else
+        {
+            Sequences.push_back(std::make_shared<HaltonSequence>(Dims, true, SubSeed));
+        }
+    }
+
+    return SequenceIntegrate(Func, Bounds, Sequences, Samples, Threads);
+}
+
+vec2 __Multidimensional_Integral::QuasiMonteCarlo(FuncType Func, vec2 BoundaryX,
+    std::vector<BoundPairType> OtherBounds, float64 LogSamples, uint64 Replicates,
+    uint64 Seed, SequenceType Sequence, uint64 Threads)
+{
+    return QuasiMonteCarlo(MakeBatch(Func, OtherBounds.size() + 1), BoundaryX, OtherBounds,
+        LogSamples, Replicates, Seed, Sequence, Threads);
+}
+
+float64 __Multidimensional_Integral::MonteCarlo(FuncType Func, vec2 BoundaryX,
+    std::vector<BoundPairType> OtherBounds, float64 LogSamples, uint64 Seed)
+{
+    auto Bounds = MergeBounds(BoundaryX, OtherBounds);
+    uint64 Dims = Bounds.size();
+    uint64 Samples = max(uint64(ceil(pow(10, LogSamples))), 1ull);
+    return SequenceIntegrate(MakeBatch(Func, Dims), Bounds,
+        {std::make_shared<PseudoRandomSequence>(Dims, Seed)}, Samples, 0).x;
+}
+
+//////////////////////////////////// 自适应求积 ///////////////////////////////////
+
+vec2 __Multidimensional_Integral::GenzMalik(BatchFuncType Func, vec2 BoundaryX,
+    std::vector<BoundPairType> OtherBounds, float64 AbsTolNLog, float64 RelTolNLog,
+    float64 MaxEvalLog, uint64 Threads)
+{
+    auto Bounds = MergeBounds(BoundaryX, OtherBounds);
+    const uint64 n = Bounds.size();
+    if (n < 2) {throw std::logic_error("Genz-Malik cubature requires at least 2 dimensions.");}
+
+    // 7次公式及嵌套的5次公式的参数
+    // [1] Genz A C, Malik A A. Remarks on algorithm 006: An adaptive algorithm for
+    //     numerical integration over an N-dimensional rectangular region[J]. Journal
+    //     of Computational and Applied Mathematics, 1980, 6(4): 295-302.
+    const float64 N = float64(n);
+    const float64 Lambda2 = sqrt(9. / 70.), Lambda3 = sqrt(9. / 10.),
+        Lambda4 = sqrt(9. / 10.), Lambda5 = sqrt(9. / 19.);
+    const float64 W7[5] =
+    {
+        (12824. - 9120. * N + 400. * N * N) / 19683.,
+        980. / 6561.,
+        (1820. - 400. * N) / 19683.,
+        200. / 19683.,
+        6859. / 19683. / pow(2, N)
+    };
+    const float64 W5[5] =
+    {
+        (729. - 950. * N + 50. * N * N) / 729.,
+        245. / 486.,
+        (265. - 100. * N) / 1458.,
+        25. / 729.,
+        0
+    };
+
+    // 节点相对于子区域中心的偏移(以半宽为单位)，以及每个节点所属的类别，节点依次为：
+    // 中心，±λ2沿各轴，±λ3沿各轴，±λ4沿每两个轴，±λ5的所有顶点
+    std::vector<float64> Offsets;
+    std::vector<uint64> Classes;
+    auto AddNode = [&](uint64 Class)
+    {
+        Offsets.resize(Offsets.size() + n, 0);
+        Classes.push_back(Class);
+        return Offsets.end() - n;
+    };
+    AddNode(0);
+    for (uint64 i = 0; i < n; ++i)
+    {
+        AddNode(1)[i] = Lambda2;
+        AddNode(1)[i] = -Lambda2;
+    }
+    for (uint64 i = 0; i < n; ++i)
+    {
+        AddNode(2)[i] = Lambda3;
+        AddNode(2)[i] = -Lambda3;
+    }
+    for (uint64 i = 0; i < n; ++i)
+    {
+        for (uint64 j = i + 1; j < n; ++j)
+        {
+            for (float64 si : {Lambda4, -Lambda4})
+            {
+                for (float64 sj : {Lambda4, -Lambda4})
+                {
+                    auto It = AddNode(3);
+                    It[i] = si;
+                    It[j] = sj;
+                }
+            }
+        }
+    }
+    for (uint64 k = 0; k < (1ull << n); ++k)
+    {
+        auto It = AddNode(4);
+        for (uint64 i = 0; i < n; ++i) {It[i] = ((k >> i) & 1) ? -Lambda5 : Lambda5;}
+    }
+    const uint64 P = Classes.size();
+    const float64 Ratio = (Lambda2 * Lambda2) / (Lambda3 * Lambda3);
+
+    // 子区域，所有数据按编号平铺存储
+    std::vector<float64> Centers, HalfWidths, Values, Errors;
+    std::vector<uint64> SplitAxes;
+    auto NewRegion = [&]()
+    {
+        Centers.resize(Centers.size() + n);
+        HalfWidths.resize(HalfWidths.size() + n);
+        Values.push_back(0);
+        Errors.push_back(0);
+        SplitAxes.push_back(0);
+        return Values.size() - 1;
+    };
+
+    struct Workspace
+    {
+        std::vector<float64> Unit, Points, Weights, Values, Pinned;
+    };
+    std::vector<Workspace> Workspaces(__Parallel_Workers(32, Threads));
+    for (auto& w : Workspaces)
+    {
+        w.Unit.resize(P * n);
+        w.Points.resize(P * n);
+        w.Weights.resize(P);
+        w.Values.resize(P);
+        w.Pinned.reserve(n);
+    }
+
+    auto Evaluate = [&](uint64 Region, Workspace& w)
+    {
+        const float64* c = Centers.data() + Region * n;
+        const float64* h = HalfWidths.data() + Region * n;
+        float64 Volume = 1;
+        for (uint64 i = 0; i < n; ++i) {Volume *= 2. * h[i];}
+
+        for (uint64 k = 0; k < P; ++k)
+        {
+            for (uint64 i = 0; i < n; ++i)
+            {
+                w.Unit[k * n + i] = c[i] + h[i] * Offsets[k * n + i];
+            }
+            w.Weights[k] = MapFromUnitCube(Bounds, std::span<const float64>(w.Unit).subspan(k * n, n),
+                std::span<float64>(w.Points).subspan(k * n, n), w.Pinned);
+        }
+        Func(w.Points, w.Values);
+        for (uint64 k = 0; k < P; ++k)
+        {
+            w.Values[k] = (w.Weights[k] != 0) ? w.Values[k] * w.Weights[k] : 0;
+        }
+
+        float64 I7 = 0, I5 = 0;
+        for (uint64 k = 0; k < P; ++k)
+        {
+            I7 += W7[Classes[k]] * w.Values[k];
+            I5 += W5[Classes[k]] * w.Values[k];
+        }
+        Values[Region] = Volume * I7;
+        Errors[Region] = Volume * abs(I7 - I5);
+
+        // 沿四阶差分最大的轴分割，差分相同时分割最宽的轴
+        const float64 f0 = w.Values[0];
+        uint64 Axis = 0;
+        float64 MaxDiff = -1;
+        for (uint64 i = 0; i < n; ++i)
+        {
+            float64 D2 = w.Values[1 + 2 * i] + w.Values[2 + 2 * i] - 2. * f0;
+            float64 D3 = w.Values[1 + 2 * n + 2 * i] + w.Values[2 + 2 * n + 2 * i] - 2. * f0;
+            float64 Diff = abs(D2 - Ratio * D3);
+            if (Diff > MaxDiff || (Diff == MaxDiff && h[i] > h[Axis]))
+            {
+                MaxDiff = Diff;
+                Axis = i;
+            }
+        }
+        SplitAxes[Region] = Axis;
+    };
+
+    uint64 Root = NewRegion();
+    std::fill(Centers.begin(), Centers.end(), 0.5);
+    std::fill(HalfWidths.begin(), HalfWidths.end(), 0.5);
+    Evaluate(Root, Workspaces[0]);
+
+    // 以误差为键的最大堆，误差相同时编号小的优先
+    auto Compare = [&](uint64 a, uint64 b)
+    {
+        return Errors[a] < Errors[b] || (Errors[a] == Errors[b] && a > b);
+    };
+    std::vector<uint64> Heap{Root};
+
+    const uint64 MaxEval = uint64(floor(pow(10, MaxEvalLog)));
+    const uint64 MaxBatch = 16; // 每次分割的子区域数，与线程数无关
+    const float64 AbsTol = pow(10, -AbsTolNLog), RelTol = pow(10, -RelTolNLog);
+    uint64 Evaluations = P;
+    float64 Value = Values[Root], Error = Errors[Root];
+    std::vector<uint64> Parents, Children;
+
+    while (Error > max(AbsTol, RelTol * abs(Value)))
+    {
+        uint64 Batch = min(min(MaxBatch, uint64(Heap.size())), (MaxEval - min(Evaluations, MaxEval)) / (2 * P));
+        if (!Batch) {break;}
+
+        Parents.clear();
+        Children.clear();
+        for (uint64 k = 0; k < Batch; ++k)
+        {
+            std::pop_heap(Heap.begin(), Heap.end(), Compare);
+            Parents.push_back(Heap.back());
+            Heap.pop_back();
+        }
+
+        for (uint64 Parent : Parents)
+        {
+            uint64 Axis = SplitAxes[Parent];
+            for (float64 Side : {-0.5, 0.5})
+            {
+                uint64 Child = NewRegion();
+                for (uint64 i = 0; i < n; ++i)
+                {
+                    Centers[Child * n + i] = Centers[Parent * n + i];
+                    HalfWidths[Child * n + i] = HalfWidths[Parent * n + i];
+                }
+                HalfWidths[Child * n + Axis] *= 0.5;
+                Centers[Child * n + Axis] += Side * HalfWidths[Parent * n + Axis];
+                Children.push_back(Child);
+            }
+        }
+
+        __Parallel_For(Children.size(), [&](uint64 Task, uint64 Worker)
+        {
+            Evaluate(Children[Task], Workspaces[Worker]);
+        }, Threads);
+        Evaluations += Children.size() * P;
+
+        for (uint64 Child : Children)
+        {
+            Heap.push_back(Child);
+            std::push_heap(Heap.begin(), Heap.end(), Compare);
+        }
+
+        // 按编号顺序重新求和，避免累计误差
+        Value = 0;
+        Error = 0;
+        std::vector<uint64>& Active = Parents; // 复用缓冲区
+        Active.assign(Heap.begin(), Heap.end());
+        std::sort(Active.begin(), Active.end());
+        for (uint64 i : Active)
+        {
+            Value += Values[i];
+            Error += Errors[i];
+        }
+    }
+
+    return {Value, Error};
+}
+
+vec2 __Multidimensional_Integral::GenzMalik(FuncType Func, vec2 BoundaryX,
+    std::vector<BoundPairType> OtherBounds, float64 AbsTolNLog, float64 RelTolNLog,
+    float64 MaxEvalLog, uint64 Threads)
+{
+    return GenzMalik(MakeBatch(Func, OtherBounds.size() + 1), BoundaryX, OtherBounds,
+        AbsTolNLog, RelTolNLog, MaxEvalLog, Threads);
+}
+
+//////////////////////////////////// 张量积求积 ///////////////////////////////////
+
+// (0, 1)区间上的n点高斯-勒让德节点和权重。高斯-克朗罗德积分中的求根方法在点数为奇数或者
+// 点数较多时不稳定，此处使用三项递推式配合牛顿迭代计算，对任意点数都有效。
+static std::vector<vec2> __Gauss_Legendre_Unit_Nodes(uint64 n)
+{
+    std::vector<vec2> Result(n);
+    for (uint64 i = 0; i < (n + 1) / 2; ++i)
+    {
+        float64 x = cos(Angle::FromRadians(CSE_PI * (float64(i) + 0.75) / (float64(n) + 0.5)));
+        float64 dp = 0;
+        for (int Iter = 0; Iter < 100; ++Iter)
+        {
+            // P(n)及其导数
+            float64 p0 = 1, p1 = x;
+            for (uint64 k = 2; k <= n; ++k)
+            {
+                float64 p2 = ((2. * k - 1.) * x * p1 - (k - 1.) * p0) / float64(k);
+                p0 = p1;
+                p1 = p2;
+            }
+            dp = float64(n) * (x * p1 - p0) / (x * x - 1.);
+            float64 dx = p1 / dp;
+            x -= dx;
+            if (abs(dx) < 1e-16) {break;}
+        }
+        float64 w = 1. / ((1. - x * x) * dp * dp); // 即2/((1-x^2)P'^2)的一半
+        Result[i] = {0.5 - x / 2., w};
+        Result[n - 1 - i] = {0.5 + x / 2., w};
+    }
+    return Result;
+}
+
+__Multidimensional_Integral::TensorProductGrid::TensorProductGrid(vec2 BoundaryX,
+    std::vector<BoundPairType> OtherBounds, std::vector<uint64> Points)
+{
+    auto Bounds = MergeBounds(BoundaryX, OtherBounds);
+    Dims = Bounds.size();
+    if (Points.size() == 1) {Points.resize(Dims, Points[0]);}
+    if (Points.size() != Dims) {throw std::logic_error("Number of points mismatch with dimensions.");}
+
+    // 各轴上(0, 1)区间内的高斯-勒让德节点和权重
+    std::vector<std::vector<vec2>> Axes(Dims);
+    uint64 Count = 1;
+    for (uint64 d = 0; d < Dims; ++d)
+    {
+        if (!Points[d]) {throw std::logic_error("Number of points can't be zero.");}
+        Axes[d] = __Gauss_Legendre_Unit_Nodes(Points[d]);
+        Count *= Axes[d].size();
+    }
+
+    Nodes.resize(Count * Dims);
+    Weights.resize(Count);
+    std::vector<float64> Unit(Dims), Pinned;
+    Pinned.reserve(Dims);
+    for (uint64 Index = 0; Index < Count; ++Index)
+    {
+        // 按混合进制分解下标，最后一轴变化最快
+        float64 Weight = 1;
+        for (uint64 d = Dims, i = Index; d-- > 0; i /= Axes[d].size())
+        {
+            const vec2& Node = Axes[d][i % Axes[d].size()];
+            Unit[d] = Node.x;
+            Weight *= Node.y;
+        }
+        Weights[Index] = Weight * MapFromUnitCube(Bounds, Unit,
+            std::span<float64>(Nodes).subspan(Index * Dims, Dims), Pinned);
+    }
+}
+
+float64 __Multidimensional_Integral::TensorProductGrid::operator()(BatchFuncType Func, uint64 Threads)const
+{
+    const uint64 BlockSize = 256;
+    uint64 Count = Weights.size();
+    uint64 Blocks = (Count + BlockSize - 1) / BlockSize;
+
+    std::vector<std::vector<float64>> Buffers(__Parallel_Workers(Blocks, Threads),
+        std::vector<float64>(BlockSize));
+    std::vector<float64> PartialSums(Blocks);
+    __Parallel_For(Blocks, [&](uint64 Block, uint64 Worker)
+    {
+        uint64 First = Block * BlockSize;
+        uint64 Size = min(BlockSize, Count - First);
+        std::span<float64> Values(Buffers[Worker].data(), Size);
+        Func(std::span<const float64>(Nodes).subspan(First * Dims, Size * Dims), Values);
+        float64 Sum = 0;
+        for (uint64 i = 0; i < Size; ++i)
+        {
+            if (Weights[First + i] != 0) {Sum += Weights[First + i] * Values[i];}
+        }
+        PartialSums[Block] = Sum;
+    }, Threads);
+
+    float64 Sum = 0;
+    for (float64 i : PartialSums) {Sum += i;}
+    return Sum;
+}
+
+float64 __Multidimensional_Integral::TensorProductGrid::operator()(FuncType Func, uint64 Threads)const
+{
+    return (*this)(MakeBatch(Func, Dims), Threads);
+}
+_SCICXX_END
+_CSE_END
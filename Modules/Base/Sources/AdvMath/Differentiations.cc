@@ -189,12 +189,15 @@ bool Adaptive1stOrderFDDerivativeFunction::Iterator::CheckTerminate()
     return 0;
 }
 
-float64 Adaptive1stOrderFDDerivativeFunction::operator()(float64 x)const
+Adaptive1stOrderFDDerivativeFunction::Iterator Adaptive1stOrderFDDerivativeFunction::CreateIterator(float64 x, float64 fx)const
 {
     Iterator it;
     it.Input = x;
     it.Intermediates.resize({1, 1});
-    it.Intermediates.at(0, 0) = OriginalFunction(x);
+    it.Intermediates.at(0, 0) = fx;
+    // 第一次迭代时还没有上一次的结果，置为NaN使误差增大的检测不会被误触发
+    it.Output = __Float64::FromBytes(BIG_NAN_DOUBLE);
+    it.Error = __Float64::FromBytes(BIG_NAN_DOUBLE);
     it.Step = InitialStepSize;
     it.StepFactor = StepFactor;
     it.AbsoluteTolerence = pow(10, -AbsoluteTolerence);
@@ -202,11 +205,232 @@ float64 Adaptive1stOrderFDDerivativeFunction::operator()(float64 x)const
     it.State = Iterator::InProgress;
     it.Terms = uint64(FDMOrder + 1) / 2ULL;
     it.Direction = Direction;
+    return it;
+}
+
+float64 Adaptive1stOrderFDDerivativeFunction::operator()(float64 x)const
+{
+    Iterator it = CreateIterator(x, OriginalFunction(x));
     it.Run(OriginalFunction, MaxIteration);
     return it.State == it.Finished ? it.Output : it.LastOutput;
 }
 
+void Adaptive1stOrderFDDerivativeFunction::BatchIterator::PreEvaluator(std::span<const uint64> Lanes, std::vector<float64>& x)
+{
+    for (uint64 Lane : Lanes)
+    {
+        DynamicMatrix<float64> Points = Items[Lane].PreEvaluator();
+        for (uint64 i = 0; i < Points.row(); ++i) {x.push_back(Points.at(0, i));}
+    }
+}
+
+void Adaptive1stOrderFDDerivativeFunction::BatchIterator::PostEvaluator(std::span<const uint64> Lanes,
+    std::span<const float64> x, std::span<const float64> fx)
+{
+    uint64 n = x.size() / Lanes.size();
+    DynamicMatrix<float64> xm({1, n}), fxm({1, n});
+    for (uint64 i = 0; i < Lanes.size(); ++i)
+    {
+        for (uint64 j = 0; j < n; ++j)
+        {
+            xm.at(0, j) = x[i * n + j];
+            fxm.at(0, j) = fx[i * n + j];
+        }
+        Iterator& it = Items[Lanes[i]];
+        it.PostEvaluator(xm, fxm);
+        it.EvaluateCount += n;
+        ++it.IterCount;
+    }
+}
+
+void Adaptive1stOrderFDDerivativeFunction::BatchIterator::Conditioner(std::span<const uint64> Lanes, std::span<bool> Terminate)
+{
+    for (uint64 i = 0; i < Lanes.size(); ++i)
+    {
+        Terminate[i] = Items[Lanes[i]].CheckTerminate();
+    }
+}
+
+void Adaptive1stOrderFDDerivativeFunction::BatchIterator::Finalize(std::span<const uint64> Lanes)
+{
+    for (uint64 Lane : Lanes) {Items[Lane].Finalize();}
+}
+
+void Adaptive1stOrderFDDerivativeFunction::operator()(std::span<const float64> x, std::span<float64> Out, uint64 Threads)const
+{
+    if (x.size() != Out.size()) {throw std::logic_error("Size of output mismatch.");}
+    if (x.empty()) {return;}
+
+    BatchFuncType Function = BatchFunction;
+    if (!Function)
+    {
+        Function = [this, Threads](std::span<const float64> x, std::span<float64> fx)
+        {
+            __Parallel_For(x.size(), [&](uint64 i, uint64){fx[i] = OriginalFunction(x[i]);}, Threads);
+        };
+    }
+
+    std::vector<float64> fx(x.size());
+    Function(x, fx);
+
+    BatchIterator Batch;
+    Batch.Lanes = x.size();
+    for (uint64 i = 0; i < x.size(); ++i) {Batch.Items.push_back(CreateIterator(x[i], fx[i]));}
+    Batch.Run(Function, MaxIteration);
+
+    for (uint64 i = 0; i < x.size(); ++i)
+    {
+        const Iterator& it = Batch.Items[i];
+        Out[i] = it.State == it.Finished ? it.Output : it.LastOutput;
+    }
+}
+
+
+
+/////////////////////////////////// 雅可比矩阵 ///////////////////////////////////
+
+JacobianEngine::JacobianEngine(FuncType Func, uint64 InDims, uint64 OutDims)
+    : JacobianEngine(InDims, OutDims)
+{
+    PointFunction = Func;
+}
+
+JacobianEngine::JacobianEngine(ComplexFuncType Func, uint64 InDims, uint64 OutDims)
+    : JacobianEngine(InDims, OutDims)
+{
+    ComplexFunction = Func;
+    PointFunction = [Func, InDims, OutDims](std::span<const float64> x, std::span<float64> fx)
+    {
+        std::vector<complex64> cx(x.begin(), x.end()), cfx(OutDims);
+        Func(cx, cfx);
+        for (uint64 i = 0; i < OutDims; ++i) {fx[i] = cfx[i].real();}
+    };
+}
+
+JacobianEngine JacobianEngine::Batched(BatchFuncType Func, uint64 InDims, uint64 OutDims)
+{
+    JacobianEngine Engine(InDims, OutDims);
+    Engine.BatchFunction = Func;
+    return Engine;
+}
+
+float64 JacobianEngine::RelativeStep()const
+{
+    // 截断误差为O(h^p)时，截断误差与舍入误差ε/h平衡处h ~ ε^(1 / (p + 1))
+    float64 p = Method == Central ? 2. * (RichardsonLevels + 1) : float64(RichardsonLevels + 1);
+    return pow(DOUBLE_EPSILON, 1. / (p + 1.));
+}
+
+void JacobianEngine::Evaluate(std::span<const float64> Points, std::span<float64> Values)const
+{
+    if (BatchFunction)
+    {
+        BatchFunction(Points, Values);
+        return;
+    }
+    __Parallel_For(Points.size() / InputDims, [&](uint64 k, uint64)
+    {
+        PointFunction(Points.subspan(k * InputDims, InputDims),
+            Values.subspan(k * OutputDims, OutputDims));
+    }, Threads);
+}
+
+void JacobianEngine::operator()(std::span<const float64> x, DynamicMatrix<float64>& Jacobian,
+    std::span<const float64> fx)const
+{
+    uint64 n = InputDims, m = OutputDims;
+    if (x.size() != n) {throw std::logic_error("Dimension of x mismatch.");}
+    if (!fx.empty() && fx.size() != m) {throw std::logic_error("Dimension of f(x) mismatch.");}
+    if (Jacobian.col() != n || Jacobian.row() != m) {Jacobian.resize({n, m});}
+
+    if (Method == ComplexStep)
+    {
+        if (!ComplexFunction) {throw std::logic_error("Complex-step requires a complex function.");}
+        const float64 h = 1e-20;
+        uint64 Workers = __Parallel_Workers(n, Threads);
+        std::vector<std::vector<complex64>> X(Workers, std::vector<complex64>(x.begin(), x.end()));
+        std::vector<std::vector<complex64>> F(Workers, std::vector<complex64>(m));
+        __Parallel_For(n, [&](uint64 j, uint64 w)
+        {
+            float64 hj = h * max(abs(x[j]), 1.);
+            X[w][j] = complex64(x[j], hj);
+            ComplexFunction(X[w], F[w]);
+            X[w][j] = x[j];
+            for (uint64 i = 0; i < m; ++i) {Jacobian.at(j, i) = F[w][i].imag() / hj;}
+        }, Threads);
+        return;
+    }
+
+    if (!PointFunction && !BatchFunction) {throw std::logic_error("Function is undefined.");}
 
+    // 生成全部扰动点，每列依次为各层步长的扰动(中心差分为先负后正)，向前差分最后附加x本身
+    uint64 Levels = RichardsonLevels + 1;
+    uint64 PerLevel = Method == Central ? 2 : 1;
+    bool NeedCenter = Method == Forward && fx.empty();
+    uint64 Count = n * Levels * PerLevel + NeedCenter;
+    std::vector<float64> Points(Count * n), Values(Count * m), Steps(n * Levels);
+
+    float64 s = RelativeStep();
+    for (uint64 j = 0; j < n; ++j)
+    {
+        float64 h = s * max(abs(x[j]), 1.);
+        for (uint64 l = 0; l < Levels; ++l, h /= 2.)
+        {
+            volatile float64 Shifted = x[j] + h; // 保证步长可以精确表示
+            float64 hl = Shifted - x[j];
+            Steps[j * Levels + l] = hl;
+            for (uint64 k = 0; k < PerLevel; ++k)
+            {
+                uint64 Index = (j * Levels + l) * PerLevel + k;
+                float64* Point = Points.data() + Index * n;
+                std::copy(x.begin(), x.end(), Point);
+                Point[j] += (PerLevel == 2 && !k) ? -hl : hl;
+            }
+        }
+    }
+    if (NeedCenter) {std::copy(x.begin(), x.end(), Points.end() - n);}
+
+    Evaluate(Points, Values);
+
+    std::span<const float64> f0 = NeedCenter ?
+        std::span<const float64>(Values.end() - m, Values.end()) : fx;
+    std::vector<float64> D(Levels);
+    for (uint64 j = 0; j < n; ++j)
+    {
+        for (uint64 i = 0; i < m; ++i)
+        {
+            for (uint64 l = 0; l < Levels; ++l)
+            {
+                uint64 Index = (j * Levels + l) * PerLevel;
+                float64 hl = Steps[j * Levels + l];
+                D[l] = Method == Central ?
+                    (Values[(Index + 1) * m + i] - Values[Index * m + i]) / (2. * hl) :
+                    (Values[Index * m + i] - f0[i]) / hl;
+            }
+            // 理查森外推，中心差分每层消去h^2k项，向前差分每层消去h^k项
+            for (uint64 k = 1; k < Levels; ++k)
+            {
+                float64 Factor = float64(1ULL << (Method == Central ? 2 * k : k)) - 1.;
+                for (uint64 l = 0; l + k < Levels; ++l)
+                {
+                    D[l] = D[l + 1] + (D[l + 1] - D[l]) / Factor;
+                }
+            }
+            Jacobian.at(j, i) = D[0];
+        }
+    }
+}
+
+void JacobianEngine::Gradient(std::span<const float64> x, std::span<float64> Out,
+    std::optional<float64> fx)const
+{
+    if (OutputDims != 1) {throw std::logic_error("Gradient is only defined for scalar functions.");}
+    if (Out.size() != InputDims) {throw std::logic_error("Size of output mismatch.");}
+    DynamicMatrix<float64> J({InputDims, 1});
+    float64 f0 = fx ? *fx : 0;
+    (*this)(x, J, fx ? std::span<const float64>(&f0, 1) : std::span<const float64>());
+    for (uint64 j = 0; j < InputDims; ++j) {Out[j] = J.at(j, 0);}
+}
 
 //////////////////////////////// 黎曼-刘维尔导数 ////////////////////////////////
 
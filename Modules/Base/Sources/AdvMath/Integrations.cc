@@ -22,6 +22,13 @@ float64 DefiniteIntegratingFunction::operator()(Function1D f, float64 a, float64
         Scale = -1;
     }
 
+    // 引擎自己处理无穷积分限
+    if (NativeInfiniteLimits() && (isinf(a) || isinf(b)))
+    {
+        if ((isinf(a) && a > 0) || (isinf(b) && b < 0)) {throw std::logic_error("Invalid limits");}
+        return Scale * Run(f, a, b);
+    }
+
     // 无穷积分转化为-1到1的积分
     if (isinf(a) && isinf(b))
     {
@@ -455,6 +462,174 @@ float64 GaussKronrodQuadrature::GaussKronrodIntegrate(Function1D f, float64 a, f
 
 
 
+/////////////////////////////////// 双指数积分 //////////////////////////////////
+
+// 双指数积分的节点表，每层按t从小到大分为右(t > 0)左(t < 0)两侧存放，第0层步长为1。
+// tanh-sinh代换中X为节点到端点的距离(已除以区间半长)，其他两种代换中X为节点坐标。
+struct __Double_Exponential_Nodes
+{
+    std::vector<float64> T, X, W;
+};
+
+struct __Double_Exponential_Table
+{
+    float64 CenterX, CenterW;
+    std::vector<__Double_Exponential_Nodes> Right, Left;
+};
+
+struct __Double_Exponential_Tables
+{
+    __Double_Exponential_Table TanhSinh, ExpSinh, SinhSinh;
+};
+
+static const __Double_Exponential_Tables& __Get_Double_Exponential_Tables()
+{
+    static const __Double_Exponential_Tables Tables = []()
+    {
+        // 超过此值后所有代换的节点或权重都已经上溢或下溢
+        const float64 TMax = 6.5;
+        const float64 HalfPi = CSE_PI_D2;
+        __Double_Exponential_Tables Result;
+        Result.TanhSinh = {1, HalfPi, {}, {}};
+        Result.ExpSinh = {1, HalfPi, {}, {}};
+        Result.SinhSinh = {0, HalfPi, {}, {}};
+
+        for (auto Table : {&Result.TanhSinh, &Result.ExpSinh, &Result.SinhSinh})
+        {
+            Table->Right.resize(TanhSinhQuadrature::MaxTableLevels + 1);
+            Table->Left.resize(TanhSinhQuadrature::MaxTableLevels + 1);
+        }
+
+        auto Push = [](__Double_Exponential_Nodes& Nodes, float64 t, float64 x, float64 w)
+        {
+            Nodes.T.push_back(t);
+            Nodes.X.push_back(x);
+            Nodes.W.push_back(w);
+        };
+
+        for (uint64 Level = 0; Level <= TanhSinhQuadrature::MaxTableLevels; ++Level)
+        {
+            float64 h = pow(2, -float64(Level));
+            // 第0层取所有整数点，之后每层只取奇数倍步长的点
+            uint64 Stride = Level ? 2 : 1;
+            for (uint64 j = 1; float64(j) * h <= TMax; j += Stride)
+            {
+                float64 t = float64(j) * h;
+                float64 u = HalfPi * sinh(t);
+                float64 ch = cosh(t);
+                float64 eu = exp(-u);
+
+                // tanh-sinh: 1 - tanh(u) = exp(-u) / cosh(u)
+                float64 Comp = 2. * eu * eu / (1. + eu * eu);
+                float64 sech = 2. * eu / (1. + eu * eu);
+                float64 w = HalfPi * ch * sech * sech;
+                if (Comp > 0 && w > 0)
+                {
+                    Push(Result.TanhSinh.Right[Level], t, Comp, w);
+                    Push(Result.TanhSinh.Left[Level], t, Comp, w);
+                }
+
+                // exp-sinh: x = exp(u)
+                float64 xr = exp(u), xl = eu;
+                if (!isinf(xr * ch)) {Push(Result.ExpSinh.Right[Level], t, xr, HalfPi * ch * xr);}
+                if (xl * ch > 0) {Push(Result.ExpSinh.Left[Level], t, xl, HalfPi * ch * xl);}
+
+                // sinh-sinh: x = sinh(u)
+                float64 xs = sinh(u), ws = HalfPi * ch * cosh(u);
+                if (!isinf(xs) && !isinf(ws))
+                {
+                    Push(Result.SinhSinh.Right[Level], t, xs, ws);
+                    Push(Result.SinhSinh.Left[Level], t, -xs, ws);
+                }
+            }
+        }
+        return Result;
+    }();
+    return Tables;
+}
+
+// 通用的分层梯形求和，Map将表中的X值映射为被积函数的自变量
+template<typename MapFunc>
+static float64 __Double_Exponential_Integrate(const Function1D& f, const __Double_Exponential_Table& Table,
+    MapFunc Map, float64 Scale, uint64 MaxLevels, float64 Tolerence, float64* LastError, float64* L1Norm)
+{
+    MaxLevels = min(MaxLevels, TanhSinhQuadrature::MaxTableLevels);
+    float64 Cutoff[2] = {__Float64::FromBytes(POS_INF_DOUBLE), __Float64::FromBytes(POS_INF_DOUBLE)};
+
+    auto SumLevel = [&](uint64 Level, float64& Sum, float64& L1)
+    {
+        for (int Side = 0; Side < 2; ++Side)
+        {
+            const auto& Nodes = Side ? Table.Left[Level] : Table.Right[Level];
+            for (uint64 i = 0; i < Nodes.T.size() && Nodes.T[i] < Cutoff[Side]; ++i)
+            {
+                float64 y = f(Map(Nodes.X[i], Side));
+                if (!isfinite(y))
+                {
+                    // 端点处的奇点，此侧更靠外的节点全部舍弃
+                    Cutoff[Side] = Nodes.T[i];
+                    break;
+                }
+                Sum += Nodes.W[i] * y;
+                L1 += Nodes.W[i] * abs(y);
+            }
+        }
+    };
+
+    float64 h = 1;
+    float64 fc = f(Map(Table.CenterX, 0));
+    if (!isfinite(fc)) {throw std::logic_error("Integrand is not finite at the center of interval.");}
+    float64 Sum = Table.CenterW * fc, L1 = Table.CenterW * abs(fc);
+    SumLevel(0, Sum, L1);
+    float64 Result = Scale * h * Sum, ResultL1 = abs(Scale) * h * L1;
+    float64 Error = __Float64::FromBytes(POS_INF_DOUBLE);
+
+    for (uint64 Level = 1; Level <= MaxLevels; ++Level)
+    {
+        h /= 2.;
+        float64 NewSum = 0, NewL1 = 0;
+        SumLevel(Level, NewSum, NewL1);
+        float64 NewResult = Result / 2. + Scale * h * NewSum;
+        ResultL1 = ResultL1 / 2. + abs(Scale) * h * NewL1;
+        Error = abs(NewResult - Result);
+        Result = NewResult;
+        if (Level >= 3 && Error <= pow(10, -Tolerence) * ResultL1) {break;}
+    }
+
+    if (LastError) {*LastError = Error;}
+    if (L1Norm) {*L1Norm = ResultL1;}
+    return Result;
+}
+
+float64 TanhSinhQuadrature::Run(Function1D f, float64 a, float64 b)const
+{
+    if (isinf(a) && isinf(b)) {return SinhSinh(f);}
+    if (isinf(b)) {return ExpSinh(f, a);}
+    if (isinf(a)) {return ExpSinh([&f](float64 x){return f(-x);}, -b);}
+    return TanhSinh(f, a, b);
+}
+
+float64 TanhSinhQuadrature::TanhSinh(Function1D f, float64 a, float64 b, float64* LastError, float64* L1Norm)const
+{
+    float64 Half = (b - a) / 2.;
+    // 右侧的节点从b向内计算，左侧从a向内计算
+    return __Double_Exponential_Integrate(f, __Get_Double_Exponential_Tables().TanhSinh,
+        [a, b, Half](float64 Comp, int Side){return Side ? a + Half * Comp : b - Half * Comp;},
+        Half, MaxLevels, Tolerence, LastError, L1Norm);
+}
+
+float64 TanhSinhQuadrature::ExpSinh(Function1D f, float64 a, float64* LastError, float64* L1Norm)const
+{
+    return __Double_Exponential_Integrate(f, __Get_Double_Exponential_Tables().ExpSinh,
+        [a](float64 x, int){return a + x;}, 1, MaxLevels, Tolerence, LastError, L1Norm);
+}
+
+float64 TanhSinhQuadrature::SinhSinh(Function1D f, float64* LastError, float64* L1Norm)const
+{
+    return __Double_Exponential_Integrate(f, __Get_Double_Exponential_Tables().SinhSinh,
+        [](float64 x, int){return x;}, 1, MaxLevels, Tolerence, LastError, L1Norm);
+}
+
 ///////////////////////////////// 牛顿-科特斯积分 ////////////////////////////////
 
 #include "Integrations_NewtonCotes.tbl"
@@ -710,6 +885,255 @@ float64 NewtonCotesFormulae::Romberg(std::vector<vec2> Samples, DynamicMatrix<fl
     return R.at(k, k);
 }
 
+// ---------------------------------- 采样数据 ---------------------------------- //
+
+// 使用4个累加器求和，打断加法的依赖链，便于编译器生成向量指令
+static float64 __Newton_Cotes_Strided_Sum(const float64* p, uint64 Count, uint64 Stride)
+{
+    float64 s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    uint64 i = 0;
+    for (; i + 4 <= Count; i += 4)
+    {
+        s0 += p[(i + 0) * Stride];
+        s1 += p[(i + 1) * Stride];
+        s2 += p[(i + 2) * Stride];
+        s3 += p[(i + 3) * Stride];
+    }
+    for (; i < Count; ++i) {s0 += p[i * Stride];}
+    return (s0 + s1) + (s2 + s3);
+}
+
+static void __Newton_Cotes_Check_Samples(std::span<const float64> x, std::span<const float64> y, uint64 MinSize)
+{
+    if (x.size() != y.size()) {throw std::logic_error("Size of x and y mismatch.");}
+    if (y.size() < MinSize) {throw std::logic_error(MinSize == 2 ?
+        "need at least 2 sample points" : "need at least 3 sample points");}
+}
+
+bool NewtonCotesFormulae::IsEvenlySized(std::span<const float64> x)
+{
+    if (x.size() <= 2) {return 1;}
+    auto Step = x[1] - x[0];
+    for (uint64 i = 2; i < x.size(); ++i)
+    {
+        if (abs((x[i] - x[i - 1]) - Step) >= DOUBLE_EPSILON) {return 0;}
+    }
+    return 1;
+}
+
+float64 NewtonCotesFormulae::Trapezoidal(std::span<const float64> x, std::span<const float64> y)
+{
+    __Newton_Cotes_Check_Samples(x, y, 2);
+    uint64 n = y.size();
+    float64 s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    uint64 i = 1;
+    for (; i + 4 <= n; i += 4)
+    {
+        s0 += (x[i + 0] - x[i - 1]) * (y[i + 0] + y[i - 1]);
+        s1 += (x[i + 1] - x[i + 0]) * (y[i + 1] + y[i + 0]);
+        s2 += (x[i + 2] - x[i + 1]) * (y[i + 2] + y[i + 1]);
+        s3 += (x[i + 3] - x[i + 2]) * (y[i + 3] + y[i + 2]);
+    }
+    for (; i < n; ++i) {s0 += (x[i] - x[i - 1]) * (y[i] + y[i - 1]);}
+    return ((s0 + s1) + (s2 + s3)) / 2.;
+}
+
+float64 NewtonCotesFormulae::Trapezoidal(std::span<const float64> y, float64 h)
+{
+    if (y.size() < 2) {throw std::logic_error("need at least 2 sample points");}
+    uint64 n = y.size();
+    return h * (__Newton_Cotes_Strided_Sum(y.data() + 1, n - 2, 1) + (y[0] + y[n - 1]) / 2.);
+}
+
+float64 NewtonCotesFormulae::Simpson(std::span<const float64> x, std::span<const float64> y)
+{
+    __Newton_Cotes_Check_Samples(x, y, 3);
+    uint64 N = y.size() - 1;
+    uint64 Even = N - N % 2; // 使用辛普森公式的区间数
+
+    float64 Result[2] = {0, 0};
+    for (uint64 i = 0; i < Even; i += 2)
+    {
+        float64 h0 = x[i + 1] - x[i];
+        float64 h1 = x[i + 2] - x[i + 1];
+        float64 hsum = h0 + h1;
+        Result[(i >> 1) & 1] += (hsum / 6.) * ((2. - h1 / h0) * y[i] +
+            (hsum * hsum / (h0 * h1)) * y[i + 1] + (2. - h0 / h1) * y[i + 2]);
+    }
+    float64 Sum = Result[0] + Result[1];
+
+    if (N % 2)
+    {
+        float64 hn2 = x[N - 1] - x[N - 2];
+        float64 hn1 = x[N] - x[N - 1];
+        float64 alf = ((2. * hn1 * hn1) + (3. * hn1 * hn2)) / (6. * (hn2 + hn1));
+        float64 bet = ((hn1 * hn1) + (3. * hn1 * hn2)) / (6. * hn2);
+        float64 eta = (hn1 * hn1 * hn1) / (6. * hn2 * (hn2 + hn1));
+        Sum += alf * y[N] + bet * y[N - 1] - eta * y[N - 2];
+    }
+    return Sum;
+}
+
+float64 NewtonCotesFormulae::Simpson(std::span<const float64> y, float64 h)
+{
+    if (y.size() < 3) {throw std::logic_error("need at least 3 sample points");}
+    uint64 N = y.size() - 1;
+    uint64 Even = N - N % 2;
+
+    // 辛普森1/3: h/3 * (y0 + 4 * 奇数项 + 2 * 偶数项 + yn)
+    float64 Odd = __Newton_Cotes_Strided_Sum(y.data() + 1, Even / 2, 2);
+    float64 Inner = __Newton_Cotes_Strided_Sum(y.data() + 2, Even / 2 - 1, 2);
+    float64 Sum = (h / 3.) * (y[0] + 4. * Odd + 2. * Inner + y[Even]);
+
+    if (N % 2)
+    {
+        Sum += (h / 12.) * (5. * y[N] + 8. * y[N - 1] - y[N - 2]);
+    }
+    return Sum;
+}
+
+float64 NewtonCotesFormulae::Romberg(std::span<const float64> x, std::span<const float64> y,
+    DynamicMatrix<float64>* RichardsonExtrapolationTable)
+{
+    __Newton_Cotes_Check_Samples(x, y, 2);
+    if (!IsEvenlySized(x))
+    {
+        throw std::logic_error("Samples are unequally spaced.");
+    }
+    return Romberg(y, x[1] - x[0], RichardsonExtrapolationTable);
+}
+
+float64 NewtonCotesFormulae::Romberg(std::span<const float64> y, float64 dx,
+    DynamicMatrix<float64>* RichardsonExtrapolationTable)
+{
+    if (y.size() < 2) {throw std::logic_error("need at least 2 sample points");}
+    uint64 NSegments = y.size() - 1;
+
+    uint64 n = 1, k = 0;
+    while (n < NSegments)
+    {
+        n <<= 1;
+        ++k;
+    }
+    if (n != NSegments)
+    {
+        throw std::logic_error("Number of samples must be 2^N + 1 and N > 0.");
+    }
+
+    DynamicMatrix<float64> R({k + 1, k + 1});
+    float64 h = NSegments * dx;
+    R.at(0, 0) = h * ((y.front() + y.back()) / 2.);
+    uint64 Start = NSegments, Step = NSegments;
+
+    for (uint64 i = 1; i <= k; ++i)
+    {
+        Start >>= 1;
+        float64 ysum = __Newton_Cotes_Strided_Sum(y.data() + Start, (NSegments - Start + Step - 1) / Step, Step);
+        Step >>= 1;
+        R.at(0, i) = (R.at(0, i - 1) + h * ysum) / 2.;
+
+        for (uint64 j = 1; j <= i; ++j)
+        {
+            R.at(j, i) = R.at(j - 1, i) + (R.at(j - 1, i) - R.at(j - 1, i - 1)) / ((1 << (2 * j)) - 1);
+        }
+
+        h /= 2.0;
+    }
+
+    if (RichardsonExtrapolationTable) {*RichardsonExtrapolationTable = R;}
+
+    return R.at(k, k);
+}
+
+void NewtonCotesFormulae::CumulativeTrapezoidal(std::span<const float64> x, std::span<const float64> y,
+    std::span<float64> Out, float64 Initial)
+{
+    __Newton_Cotes_Check_Samples(x, y, 2);
+    if (Out.size() != y.size()) {throw std::logic_error("Size of output mismatch.");}
+    float64 Sum = Initial;
+    Out[0] = Sum;
+    for (uint64 i = 1; i < y.size(); ++i)
+    {
+        Sum += (x[i] - x[i - 1]) * (y[i] + y[i - 1]) / 2.;
+        Out[i] = Sum;
+    }
+}
+
+void NewtonCotesFormulae::CumulativeTrapezoidal(std::span<const float64> y, float64 h,
+    std::span<float64> Out, float64 Initial)
+{
+    if (y.size() < 2) {throw std::logic_error("need at least 2 sample points");}
+    if (Out.size() != y.size()) {throw std::logic_error("Size of output mismatch.");}
+    float64 Sum = Initial;
+    Out[0] = Sum;
+    for (uint64 i = 1; i < y.size(); ++i)
+    {
+        Sum += h * (y[i] + y[i - 1]) / 2.;
+        Out[i] = Sum;
+    }
+}
+
+void NewtonCotesFormulae::CumulativeSimpson(std::span<const float64> x, std::span<const float64> y,
+    std::span<float64> Out, float64 Initial)
+{
+    if (y.size() == 2) {return CumulativeTrapezoidal(x, y, Out, Initial);}
+    __Newton_Cotes_Check_Samples(x, y, 3);
+    if (Out.size() != y.size()) {throw std::logic_error("Size of output mismatch.");}
+    uint64 N = y.size() - 1;
+
+    // 经过(x0, x1, x2)三点的二次插值在[x0, x1]上的积分
+    auto Front = [](float64 h1, float64 h2, float64 y0, float64 y1, float64 y2)
+    {
+        float64 H = h1 + h2;
+        return (h1 / 6.) * ((3. - h1 / H) * y0 + ((3. * H - 2. * h1) / h2) * y1 - (h1 * h1 / (H * h2)) * y2);
+    };
+
+    // 每对区间组合起来即为复化辛普森公式，前半区间和后半区间分别取插值多项式的积分
+    float64 Sum = Initial;
+    Out[0] = Sum;
+    for (uint64 i = 0; i + 2 <= N; i += 2)
+    {
+        float64 h1 = x[i + 1] - x[i], h2 = x[i + 2] - x[i + 1];
+        float64 First = Front(h1, h2, y[i], y[i + 1], y[i + 2]);
+        float64 Second = Front(h2, h1, y[i + 2], y[i + 1], y[i]);
+        Out[i + 1] = Sum + First;
+        Sum += First + Second;
+        Out[i + 2] = Sum;
+    }
+    // 区间数为奇数时，最后一个区间取经过(x[N-2], x[N-1], x[N])的插值在[x[N-1], x[N]]上的积分
+    if (N % 2)
+    {
+        Sum += Front(x[N] - x[N - 1], x[N - 1] - x[N - 2], y[N], y[N - 1], y[N - 2]);
+        Out[N] = Sum;
+    }
+}
+
+void NewtonCotesFormulae::CumulativeSimpson(std::span<const float64> y, float64 h,
+    std::span<float64> Out, float64 Initial)
+{
+    if (y.size() == 2) {return CumulativeTrapezoidal(y, h, Out, Initial);}
+    if (y.size() < 3) {throw std::logic_error("need at least 3 sample points");}
+    if (Out.size() != y.size()) {throw std::logic_error("Size of output mismatch.");}
+    uint64 N = y.size() - 1;
+    float64 Scale = h / 12.;
+
+    float64 Sum = Initial;
+    Out[0] = Sum;
+    for (uint64 i = 0; i + 2 <= N; i += 2)
+    {
+        float64 First = Scale * (5. * y[i] + 8. * y[i + 1] - y[i + 2]);
+        float64 Second = Scale * (5. * y[i + 2] + 8. * y[i + 1] - y[i]);
+        Out[i + 1] = Sum + First;
+        Sum += First + Second;
+        Out[i + 2] = Sum;
+    }
+    if (N % 2)
+    {
+        Sum += Scale * (5. * y[N] + 8. * y[N - 1] - y[N - 2]);
+        Out[N] = Sum;
+    }
+}
+
 float64 NewtonCotesFormulae::SingleIntegrate(std::vector<vec2> Samples)const
 {
     __Newton_Cotes_Func_Disable
@@ -812,7 +1236,281 @@ float64 NewtonCotesFormulae::Run(std::vector<vec2> Samples) const
     throw std::logic_error("No matching function for call to these samples.");
 }
 
+QuadratureWeights NewtonCotesFormulae::CompileWeights(std::span<const float64> x)const
+{
+    __Newton_Cotes_Func_Disable
+    return QuadratureWeights(x, Level);
+}
+
+//////////////////////////////////// 积分权重 ////////////////////////////////////
+
+DynamicMatrix<float64> QuadratureWeights::FornbergWeights(float64 z, std::span<const float64> x, uint64 MaxOrder)
+{
+    if (x.empty()) {throw std::logic_error("Requires at least 1 node.");}
+    uint64 n = x.size();
+    DynamicMatrix<float64> C({n, MaxOrder + 1});
+    float64 c1 = 1, c4 = x[0] - z;
+    C.at(0, 0) = 1;
+    for (uint64 i = 1; i < n; ++i)
+    {
+        uint64 mn = min(i, MaxOrder);
+        float64 c2 = 1, c5 = c4;
+        c4 = x[i] - z;
+        for (uint64 j = 0; j < i; ++j)
+        {
+            float64 c3 = x[i] - x[j];
+            if (c3 == 0) {throw std::logic_error("Nodes must be distinct.");}
+            c2 *= c3;
+            if (j == i - 1)
+            {
+                for (uint64 k = mn; k >= 1; --k)
+                {
+                    C.at(i, k) = c1 * (float64(k) * C.at(i - 1, k - 1) - c5 * C.at(i - 1, k)) / c2;
+                }
+                C.at(i, 0) = -c1 * c5 * C.at(i - 1, 0) / c2;
+            }
+            for (uint64 k = mn; k >= 1; --k)
+            {
+                C.at(j, k) = (c4 * C.at(j, k) - float64(k) * C.at(j, k - 1)) / c3;
+            }
+            C.at(j, 0) = c4 * C.at(j, 0) / c3;
+        }
+        c1 = c2;
+    }
+    return C;
+}
+
+void QuadratureWeights::IntegralWeights(std::span<const float64> x, float64 a, float64 b, std::span<float64> Out)
+{
+    if (Out.size() != x.size()) {throw std::logic_error("Size of output mismatch.");}
+    uint64 n = x.size();
+    // 在节点中点处展开，∫L_j = Σ L_j^(k)(z) * ((b - z)^(k + 1) - (a - z)^(k + 1)) / (k + 1)!
+    float64 z = (x.front() + x.back()) / 2.;
+    DynamicMatrix<float64> C = FornbergWeights(z, x, n - 1);
+    std::vector<float64> Moments(n);
+    float64 ta = 1, tb = 1;
+    for (uint64 k = 0; k < n; ++k)
+    {
+        ta *= (a - z) / float64(k + 1);
+        tb *= (b - z) / float64(k + 1);
+        Moments[k] = tb - ta;
+    }
+    for (uint64 j = 0; j < n; ++j)
+    {
+        float64 Sum = 0;
+        for (uint64 k = 0; k < n; ++k) {Sum += C.at(j, k) * Moments[k];}
+        Out[j] = Sum;
+    }
+}
+
+QuadratureWeights::QuadratureWeights(std::span<const float64> x, uint64 Level)
+    : Abscissas(x.begin(), x.end()), Weights(x.size(), 0.)
+{
+    if (x.size() < 2) {throw std::logic_error("Requires at least 2 sample points");}
+    if (!Level) {throw std::logic_error("Level is zero");}
+    uint64 N = x.size() - 1;
+    uint64 L = min(Level, N);
+    std::vector<float64> Block(L + 1);
+
+    uint64 i = 0;
+    for (; i + L <= N; i += L)
+    {
+        IntegralWeights(x.subspan(i, L + 1), x[i], x[i + L], Block);
+        for (uint64 j = 0; j <= L; ++j) {Weights[i + j] += Block[j];}
+    }
+    if (i < N)
+    {
+        // 剩余区间使用最后L + 1个采样点
+        uint64 First = N - L;
+        IntegralWeights(x.subspan(First, L + 1), x[i], x[N], Block);
+        for (uint64 j = 0; j <= L; ++j) {Weights[First + j] += Block[j];}
+    }
+}
+
+float64 QuadratureWeights::Integrate(std::span<const float64> y)const
+{
+    if (y.size() != Weights.size()) {throw std::logic_error("Number of samples doesn't match the weights.");}
+    const float64* w = Weights.data();
+    float64 s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    uint64 n = y.size(), i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        s0 += w[i + 0] * y[i + 0];
+        s1 += w[i + 1] * y[i + 1];
+        s2 += w[i + 2] * y[i + 2];
+        s3 += w[i + 3] * y[i + 3];
+    }
+    for (; i < n; ++i) {s0 += w[i] * y[i];}
+    return (s0 + s1) + (s2 + s3);
+}
+
+void QuadratureWeights::Integrate(std::span<const float64> Y, std::span<float64> Out, uint64 Threads)const
+{
+    const uint64 BlockSize = 64;
+    uint64 n = Weights.size(), Count = Out.size();
+    if (Y.size() != Count * n) {throw std::logic_error("Number of samples doesn't match the weights.");}
+    __Parallel_For((Count + BlockSize - 1) / BlockSize, [&](uint64 Block, uint64)
+    {
+        uint64 Last = min(Count, (Block + 1) * BlockSize);
+        for (uint64 i = Block * BlockSize; i < Last; ++i)
+        {
+            Out[i] = Integrate(Y.subspan(i * n, n));
+        }
+    }, Threads);
+}
+
+
+
+//////////////////////////////////// 流式积分 ////////////////////////////////////
+
+float64 StreamingIntegrator::SimpsonPair(vec2 p0, vec2 p1, vec2 p2)
+{
+    float64 h0 = p1.x - p0.x;
+    float64 h1 = p2.x - p1.x;
+    float64 hsum = h0 + h1;
+    return (hsum / 6.) * ((2. - h1 / h0) * p0.y +
+        (hsum * hsum / (h0 * h1)) * p1.y + (2. - h0 / h1) * p2.y);
+}
+
+void StreamingIntegrator::PushTail(vec2 Sample)
+{
+    if (Count < EndSamples) {Head[Count] = Sample;}
+    Tail[Count % EndSamples] = Sample;
+    ++Count;
+}
+
+void StreamingIntegrator::Push(float64 x, float64 y)
+{
+    vec2 Sample(x, y);
+    if (Count >= 1)
+    {
+        vec2 Last = back(0);
+        TrapezoidalSum += (x - Last.x) * (y + Last.y) / 2.;
+    }
+    if (Count >= 2)
+    {
+        SimpsonPairSum[(Count - 2) & 1] += SimpsonPair(back(1), back(0), Sample);
+    }
+    PushTail(Sample);
+}
 
+void StreamingIntegrator::Push(std::span<const float64> x, std::span<const float64> y)
+{
+    if (x.size() != y.size()) {throw std::logic_error("Size of x and y mismatch.");}
+    for (uint64 i = 0; i < x.size(); ++i) {Push(x[i], y[i]);}
+}
+
+void StreamingIntegrator::clear()
+{
+    *this = StreamingIntegrator();
+}
+
+vec2 StreamingIntegrator::front(uint64 i)const
+{
+    if (i >= min(Count, EndSamples)) {throw std::logic_error("Sample is not retained.");}
+    return Head[i];
+}
+
+vec2 StreamingIntegrator::back(uint64 i)const
+{
+    if (i >= min(Count, EndSamples)) {throw std::logic_error("Sample is not retained.");}
+    return Tail[(Count - 1 - i) % EndSamples];
+}
+
+StreamingIntegrator& StreamingIntegrator::merge(const StreamingIntegrator& Next)
+{
+    if (Next.empty()) {return *this;}
+    if (empty()) {return *this = Next;}
+
+    // 补上两段之间的区间，以及跨越分界的两个辛普森区间对
+    vec2 Last = back(0), First = Next.front(0);
+    TrapezoidalSum += Next.TrapezoidalSum + (First.x - Last.x) * (First.y + Last.y) / 2.;
+    if (Count >= 2)
+    {
+        SimpsonPairSum[(Count - 2) & 1] += SimpsonPair(back(1), Last, First);
+    }
+    if (Next.Count >= 2)
+    {
+        SimpsonPairSum[(Count - 1) & 1] += SimpsonPair(Last, First, Next.front(1));
+    }
+    // 后一段中的区间对在合并后的奇偶性由前一段的长度决定
+    uint64 Shift = Count & 1;
+    SimpsonPairSum[0] += Next.SimpsonPairSum[Shift];
+    SimpsonPairSum[1] += Next.SimpsonPairSum[Shift ^ 1];
+
+    for (uint64 i = Count; i < EndSamples && i - Count < Next.Count; ++i)
+    {
+        Head[i] = Next.front(i - Count);
+    }
+
+    uint64 Total = Count + Next.Count;
+    std::array<vec2, EndSamples> NewTail;
+    for (uint64 j = 0; j < min(Total, EndSamples); ++j)
+    {
+        NewTail[(Total - 1 - j) % EndSamples] = j < Next.Count ? Next.back(j) : back(j - Next.Count);
+    }
+    Tail = NewTail;
+    Count = Total;
+    return *this;
+}
+
+float64 StreamingIntegrator::Trapezoidal()const
+{
+    return TrapezoidalSum;
+}
+
+float64 StreamingIntegrator::Simpson()const
+{
+    if (Count < 3) {return TrapezoidalSum;}
+    uint64 N = Count - 1;
+    float64 Sum = SimpsonPairSum[0];
+    if (N % 2)
+    {
+        // 最后一个区间使用二次插值修正，与NewtonCotesFormulae::Simpson相同
+        float64 hn2 = back(1).x - back(2).x;
+        float64 hn1 = back(0).x - back(1).x;
+        float64 alf = ((2. * hn1 * hn1) + (3. * hn1 * hn2)) / (6. * (hn2 + hn1));
+        float64 bet = ((hn1 * hn1) + (3. * hn1 * hn2)) / (6. * hn2);
+        float64 eta = (hn1 * hn1 * hn1) / (6. * hn2 * (hn2 + hn1));
+        Sum += alf * back(0).y + bet * back(1).y - eta * back(2).y;
+    }
+    return Sum;
+}
+
+float64 StreamingIntegrator::Gregory(uint64 Order)const
+{
+    static const float64 Coefficients[MaxGregoryOrder] =
+    {
+        1. / 12., 1. / 24., 19. / 720., 3. / 160., 863. / 60480.
+    };
+
+    if (Order > MaxGregoryOrder) {throw std::logic_error("Order of Gregory correction is too high.");}
+    if (Count < 2) {return TrapezoidalSum;}
+    uint64 r = min(Order, Count - 1);
+    float64 h = Head[1].x - Head[0].x;
+
+    // 首端向前差分和末端向后差分，原地逐阶计算
+    float64 Fwd[EndSamples], Bwd[EndSamples];
+    for (uint64 i = 0; i <= r; ++i)
+    {
+        Fwd[i] = Head[i].y;
+        Bwd[i] = back(r - i).y;
+    }
+
+    float64 Correction = 0;
+    for (uint64 k = 1; k <= r; ++k)
+    {
+        for (uint64 i = 0; i + k <= r; ++i)
+        {
+            Fwd[i] = Fwd[i + 1] - Fwd[i];
+            Bwd[i] = Bwd[i + 1] - Bwd[i];
+        }
+        float64 Delta = Fwd[0], Nabla = Bwd[r - k];
+        Correction += Coefficients[k - 1] * (Nabla + (k % 2 ? -Delta : Delta));
+    }
+
+    return TrapezoidalSum - h * Correction;
+}
 
 ///////////////////////////////// 黎曼-刘维尔积分 ////////////////////////////////
 
@@ -829,7 +1527,7 @@ float64 RiemannLiouvilleIntegratingFunction::operator()(float64 x) const
 
 const __Multidimensional_Integral::DefaultEngine __Multidimensional_Integral::DefEngine{};
 
-float64 __Multidimensional_Integral::UnpackBoundary(const BoundaryType& Func, const std::vector<float64>& Pinned) const
+float64 __Multidimensional_Integral::UnpackBoundary(const BoundaryType& Func, const std::vector<float64>& Pinned)
 {
     if (std::holds_alternative<float64>(Func))
     {
@@ -842,32 +1540,31 @@ float64 __Multidimensional_Integral::UnpackBoundary(const BoundaryType& Func, co
     }
 }
 
-float64 __Multidimensional_Integral::RecursiveIntergrate(FuncType Func, std::vector<float64> Pinned, std::stack<BoundPairType> Remains) const
+float64 __Multidimensional_Integral::RecursiveIntergrate(const FuncType& Func, std::vector<float64>& Pinned, const std::vector<BoundPairType>& Bounds) const
 {
-    if (Remains.empty())
+    uint64 Level = Pinned.size();
+    if (Level == Bounds.size())
     {
         // 所有维度都已固定，直接计算函数值
         return Func(Pinned);
     }
 
-    // 取出当前要积分的维度
-    BoundPairType Current = Remains.top();
-    Remains.pop();
-
     // 获取当前维度的上下界
-    float64 Lower = UnpackBoundary(Current.first, Pinned);
-    float64 Upper = UnpackBoundary(Current.second, Pinned);
+    float64 Lower = UnpackBoundary(Bounds[Level].first, Pinned);
+    float64 Upper = UnpackBoundary(Bounds[Level].second, Pinned);
 
-    // 构造当前维度的一维积分函数
-    Func1DType InnerIntergral = [this, Func, Pinned, Remains](float64 x)
+    // 构造当前维度的一维积分函数，所有层共用同一个缓冲区，进入下一层前截断到当前层
+    Func1DType InnerIntergral = [this, &Func, &Pinned, &Bounds, Level](float64 x)
     {
-        std::vector<float64> CurrentPinned = Pinned;
-        CurrentPinned.push_back(x);
-        return RecursiveIntergrate(Func, CurrentPinned, Remains);
+        Pinned.resize(Level);
+        Pinned.push_back(x);
+        return RecursiveIntergrate(Func, Pinned, Bounds);
     };
 
     // 使用引擎计算一维积分
-    return (*Engine)(InnerIntergral, Lower, Upper);
+    float64 Result = (*Engine)(InnerIntergral, Lower, Upper);
+    Pinned.resize(Level);
+    return Result;
 }
 
 __Multidimensional_Integral::BoundPairType __Multidimensional_Integral::MakeBound(BoundaryType a, BoundaryType b)
@@ -882,17 +1579,12 @@ float64 __Multidimensional_Integral::operator()(Func1DType Func, vec2 BoundaryX)
 
 float64 __Multidimensional_Integral::operator()(FuncType Func, vec2 BoundaryX, std::vector<BoundPairType> OtherBounds)const
 {
-    // 将第一维边界转换为BoundPairType
-    std::stack<BoundPairType> Bounds;
-    for (auto it = OtherBounds.rbegin(); it != OtherBounds.rend(); ++it)
-    {
-        Bounds.push(*it);
-    }
-    BoundPairType XBound = {BoundaryX[0], BoundaryX[1]};
-    Bounds.push(XBound);
+    auto Bounds = MergeBounds(BoundaryX, OtherBounds);
 
     // 从空向量开始递归积分
-    return RecursiveIntergrate(Func, {}, Bounds);
+    std::vector<float64> Pinned;
+    Pinned.reserve(Bounds.size());
+    return RecursiveIntergrate(Func, Pinned, Bounds);
 }
 
 _SCICXX_END
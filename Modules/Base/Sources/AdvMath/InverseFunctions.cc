@@ -61,31 +61,8 @@ vec2 BrentInverseFunction::GetReferenceValues(vec2 Domain, int Trend) const
     return Result;
 }
 
-float64 BrentInverseFunction::operator()(float64 x) const
+void BrentInverseFunction::CheckRange(float64 x, vec2 RefValues, int Trend)const
 {
-    vec2 RefPoints = GetReferencePoints(Domain);
-    float64 a1 = OriginalFunction(RefPoints[1]), a2 = OriginalFunction(RefPoints[0]);
-    int Trend = sgn(OriginalFunction(RefPoints[1]) - OriginalFunction(RefPoints[0]));
-    if (!(Trend))
-    {
-        throw std::logic_error("Function is not strictly monotonic");
-    }
-    vec2 RefValues = GetReferenceValues(Domain, Trend);
-
-    auto Bound = [this, &Trend](float64 x)
-    {
-        if (!isinf(Domain[0]) && (x < Domain[0] || (x == Domain[0] && OpenDomain[0])))
-        {
-            return __Float64::FromBytes(NEG_INF_DOUBLE) * Trend;
-        }
-        else if (!isinf(Domain[1]) && (x > Domain[1] || (x == Domain[1] and OpenDomain[1])))
-        {
-            return __Float64::FromBytes(POS_INF_DOUBLE) * Trend;
-        }
-
-        return OriginalFunction(x);
-    };
-
     if (!isinf(RefValues[0]))
     {
         bool Reject;
@@ -115,6 +92,34 @@ float64 BrentInverseFunction::operator()(float64 x) const
                 " higher limit of the image");
         }
     }
+}
+
+float64 BrentInverseFunction::operator()(float64 x) const
+{
+    vec2 RefPoints = GetReferencePoints(Domain);
+    float64 a1 = OriginalFunction(RefPoints[1]), a2 = OriginalFunction(RefPoints[0]);
+    int Trend = sgn(OriginalFunction(RefPoints[1]) - OriginalFunction(RefPoints[0]));
+    if (!(Trend))
+    {
+        throw std::logic_error("Function is not strictly monotonic");
+    }
+    vec2 RefValues = GetReferenceValues(Domain, Trend);
+
+    auto Bound = [this, &Trend](float64 x)
+    {
+        if (!isinf(Domain[0]) && (x < Domain[0] || (x == Domain[0] && OpenDomain[0])))
+        {
+            return __Float64::FromBytes(NEG_INF_DOUBLE) * Trend;
+        }
+        else if (!isinf(Domain[1]) && (x > Domain[1] || (x == Domain[1] and OpenDomain[1])))
+        {
+            return __Float64::FromBytes(POS_INF_DOUBLE) * Trend;
+        }
+
+        return OriginalFunction(x);
+    };
+
+    CheckRange(x, RefValues, Trend);
 
     if (!isinf(RefPoints[1]) && Bound(RefPoints[1]) == x)
     {
@@ -237,6 +242,316 @@ float64 BrentInverseFunction::QSolve(Function1D Func, vec2 Domain, float64 AbsTo
 }
 
 
+//////////////////////////////////// 批量布伦特 ////////////////////////////////////
+
+BatchedBrentRootFinder::BatchedBrentRootFinder(std::span<const vec2> Brackets, std::span<const float64> Targets,
+    float64 AbsTolerence, float64 RelTolerence)
+    : AbsTolerence(pow(10, -AbsTolerence)), RelTolerence(pow(10, -RelTolerence))
+{
+    if (!Targets.empty() && Targets.size() != Brackets.size())
+    {
+        throw std::logic_error("Size of targets mismatch.");
+    }
+    Lanes = Brackets.size();
+    States.resize(Lanes);
+    for (uint64 i = 0; i < Lanes; ++i)
+    {
+        States[i].xpre = Brackets[i].x;
+        States[i].xcur = Brackets[i].y;
+        if (!Targets.empty()) {States[i].Target = Targets[i];}
+    }
+}
+
+void BatchedBrentRootFinder::SetEndpointValues(std::span<const vec2> Values)
+{
+    if (Values.size() != Lanes) {throw std::logic_error("Size of endpoint values mismatch.");}
+    for (uint64 i = 0; i < Lanes; ++i)
+    {
+        States[i].fpre = Values[i].x - States[i].Target;
+        States[i].fcur = Values[i].y - States[i].Target;
+        Start(States[i]);
+    }
+    EndpointsEvaluated = 1;
+}
+
+void BatchedBrentRootFinder::Start(LaneState& Lane)
+{
+    if (Lane.fpre == 0)
+    {
+        Lane.xcur = Lane.xpre;
+        Lane.State = Finished;
+    }
+    else if (Lane.fcur == 0) {Lane.State = Finished;}
+    else if (std::signbit(Lane.fpre) == std::signbit(Lane.fcur)) {Lane.State = SignError;}
+    else {Advance(Lane);}
+}
+
+void BatchedBrentRootFinder::Advance(LaneState& Lane)
+{
+    // 与QSolve中的循环体相同，只是函数求值移到了循环外
+    auto& [xpre, xcur, xblk, fpre, fcur, fblk, spre, scur, Target, State] = Lane;
+
+    if (fpre != 0 && fcur != 0 && (std::signbit(fpre) != std::signbit(fcur)))
+    {
+        xblk = xpre;
+        fblk = fpre;
+        spre = scur = xcur - xpre;
+    }
+
+    if (abs(fblk) < abs(fcur))
+    {
+        xpre = xcur;
+        xcur = xblk;
+        xblk = xpre;
+
+        fpre = fcur;
+        fcur = fblk;
+        fblk = fpre;
+    }
+
+    float64 delta = (AbsTolerence + RelTolerence * abs(xcur)) / 2;
+    float64 sbis = (xblk - xcur) / 2;
+    if (fcur == 0 || abs(sbis) < delta)
+    {
+        State = Finished;
+        return;
+    }
+
+    if (abs(spre) > delta && abs(fcur) < abs(fpre))
+    {
+        float64 stry;
+        if (xpre == xblk) {stry = -fcur * (xcur - xpre) / (fcur - fpre);}
+        else
+        {
+            float64 dpre = (fpre - fcur) / (xpre - xcur);
+            float64 dblk = (fblk - fcur) / (xblk - xcur);
+            stry = -fcur * (fblk * dblk - fpre * dpre) / (dblk * dpre * (fblk - fpre));
+        }
+
+        if (2 * abs(stry) < min(abs(spre), 3 * abs(sbis) - delta))
+        {
+            spre = scur;
+            scur = stry;
+        }
+        else {spre = scur = sbis;}
+    }
+    else {spre = scur = sbis;}
+
+    xpre = xcur;
+    fpre = fcur;
+    xcur += abs(scur) > delta ? scur : (sbis > 0 ? delta : -delta);
+}
+
+void BatchedBrentRootFinder::PreEvaluator(std::span<const uint64> Lanes, std::vector<float64>& x)
+{
+    for (uint64 Lane : Lanes)
+    {
+        if (!EndpointsEvaluated) {x.push_back(States[Lane].xpre);}
+        x.push_back(States[Lane].xcur);
+    }
+}
+
+void BatchedBrentRootFinder::PostEvaluator(std::span<const uint64> Lanes, std::span<const float64>,
+    std::span<const float64> fx)
+{
+    for (uint64 i = 0; i < Lanes.size(); ++i)
+    {
+        LaneState& Lane = States[Lanes[i]];
+        if (!EndpointsEvaluated)
+        {
+            Lane.fpre = fx[2 * i] - Lane.Target;
+            Lane.fcur = fx[2 * i + 1] - Lane.Target;
+            Start(Lane);
+        }
+        else
+        {
+            Lane.fcur = fx[i] - Lane.Target;
+            Advance(Lane);
+        }
+    }
+    EndpointsEvaluated = 1;
+}
+
+void BatchedBrentRootFinder::Conditioner(std::span<const uint64> Lanes, std::span<bool> Terminate)
+{
+    for (uint64 i = 0; i < Lanes.size(); ++i)
+    {
+        Terminate[i] = States[Lanes[i]].State != InProgress;
+    }
+}
+
+BatchedBrentRootFinder::StateType BatchedBrentRootFinder::Status(uint64 Lane)const
+{
+    // 迭代结束后仍未完成的通道视为未收敛
+    StateType State = States[Lane].State;
+    return State == InProgress && IterCount ? NotConverged : State;
+}
+
+uint64 BatchedBrentRootFinder::GetRoots(std::span<float64> Out)const
+{
+    if (Out.size() != Lanes) {throw std::logic_error("Size of output mismatch.");}
+    uint64 Failed = 0;
+    for (uint64 i = 0; i < Lanes; ++i)
+    {
+        if (States[i].State == Finished) {Out[i] = States[i].xcur;}
+        else
+        {
+            Out[i] = __Float64::FromBytes(BIG_NAN_DOUBLE);
+            ++Failed;
+        }
+    }
+    return Failed;
+}
+
+void BrentInverseFunction::QSolve(BatchFuncType Func, std::span<const vec2> Domains, std::span<float64> Out,
+    float64 AbsTolerence, float64 RelTolerence, float64 MaxIterCount, uint64* IterCount, uint64* FuncCalls)
+{
+    BatchedBrentRootFinder Solver(Domains, {}, AbsTolerence, RelTolerence);
+    // 第一次批量求值为区间端点，随后即进行QSolve循环中第一次迭代的收敛检查，因此批量求值的次数
+    // 与QSolve的迭代次数相同
+    Solver.RunIterations(Func, uint64(floor(pow(10, MaxIterCount))));
+    if (IterCount) {*IterCount = Solver.IterCount;}
+    if (FuncCalls) {*FuncCalls = Solver.EvaluateCount;}
+
+    if (Solver.GetRoots(Out))
+    {
+        for (uint64 i = 0; i < Domains.size(); ++i)
+        {
+            if (Solver.Status(i) == BatchedBrentRootFinder::SignError)
+            {
+                throw std::logic_error("Brent: No solutions found between this domain");
+            }
+            if (Solver.Status(i) == BatchedBrentRootFinder::NotConverged)
+            {
+                throw std::logic_error(std::format("Brent: Failed to converge: {}", Solver.States[i].xcur));
+            }
+        }
+    }
+}
+
+void BrentInverseFunction::operator()(std::span<const float64> x, std::span<float64> Out, uint64 Threads)const
+{
+    if (x.size() != Out.size()) {throw std::logic_error("Size of output mismatch.");}
+    BatchFuncType Func = BatchFunction;
+    if (!Func)
+    {
+        Func = [this, Threads](std::span<const float64> x, std::span<float64> fx)
+        {
+            __Parallel_For(x.size(), [&](uint64 i, uint64){fx[i] = OriginalFunction(x[i]);}, Threads);
+        };
+    }
+
+    vec2 RefPoints = GetReferencePoints(Domain);
+    float64 RefInputs[2] = {RefPoints[0], RefPoints[1]}, RefValues[2];
+    Func(RefInputs, RefValues);
+    int Trend = sgn(RefValues[1] - RefValues[0]);
+    if (!Trend) {throw std::logic_error("Function is not strictly monotonic");}
+    vec2 Limits = GetReferenceValues(Domain, Trend);
+
+    // 第一步：从参考点出发向外扩展，直到区间两端函数值跨过目标值
+    struct Expansion
+    {
+        uint64  Index;
+        int     Direction;
+        float64 Lower, LowerValue, Step;
+        bool    BoundTried = 0;
+    };
+    std::vector<Expansion> Pending;
+    std::vector<uint64>    Indices;
+    std::vector<vec2>      Brackets, BracketValues;
+    std::vector<float64>   Targets;
+    auto AddBracket = [&](uint64 i, float64 a, float64 fa, float64 b, float64 fb)
+    {
+        Indices.push_back(i);
+        Brackets.push_back({a, b});
+        BracketValues.push_back({fa, fb});
+        Targets.push_back(x[i]);
+    };
+
+    for (uint64 i = 0; i < x.size(); ++i)
+    {
+        CheckRange(x[i], Limits, Trend);
+        if (RefValues[1] == x[i]) {Out[i] = RefPoints[1];}
+        else if (RefValues[0] == x[i]) {Out[i] = RefPoints[0];}
+        else if (Trend * (RefValues[1] - x[i]) < 0)
+        {
+            Pending.push_back({i, 1, RefPoints[1], RefValues[1], RefPoints[1] - RefPoints[0]});
+        }
+        else if (Trend * (RefValues[0] - x[i]) > 0)
+        {
+            Pending.push_back({i, -1, RefPoints[0], RefValues[0], RefPoints[1] - RefPoints[0]});
+        }
+        else {AddBracket(i, RefPoints[0], RefValues[0], RefPoints[1], RefValues[1]);}
+    }
+
+    std::vector<float64> Candidates, Values;
+    for (uint64 Round = 0; !Pending.empty(); ++Round)
+    {
+        if (Round > 2100) {throw std::logic_error("Failed to find a bracket for the requested values.");}
+        Candidates.clear();
+        for (auto& Item : Pending)
+        {
+            bool    Upper = Item.Direction > 0;
+            float64 Bound = Domain[Upper];
+            float64 Next;
+            if (isinf(Bound))
+            {
+                Next = Item.Lower + Item.Direction * Item.Step;
+                Item.Step *= 2;
+            }
+            else if (!OpenDomain[Upper] && !Item.BoundTried)
+            {
+                Next = Bound;
+                Item.BoundTried = 1;
+            }
+            else {Next = Item.Lower + (Bound - Item.Lower) / 2.;}
+            if (!std::isfinite(Next) || Next == Item.Lower)
+            {
+                throw std::logic_error("Failed to find a bracket for the requested values.");
+            }
+            Candidates.push_back(Next);
+        }
+        Values.resize(Candidates.size());
+        Func(Candidates, Values);
+
+        uint64 Kept = 0;
+        for (uint64 j = 0; j < Pending.size(); ++j)
+        {
+            auto& Item = Pending[j];
+            float64 Diff = Trend * (Values[j] - x[Item.Index]);
+            if (Item.Direction > 0 && Diff >= 0)
+            {
+                AddBracket(Item.Index, Item.Lower, Item.LowerValue, Candidates[j], Values[j]);
+            }
+            else if (Item.Direction < 0 && Diff <= 0)
+            {
+                AddBracket(Item.Index, Candidates[j], Values[j], Item.Lower, Item.LowerValue);
+            }
+            else
+            {
+                Item.Lower = Candidates[j];
+                Item.LowerValue = Values[j];
+                Pending[Kept++] = Item;
+            }
+        }
+        Pending.resize(Kept);
+    }
+
+    // 第二步：批量布伦特求解
+    if (Indices.empty()) {return;}
+    // 绝对误差取得与相对误差相同，使接近0的结果仍有足够的有效数字
+    BatchedBrentRootFinder Solver(Brackets, Targets, 15.0515, 15.0515);
+    Solver.SetEndpointValues(BracketValues);
+    Solver.Run(Func, 2);
+    std::vector<float64> Roots(Indices.size());
+    if (Solver.GetRoots(Roots))
+    {
+        throw std::logic_error("Brent: Failed to converge");
+    }
+    for (uint64 j = 0; j < Indices.size(); ++j) {Out[Indices[j]] = Roots[j];}
+}
+
+
 //////////////////////////////////// 二分搜索 ////////////////////////////////////
 
 float64 BisectionRootFindingEngine::Run(float64 x, uint64* IterCount, uint64* FCallCount) const
@@ -304,10 +619,17 @@ float64 HouseholderIteratorGroup::Run(float64 x, uint64* IterCount, uint64* FCal
     float64 x0 = ReferencePoint;
     uint64 Iter = 0;
     float64 x1;
+    std::vector<float64> Jet(JetOrder + 1);
     for (; Iter <= MaxIter; ++Iter)
     {
-        // 第一次检验
-        float64 f = Func(x0);
+        // 第一次检验，使用自动微分时函数值和导数一起求出
+        float64 f;
+        if (JetFunction)
+        {
+            JetFunction(x0, Jet);
+            f = Jet[0] - x;
+        }
+        else {f = Func(x0);}
         if (FCallCount) {++(*FCallCount);}
         if (!f)
         {
@@ -317,11 +639,15 @@ float64 HouseholderIteratorGroup::Run(float64 x, uint64* IterCount, uint64* FCal
 
         // 应用Faa di Bruno公式
         std::vector<float64> df;
-        for (auto& i : DerivativeFunctions)
+        if (JetFunction) {df.assign(Jet.begin() + 1, Jet.end());}
+        else
         {
-            df.push_back(i(x0));
+            for (auto& i : DerivativeFunctions)
+            {
+                df.push_back(i(x0));
+            }
+            if (FCallCount) {(*FCallCount) += df.size();}
         }
-        if (FCallCount) {(*FCallCount) += df.size();}
         DynamicMatrix<float64> B = BellPolynomialsTriangularArray(df);
         uint64 n = Order();
         float64 gn0 = (n == 1) ? (1. / f) : 0, gn1 = 0;
@@ -350,6 +676,7 @@ float64 HouseholderIteratorGroup::Run(float64 x, uint64* IterCount, uint64* FCal
 
 float64 HouseholderIteratorGroup::operator()(float64 x) const
 {
+    if (JetFunction) {return Run(x);}
     switch (Order())
     {
     case 1:
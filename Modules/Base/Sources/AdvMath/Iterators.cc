@@ -1,4 +1,8 @@
 #include "CSE/Base/AdvMath.h"
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
 
 _CSE_BEGIN
 _SCICXX_BEGIN
@@ -27,5 +31,109 @@ void cse::SciCxx::ElementwiseIterator::Run(Function1D Function, float64 MaxIterL
     }
 }
 
+void cse::SciCxx::BatchedElementwiseIterator::Run(BatchFuncType Function, float64 MaxIterLog)
+{
+    RunIterations(Function, uint64(floor(pow(10, MaxIterLog))));
+}
+
+void cse::SciCxx::BatchedElementwiseIterator::RunIterations(BatchFuncType Function, uint64 MaxIter)
+{
+    Iterations.assign(Lanes, 0);
+
+    std::vector<uint64> Active(Lanes);
+    for (uint64 i = 0; i < Lanes; ++i) {Active[i] = i;}
+    std::unique_ptr<bool[]> Terminate(new bool[Lanes]);
+
+    // 移除需要结束的通道，剩余通道保持升序
+    auto Compact = [&]()
+    {
+        std::fill(Terminate.get(), Terminate.get() + Active.size(), false);
+        Conditioner(Active, std::span<bool>(Terminate.get(), Active.size()));
+        uint64 Kept = 0;
+        for (uint64 i = 0; i < Active.size(); ++i)
+        {
+            if (Terminate[i]) {Iterations[Active[i]] = IterCount;}
+            else {Active[Kept++] = Active[i];}
+        }
+        Active.resize(Kept);
+    };
+
+    Compact();
+    std::vector<float64> x, fx;
+    while (IterCount < MaxIter && !Active.empty())
+    {
+        x.clear();
+        PreEvaluator(Active, x);
+        if (x.size() % Active.size())
+        {
+            throw std::logic_error("Each lane must request the same number of points.");
+        }
+        fx.resize(x.size());
+        Function(x, fx);
+        EvaluateCount += x.size();
+        PostEvaluator(Active, x, fx);
+        ++IterCount;
+        Compact();
+        if (Active.empty()) {break;}
+        Finalize(Active);
+    }
+    for (uint64 Lane : Active) {Iterations[Lane] = IterCount;}
+}
+
+void cse::SciCxx::BatchedElementwiseIterator::Run(Function1D Function, float64 MaxIterLog, uint64 Threads)
+{
+    Run([&Function, Threads](std::span<const float64> x, std::span<float64> fx)
+    {
+        __Parallel_For(x.size(), [&](uint64 i, uint64){fx[i] = Function(x[i]);}, Threads);
+    }, MaxIterLog);
+}
+
+//////////////////////////////////// 并行执行 ///////////////////////////////////
+
+uint64 __Parallel_Workers(uint64 Count, uint64 Threads)
+{
+    if (!Threads) {Threads = std::thread::hardware_concurrency();}
+    if (!Threads) {Threads = 1;}
+    return min(Threads, max(Count, 1ull));
+}
+
+void __Parallel_For(uint64 Count, std::function<void(uint64 Task, uint64 Worker)> Task, uint64 Threads)
+{
+    if (!Count) {return;}
+    uint64 Workers = __Parallel_Workers(Count, Threads);
+    if (Workers == 1)
+    {
+        for (uint64 i = 0; i < Count; ++i) {Task(i, 0);}
+        return;
+    }
+
+    std::atomic<uint64> Next = 0;
+    std::exception_ptr Error = nullptr;
+    std::mutex ErrorLock;
+    auto Worker = [&](uint64 WorkerID)
+    {
+        try
+        {
+            for (uint64 i = Next++; i < Count; i = Next++)
+            {
+                Task(i, WorkerID);
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> Lock(ErrorLock);
+            if (!Error) {Error = std::current_exception();}
+            Next = Count; // 让其他线程尽快停止
+        }
+    };
+
+    std::vector<std::thread> Pool;
+    Pool.reserve(Workers - 1);
+    for (uint64 i = 1; i < Workers; ++i) {Pool.emplace_back(Worker, i);}
+    Worker(0);
+    for (auto& t : Pool) {t.join();}
+    if (Error) {std::rethrow_exception(Error);}
+}
+
 _SCICXX_END
 _CSE_END
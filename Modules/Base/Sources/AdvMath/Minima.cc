@@ -289,5 +289,588 @@ vec2 BrentUnboundedMinimizer::operator()(Function1D Func)const
     return Run(Func);
 }
 
+
+//////////////////////////////// 多元极小值求解 ////////////////////////////////
+
+void MultivariateMinimizer::Evaluate(std::span<const float64> Points, std::span<float64> Values)const
+{
+    FuncCalls += Values.size();
+    if (BatchObjective)
+    {
+        BatchObjective(Points, Values);
+        return;
+    }
+    __Parallel_For(Values.size(), [&](uint64 k, uint64)
+    {
+        Values[k] = Objective(Points.subspan(k * Dims, Dims));
+    }, Threads);
+}
+
+float64 MultivariateMinimizer::Evaluate(std::span<const float64> x)const
+{
+    ++FuncCalls;
+    if (Objective) {return Objective(x);}
+    float64 Value;
+    BatchObjective(x, std::span<float64>(&Value, 1));
+    return Value;
+}
+
+// 数值求导一次所需的求值点数
+static uint64 __Jacobian_Evaluations(const JacobianEngine& Engine)
+{
+    if (Engine.Method == JacobianEngine::ComplexStep) {return Engine.Inputs();}
+    uint64 PerLevel = Engine.Method == JacobianEngine::Central ? 2 : 1;
+    return Engine.Inputs() * (Engine.RichardsonLevels + 1) * PerLevel;
+}
+
+static float64 __Dot(std::span<const float64> a, std::span<const float64> b)
+{
+    float64 Sum = 0;
+    for (uint64 i = 0; i < a.size(); ++i) {Sum += a[i] * b[i];}
+    return Sum;
+}
+
+static float64 __Max_Norm(std::span<const float64> a)
+{
+    float64 Max = 0;
+    for (float64 v : a) {Max = max(Max, abs(v));}
+    return Max;
+}
+
+// ------------------------------------------------------------------------------------- //
+
+NelderMeadMinimizer::NelderMeadMinimizer(ObjectiveType Func, uint64 Dims)
+    : Mybase(Func, nullptr, Dims), Simplex({Dims + 1, Dims}), Values(Dims + 1), Order(Dims + 1),
+    Centroid(Dims), Trial(Dims), Trial2(Dims), Batch(Dims * Dims), BatchValues(Dims) {}
+
+NelderMeadMinimizer::NelderMeadMinimizer(BatchObjectiveType Func, uint64 Dims)
+    : Mybase(nullptr, Func, Dims), Simplex({Dims + 1, Dims}), Values(Dims + 1), Order(Dims + 1),
+    Centroid(Dims), Trial(Dims), Trial2(Dims), Batch(Dims * Dims), BatchValues(Dims) {}
+
+void NelderMeadMinimizer::SortSimplex()
+{
+    // 每次迭代通常只替换最差的顶点，插入排序接近线性
+    for (uint64 i = 1; i < Order.size(); ++i)
+    {
+        uint64 Key = Order[i];
+        uint64 j = i;
+        for (; j > 0 && Values[Order[j - 1]] > Values[Key]; --j) {Order[j] = Order[j - 1];}
+        Order[j] = Key;
+    }
+}
+
+void NelderMeadMinimizer::MoveToward(std::span<float64> Out, float64 Coeff)const
+{
+    uint64 Worst = Order[Dims];
+    for (uint64 i = 0; i < Dims; ++i)
+    {
+        Out[i] = (1. + Coeff) * Centroid[i] - Coeff * Simplex.at(Worst, i);
+    }
+}
+
+NelderMeadMinimizer::ResultType NelderMeadMinimizer::operator()(std::span<const float64> x0)
+{
+    // SciPy Function (BSD3 License)
+    uint64 n = Dims;
+    if (x0.size() != n) {throw std::logic_error("Dimension of initial point mismatch.");}
+    FuncCalls = 0;
+
+    float64 rho = 1, chi = 2, psi = 0.5, sigma = 0.5;
+    if (Adaptive)
+    {
+        chi = 1. + 2. / n;
+        psi = 0.75 - 1. / (2. * n);
+        sigma = 1. - 1. / n;
+    }
+    float64 xatol = pow(10, -XTolerence), fatol = pow(10, -FTolerence);
+    uint64 MaxIter = MaxIteration > 0 ? uint64(floor(pow(10, MaxIteration))) : 200 * n;
+
+    // 初始单纯形，各顶点在一次批量求值中计算
+    const float64 NonZeroDelta = 0.05, ZeroDelta = 0.00025;
+    for (uint64 k = 0; k <= n; ++k)
+    {
+        for (uint64 i = 0; i < n; ++i) {Simplex.at(k, i) = x0[i];}
+        if (k)
+        {
+            float64& v = Simplex.at(k, k - 1);
+            v = v ? (1. + NonZeroDelta) * v : ZeroDelta;
+        }
+        Order[k] = k;
+    }
+    Evaluate(std::span<const float64>(&Simplex.at(0, 0), (n + 1) * n), Values);
+
+    auto Replace = [&](std::span<const float64> Point, float64 Value)
+    {
+        uint64 Worst = Order[n];
+        for (uint64 i = 0; i < n; ++i) {Simplex.at(Worst, i) = Point[i];}
+        Values[Worst] = Value;
+    };
+
+    ResultType Result;
+    for (; Result.Iterations < MaxIter; ++Result.Iterations)
+    {
+        SortSimplex();
+
+        float64 XSpread = 0, FSpread = 0;
+        for (uint64 k = 1; k <= n; ++k)
+        {
+            for (uint64 i = 0; i < n; ++i)
+            {
+                XSpread = max(XSpread, abs(Simplex.at(Order[k], i) - Simplex.at(Order[0], i)));
+            }
+            FSpread = max(FSpread, abs(Values[Order[k]] - Values[Order[0]]));
+        }
+        if (XSpread <= xatol && FSpread <= fatol)
+        {
+            Result.Converged = 1;
+            break;
+        }
+
+        std::fill(Centroid.begin(), Centroid.end(), 0.);
+        for (uint64 k = 0; k < n; ++k)
+        {
+            for (uint64 i = 0; i < n; ++i) {Centroid[i] += Simplex.at(Order[k], i);}
+        }
+        for (auto& v : Centroid) {v /= float64(n);}
+
+        MoveToward(Trial, rho);
+        float64 fxr = Evaluate(Trial);
+        bool Shrink = 0;
+
+        if (fxr < Values[Order[0]])
+        {
+            MoveToward(Trial2, rho * chi);
+            float64 fxe = Evaluate(Trial2);
+            if (fxe < fxr) {Replace(Trial2, fxe);}
+            else {Replace(Trial, fxr);}
+        }
+        else if (fxr < Values[Order[n - 1]]) {Replace(Trial, fxr);}
+        else if (fxr < Values[Order[n]])
+        {
+            // 外收缩
+            MoveToward(Trial2, psi * rho);
+            float64 fxc = Evaluate(Trial2);
+            if (fxc <= fxr) {Replace(Trial2, fxc);}
+            else {Shrink = 1;}
+        }
+        else
+        {
+            // 内收缩
+            MoveToward(Trial2, -psi);
+            float64 fxcc = Evaluate(Trial2);
+            if (fxcc < Values[Order[n]]) {Replace(Trial2, fxcc);}
+            else {Shrink = 1;}
+        }
+
+        if (Shrink)
+        {
+            uint64 Best = Order[0];
+            for (uint64 k = 1; k <= n; ++k)
+            {
+                for (uint64 i = 0; i < n; ++i)
+                {
+                    float64 b = Simplex.at(Best, i);
+                    Batch[(k - 1) * n + i] = b + sigma * (Simplex.at(Order[k], i) - b);
+                }
+            }
+            Evaluate(Batch, BatchValues);
+            for (uint64 k = 1; k <= n; ++k)
+            {
+                for (uint64 i = 0; i < n; ++i) {Simplex.at(Order[k], i) = Batch[(k - 1) * n + i];}
+                Values[Order[k]] = BatchValues[k - 1];
+            }
+        }
+    }
+
+    SortSimplex();
+    Result.x = Simplex.GetColumn(Order[0]);
+    Result.fx = Values[Order[0]];
+    Result.FuncCalls = FuncCalls;
+    return Result;
+}
+
+// ------------------------------------------------------------------------------------- //
+
+LBFGSMinimizer::LBFGSMinimizer(ObjectiveType Func, uint64 Dims, GradientType GradFunc)
+    : Mybase(Func, nullptr, Dims), Gradient(GradFunc),
+    NumericalGradient([Func](std::span<const float64> x, std::span<float64> fx){fx[0] = Func(x);}, Dims, 1),
+    Grad(Dims), NewGrad(Dims), Direction(Dims), NewX(Dims), NewS(Dims), NewY(Dims) {}
+
+LBFGSMinimizer::LBFGSMinimizer(BatchObjectiveType Func, uint64 Dims, GradientType GradFunc)
+    : Mybase(nullptr, Func, Dims), Gradient(GradFunc), NumericalGradient(JacobianEngine::Batched(Func, Dims, 1)),
+    Grad(Dims), NewGrad(Dims), Direction(Dims), NewX(Dims), NewS(Dims), NewY(Dims) {}
+
+void LBFGSMinimizer::ComputeGradient(std::span<const float64> x, float64 fx, std::span<float64> Out)
+{
+    if (Gradient)
+    {
+        Gradient(x, Out);
+        return;
+    }
+    NumericalGradient.Threads = Threads;
+    NumericalGradient.Gradient(x, Out, fx);
+    FuncCalls += __Jacobian_Evaluations(NumericalGradient);
+}
+
+float64 LBFGSMinimizer::LineSearch(std::span<const float64> x, float64 fx, float64 Slope, float64& NewF)
+{
+    // 满足强沃尔夫条件的线搜索，参见Nocedal & Wright, Numerical Optimization, 算法3.5和3.6
+    const uint64 MaxSteps = 30;
+    float64 Slope0 = Slope;
+    auto Phi = [&](float64 a, float64& dPhi)
+    {
+        for (uint64 i = 0; i < Dims; ++i) {NewX[i] = x[i] + a * Direction[i];}
+        NewF = Evaluate(NewX);
+        ComputeGradient(NewX, NewF, NewGrad);
+        dPhi = __Dot(NewGrad, Direction);
+        return NewF;
+    };
+
+    auto Zoom = [&](float64 Lo, float64 fLo, float64 dLo, float64 Hi, float64 fHi)
+    {
+        for (uint64 i = 0; i < MaxSteps; ++i)
+        {
+            // 二次插值，离端点过近时改用二分
+            float64 Width = Hi - Lo;
+            float64 Denom = 2. * (fHi - fLo - dLo * Width);
+            float64 a = Denom > 0 ? Lo - dLo * Width * Width / Denom : Lo + Width / 2.;
+            float64 Lower = min(Lo, Hi) + 0.1 * abs(Width), Upper = max(Lo, Hi) - 0.1 * abs(Width);
+            if (!(a >= Lower && a <= Upper)) {a = Lo + Width / 2.;}
+
+            float64 dPhi, f = Phi(a, dPhi);
+            if (f > fx + WolfeC1 * a * Slope0 || f >= fLo)
+            {
+                Hi = a;
+                fHi = f;
+            }
+            else
+            {
+                if (abs(dPhi) <= -WolfeC2 * Slope0) {return a;}
+                if (dPhi * (Hi - Lo) >= 0)
+                {
+                    Hi = Lo;
+                    fHi = fLo;
+                }
+                Lo = a;
+                fLo = f;
+                dLo = dPhi;
+            }
+        }
+        // 未能满足曲率条件时退回到满足充分下降条件的点
+        if (Lo > 0)
+        {
+            float64 dPhi;
+            Phi(Lo, dPhi);
+        }
+        return Lo;
+    };
+
+    float64 Prev = 0, fPrev = fx, dPrev = Slope0, a = 1;
+    for (uint64 i = 0; i < MaxSteps; ++i)
+    {
+        float64 dPhi, f = Phi(a, dPhi);
+        if (!std::isfinite(f) && a > 0)
+        {
+            a = (Prev + a) / 2.;
+            continue;
+        }
+        if (f > fx + WolfeC1 * a * Slope0 || (i && f >= fPrev)) {return Zoom(Prev, fPrev, dPrev, a, f);}
+        if (abs(dPhi) <= -WolfeC2 * Slope0) {return a;}
+        if (dPhi >= 0) {return Zoom(a, f, dPhi, Prev, fPrev);}
+        Prev = a;
+        fPrev = f;
+        dPrev = dPhi;
+        a *= 2;
+    }
+    return Prev;
+}
+
+LBFGSMinimizer::ResultType LBFGSMinimizer::operator()(std::span<const float64> x0)
+{
+    uint64 n = Dims, m = max(HistorySize, 1ull);
+    if (x0.size() != n) {throw std::logic_error("Dimension of initial point mismatch.");}
+    if (S.col() != m || S.row() != n)
+    {
+        S = DynamicMatrix<float64>({m, n});
+        Y = DynamicMatrix<float64>({m, n});
+        Rho.resize(m);
+        Alpha.resize(m);
+    }
+    FuncCalls = 0;
+    Stored = 0;
+    Newest = 0;
+
+    float64 gtol = pow(10, -GTolerence), ftol = pow(10, -FTolerence);
+    uint64 MaxIter = uint64(floor(pow(10, MaxIteration)));
+
+    ResultType Result;
+    Result.x.assign(x0.begin(), x0.end());
+    std::vector<float64>& x = Result.x;
+    float64 fx = Evaluate(x);
+    ComputeGradient(x, fx, Grad);
+
+    for (; Result.Iterations < MaxIter; ++Result.Iterations)
+    {
+        if (__Max_Norm(Grad) <= gtol)
+        {
+            Result.Converged = 1;
+            break;
+        }
+
+        // 双循环递推计算搜索方向
+        Direction = Grad;
+        for (uint64 j = 0; j < Stored; ++j)
+        {
+            uint64 k = (Newest + m - j) % m;
+            std::span<const float64> s(&S.at(k, 0), n), y(&Y.at(k, 0), n);
+            Alpha[k] = Rho[k] * __Dot(s, Direction);
+            for (uint64 i = 0; i < n; ++i) {Direction[i] -= Alpha[k] * y[i];}
+        }
+        float64 Gamma;
+        if (Stored)
+        {
+            std::span<const float64> s(&S.at(Newest, 0), n), y(&Y.at(Newest, 0), n);
+            Gamma = __Dot(s, y) / __Dot(y, y);
+        }
+        else {Gamma = min(1., 1. / __Max_Norm(Grad));} // 第一步缩小步长，避免走得太远
+        for (auto& v : Direction) {v *= Gamma;}
+        for (uint64 j = Stored; j-- > 0;)
+        {
+            uint64 k = (Newest + m - j) % m;
+            std::span<const float64> s(&S.at(k, 0), n), y(&Y.at(k, 0), n);
+            float64 Beta = Rho[k] * __Dot(y, Direction);
+            for (uint64 i = 0; i < n; ++i) {Direction[i] += s[i] * (Alpha[k] - Beta);}
+        }
+        for (auto& v : Direction) {v = -v;}
+
+        float64 Slope = __Dot(Grad, Direction);
+        if (Slope >= 0)
+        {
+            // 不是下降方向，清空历史并退回最速下降
+            Stored = 0;
+            float64 Scale = min(1., 1. / __Max_Norm(Grad));
+            for (uint64 i = 0; i < n; ++i) {Direction[i] = -Scale * Grad[i];}
+            Slope = __Dot(Grad, Direction);
+        }
+
+        float64 NewF;
+        float64 Step = LineSearch(x, fx, Slope, NewF);
+        if (!Step) {break;}
+
+        // 保存历史，曲率不满足正定时跳过。历史已满时第k列仍是最早的一对，须在接受后才能覆盖
+        float64 sy = 0, yy = 0;
+        for (uint64 i = 0; i < n; ++i)
+        {
+            NewS[i] = NewX[i] - x[i];
+            NewY[i] = NewGrad[i] - Grad[i];
+            sy += NewS[i] * NewY[i];
+            yy += NewY[i] * NewY[i];
+        }
+        if (sy > DOUBLE_EPSILON * yy)
+        {
+            uint64 k = Stored ? (Newest + 1) % m : Newest;
+            for (uint64 i = 0; i < n; ++i)
+            {
+                S.at(k, i) = NewS[i];
+                Y.at(k, i) = NewY[i];
+            }
+            Newest = k;
+            Rho[k] = 1. / sy;
+            Stored = min(Stored + 1, m);
+        }
+
+        bool Stalled = fx - NewF <= ftol * max({abs(fx), abs(NewF), 1.});
+        x = NewX;
+        Grad = NewGrad;
+        fx = NewF;
+        if (Stalled)
+        {
+            ++Result.Iterations;
+            Result.Converged = 1;
+            break;
+        }
+    }
+
+    Result.fx = fx;
+    Result.FuncCalls = FuncCalls;
+    return Result;
+}
+
+// ------------------------------------------------------------------------------------- //
+
+// 对称正定矩阵的楚列斯基分解，结果的下三角部分为L，失败(矩阵不正定)时返回0
+static bool __Cholesky_Decompose(DynamicMatrix<float64>& A)
+{
+    uint64 n = A.col();
+    for (uint64 j = 0; j < n; ++j)
+    {
+        float64 d = A.at(j, j);
+        for (uint64 k = 0; k < j; ++k) {d -= A.at(k, j) * A.at(k, j);}
+        if (!(d > 0)) {return 0;}
+        d = sqrt(d);
+        A.at(j, j) = d;
+        for (uint64 i = j + 1; i < n; ++i)
+        {
+            float64 s = A.at(j, i);
+            for (uint64 k = 0; k < j; ++k) {s -= A.at(k, i) * A.at(k, j);}
+            A.at(j, i) = s / d;
+        }
+    }
+    return 1;
+}
+
+// 使用分解结果求解Ax = b，结果写回b
+static void __Cholesky_Solve(const DynamicMatrix<float64>& L, std::span<float64> b)
+{
+    uint64 n = L.col();
+    for (uint64 i = 0; i < n; ++i)
+    {
+        for (uint64 k = 0; k < i; ++k) {b[i] -= L.at(k, i) * b[k];}
+        b[i] /= L.at(i, i);
+    }
+    for (uint64 i = n; i-- > 0;)
+    {
+        for (uint64 k = i + 1; k < n; ++k) {b[i] -= L.at(i, k) * b[k];}
+        b[i] /= L.at(i, i);
+    }
+}
+
+LevenbergMarquardtMinimizer::LevenbergMarquardtMinimizer(JacobianEngine Engine, ResidualType Func,
+    uint64 Dims, uint64 Residuals)
+    : Mybase(nullptr, nullptr, Dims), Residual(Func), Residuals(Residuals),
+    J({Dims, Residuals}), Normal({Dims, Dims}), Factor({Dims, Dims}),
+    r(Residuals), NewR(Residuals), Gradient(Dims), Scale(Dims), Step(Dims), NewX(Dims),
+    Jacobian(Engine)
+{
+    if (!Residuals) {throw std::logic_error("Number of residuals must be positive.");}
+}
+
+LevenbergMarquardtMinimizer::LevenbergMarquardtMinimizer(ResidualType Func, uint64 Dims, uint64 Residuals)
+    : LevenbergMarquardtMinimizer(JacobianEngine(Func, Dims, Residuals), Func, Dims, Residuals) {}
+
+LevenbergMarquardtMinimizer LevenbergMarquardtMinimizer::Batched(JacobianEngine::BatchFuncType Func,
+    uint64 Dims, uint64 Residuals)
+{
+    // 单个点的残差也可以直接用批量函数计算
+    return LevenbergMarquardtMinimizer(JacobianEngine::Batched(Func, Dims, Residuals), Func, Dims, Residuals);
+}
+
+void LevenbergMarquardtMinimizer::EvaluateResidual(std::span<const float64> x, std::span<float64> Out)
+{
+    Residual(x, Out);
+    ++FuncCalls;
+}
+
+LevenbergMarquardtMinimizer::ResultType LevenbergMarquardtMinimizer::operator()(std::span<const float64> x0)
+{
+    uint64 n = Dims, m = Residuals;
+    if (x0.size() != n) {throw std::logic_error("Dimension of initial point mismatch.");}
+    FuncCalls = 0;
+    Jacobian.Threads = Threads;
+
+    float64 gtol = pow(10, -GTolerence), xtol = pow(10, -XTolerence), ftol = pow(10, -FTolerence);
+    uint64 MaxIter = uint64(floor(pow(10, MaxIteration)));
+
+    ResultType Result;
+    Result.x.assign(x0.begin(), x0.end());
+    std::vector<float64>& x = Result.x;
+    EvaluateResidual(x, r);
+    float64 Cost = __Dot(r, r) / 2.;
+
+    bool NeedJacobian = 1;
+    float64 Lambda = -1, Nu = 2;
+    std::fill(Scale.begin(), Scale.end(), 0.);
+    for (; Result.Iterations < MaxIter; ++Result.Iterations)
+    {
+        if (NeedJacobian)
+        {
+            Jacobian(x, J, r);
+            FuncCalls += __Jacobian_Evaluations(Jacobian);
+            // JᵀJ与Jᵀr，J的每列连续存放
+            for (uint64 a = 0; a < n; ++a)
+            {
+                std::span<const float64> Ja(&J.at(a, 0), m);
+                for (uint64 b = 0; b <= a; ++b)
+                {
+                    Normal.at(a, b) = Normal.at(b, a) = __Dot(Ja, std::span<const float64>(&J.at(b, 0), m));
+                }
+                Gradient[a] = __Dot(Ja, r);
+                Scale[a] = max(Scale[a], Normal.at(a, a));
+            }
+            NeedJacobian = 0;
+
+            if (__Max_Norm(Gradient) <= gtol)
+            {
+                Result.Converged = 1;
+                break;
+            }
+            if (Lambda < 0)
+            {
+                float64 MaxDiag = 0;
+                for (uint64 a = 0; a < n; ++a) {MaxDiag = max(MaxDiag, Normal.at(a, a));}
+                Lambda = InitialDamping * (MaxDiag ? MaxDiag : 1.);
+            }
+        }
+
+        // 求解(JᵀJ + λD)δ = -Jᵀr，D为JᵀJ历史最大对角元
+        Factor = Normal;
+        for (uint64 a = 0; a < n; ++a) {Factor.at(a, a) += Lambda * (Scale[a] ? Scale[a] : 1.);}
+        if (!__Cholesky_Decompose(Factor))
+        {
+            Lambda *= Nu;
+            Nu *= 2;
+            continue;
+        }
+        for (uint64 a = 0; a < n; ++a) {Step[a] = -Gradient[a];}
+        __Cholesky_Solve(Factor, Step);
+
+        float64 StepNorm = sqrt(__Dot(Step, Step)), xNorm = sqrt(__Dot(x, x));
+        if (StepNorm <= xtol * (xNorm + xtol))
+        {
+            Result.Converged = 1;
+            break;
+        }
+
+        for (uint64 a = 0; a < n; ++a) {NewX[a] = x[a] + Step[a];}
+        EvaluateResidual(NewX, NewR);
+        float64 NewCost = __Dot(NewR, NewR) / 2.;
+
+        // 二次模型预测的下降量 1/2 * δᵀ(λDδ - Jᵀr)
+        float64 Predicted = 0;
+        for (uint64 a = 0; a < n; ++a)
+        {
+            Predicted += Step[a] * (Lambda * (Scale[a] ? Scale[a] : 1.) * Step[a] - Gradient[a]);
+        }
+        Predicted /= 2.;
+        float64 Ratio = Predicted > 0 ? (Cost - NewCost) / Predicted : -1;
+
+        if (Ratio > 0 && std::isfinite(NewCost))
+        {
+            float64 Decrease = Cost - NewCost;
+            x = NewX;
+            r = NewR;
+            Cost = NewCost;
+            Lambda *= max(1. / 3., 1. - pow(2. * Ratio - 1., 3));
+            Nu = 2;
+            NeedJacobian = 1;
+            if (Decrease <= ftol * Cost)
+            {
+                ++Result.Iterations;
+                Result.Converged = 1;
+                break;
+            }
+        }
+        else
+        {
+            Lambda *= Nu;
+            Nu *= 2;
+        }
+    }
+
+    Result.fx = Cost;
+    Result.FuncCalls = FuncCalls;
+    return Result;
+}
+
 _SCICXX_END
 _CSE_END
@@ -1,26 +1,126 @@
 #include "CSE/Base/AdvMath.h"
 #include "CSE/Base/Algorithms.h"
+#include "CSE/Base/ConstLists.h"
+#include <chrono>
+#include <thread>
+#include <typeinfo>
+
+// Text-formating header
+#if USE_FMTLIB
+#include <fmt/format.h>
+using namespace fmt;
+#else
+#include <format>
+#endif
 
 _CSE_BEGIN
 _SCICXX_BEGIN
 
 ////////////////////////////////// 微分方程基类 //////////////////////////////////
 
-float64 OrdinaryDifferentialEquation::CurrentPoint() const
+void OrdinaryDifferentialEquation::Evaluate(float64 x, std::span<const float64> y, std::span<float64> Out)const
+{
+    if (InPlaceInvoker)
+    {
+        InPlaceInvoker(x, y, Out);
+        return;
+    }
+    ValueArray Result = Invoker(x, ValueArray(y.begin(), y.end()));
+    if (Result.size() != Out.size())
+    {
+        throw std::logic_error("Solution count is not equal to parameter count.");
+    }
+    std::copy(Result.begin(), Result.end(), Out.begin());
+}
+
+void OrdinaryDifferentialEquation::InterpolateStep(float64, std::span<float64>)
+{
+    throw std::logic_error("This engine does not support interpolation inside a step.");
+}
+
+OrdinaryDifferentialEquation::OutputPolicy
+OrdinaryDifferentialEquation::OutputPolicy::StreamToFile(std::ostream& File)
+{
+    OutputPolicy Policy;
+    Policy.Mode = Stream;
+    Policy.StateCallback = [&File](float64 x, std::span<const float64> y)
+    {
+        File << std::format("{}", x);
+        for (float64 i : y) {File << std::format(" {}", i);}
+        File << '\n';
+    };
+    return Policy;
+}
+
+void OrdinaryDifferentialEquation::BeginRecord(float64 x, std::span<const float64> y)
 {
-    return Direction ? (StateBuffer.begin())->first : (--StateBuffer.end())->first;
+    float64 Sign = Direction ? -1. : 1.;
+    if (Output.Mode == OutputPolicy::RingBuffer && !Output.Capacity)
+    {
+        throw std::logic_error("Capacity of ring buffer must be positive.");
+    }
+    if (Output.Mode == OutputPolicy::Decimate)
+    {
+        for (uint64 i = 1; i < Output.Times.size(); ++i)
+        {
+            if (Sign * Output.Times[i] < Sign * Output.Times[i - 1])
+            {
+                throw std::logic_error("Output times are not sorted in the direction of integration.");
+            }
+        }
+        // 早于起点的时刻无法输出，直接跳过
+        NextOutput = 0;
+        while (NextOutput < Output.Times.size() && Sign * Output.Times[NextOutput] < Sign * x) {++NextOutput;}
+    }
+    LastPoint = PrevLastPoint = __Float64::FromBytes(BIG_NAN_DOUBLE);
+    Record(x, y);
 }
 
-float64 OrdinaryDifferentialEquation::PrevPoint() const
+void OrdinaryDifferentialEquation::Record(float64 x, std::span<const float64> y)
 {
-    if (StateBuffer.size() <= 1) {return __Float64::FromBytes(BIG_NAN_DOUBLE);}
-    if (Direction)
+    PrevLastPoint = LastPoint;
+    LastPoint = x;
+
+    // 复用最早的节点，缓冲区填满后不再分配内存
+    auto Replace = [&](StateType::iterator Oldest)
+    {
+        auto Node = StateBuffer.extract(Oldest);
+        Node.key() = x;
+        Node.mapped().assign(y.begin(), y.end());
+        StateBuffer.insert(std::move(Node));
+    };
+
+    switch (Output.Mode)
     {
-        auto begin = StateBuffer.begin();
-        return (++begin)->first;
+    case OutputPolicy::KeepAll:
+    default:
+        StateBuffer.insert({x, ValueArray(y.begin(), y.end())});
+        break;
+    case OutputPolicy::Stream:
+        if (Output.StateCallback) {Output.StateCallback(x, y);}
+        [[fallthrough]];
+    case OutputPolicy::KeepLast:
+        if (StateBuffer.empty()) {StateBuffer.insert({x, ValueArray(y.begin(), y.end())});}
+        else {Replace(StateBuffer.begin());}
+        break;
+    case OutputPolicy::RingBuffer:
+        if (StateBuffer.size() < Output.Capacity) {StateBuffer.insert({x, ValueArray(y.begin(), y.end())});}
+        else {Replace(Direction ? std::prev(StateBuffer.end()) : StateBuffer.begin());}
+        break;
+    case OutputPolicy::Decimate:
+    {
+        // 输出落在(PrevLastPoint, x]内的时刻，初值只输出恰好位于起点的时刻
+        float64 Sign = Direction ? -1. : 1.;
+        while (NextOutput < Output.Times.size() && Sign * Output.Times[NextOutput] <= Sign * x)
+        {
+            float64 t = Output.Times[NextOutput++];
+            ValueArray Value(y.begin(), y.end());
+            if (t != x) {InterpolateStep(t, Value);}
+            StateBuffer.insert({t, std::move(Value)});
+        }
+        break;
+    }
     }
-    auto end = --StateBuffer.end();
-    return (--end)->first;
 }
 
 void __cdecl OrdinaryDifferentialEquation::InvokeRun() noexcept(0)
@@ -51,6 +151,327 @@ void __cdecl OrdinaryDifferentialEquation::InvokeRun() noexcept(0)
 
 
 
+////////////////////////////////// 稠密输出单步法 /////////////////////////////////
+
+void __Dense_Ordinary_Differential_Equation::Clear()
+{
+    State = Processing;
+    EndPoint = 0;
+    Direction = 0;
+    StateBuffer.clear();
+    SegmentStarts.clear();
+    SegmentEnds.clear();
+    SegmentBase.clear();
+    SegmentCoeffs.clear();
+    SegmentHead = 0;
+    LastPoint = PrevLastPoint = __Float64::FromBytes(BIG_NAN_DOUBLE);
+    NextOutput = 0;
+    PrevT = CurrentT = 0;
+    EventLog.clear();
+}
+
+void __Dense_Ordinary_Differential_Equation::BeginIntegration(const ValueArray& InitState, float64 First, float64 Last)
+{
+    EndPoint = Last;
+    Direction = __Float64(EndPoint - First).Negative;
+    PrevT = CurrentT = First;
+    PrevY = CurrentY = InitState;
+    StepCoeffs.resize(EquationCount * DenseOutputOrder);
+    StepCoeffsPoint = __Float64::FromBytes(BIG_NAN_DOUBLE);
+    EventValues.resize(EventList.size());
+    for (uint64 i = 0; i < EventList.size(); ++i) {EventValues[i] = EventList[i].Function(First, CurrentY);}
+    EventLog.clear();
+    BeginRecord(First, InitState);
+    State = Processing;
+}
+
+float64 __Dense_Ordinary_Differential_Equation::SelectInitialStep(std::span<const float64> f0,
+    float64 ErrorOrder, float64 RelToler, float64 AbsToler)const
+{
+    const uint64 n = EquationCount;
+    const float64 Sign = Direction ? -1 : 1;
+    auto RMS = [n](auto&& Func)
+    {
+        float64 Sum = 0;
+        for (uint64 i = 0; i < n; ++i) {Sum += pow(Func(i), 2);}
+        return sqrt(Sum / float64(n));
+    };
+
+    ValueArray Scale(n);
+    for (uint64 i = 0; i < n; ++i) {Scale[i] = AbsToler + abs(CurrentY[i]) * RelToler;}
+
+    float64 d0 = RMS([&](uint64 i){return CurrentY[i] / Scale[i];});
+    float64 d1 = RMS([&](uint64 i){return f0[i] / Scale[i];});
+    float64 h0;
+    if (d0 < 1E-5 || d1 < 1E-5) {h0 = 1E-6;}
+    else {h0 = 0.01 * d0 / d1;}
+
+    ValueArray y1(n), f1(n);
+    for (uint64 i = 0; i < n; ++i) {y1[i] = CurrentY[i] + h0 * Sign * f0[i];}
+    Evaluate(CurrentT + h0 * Sign, y1, f1);
+
+    float64 d2 = RMS([&](uint64 i){return (f1[i] - f0[i]) / Scale[i];}) / h0;
+
+    float64 h1;
+    if (d1 <= 1E-15 && d2 <= 1E-15){h1 = max(1E-6, h0 * 1E-3);}
+    else {h1 = yroot((0.01 / max(d1, d2)), ErrorOrder + 1);}
+
+    return min(100 * h0, h1);
+}
+
+int __Dense_Ordinary_Differential_Equation::Run()
+{
+    int ExitCode = Advance();
+    if (ExitCode) {return ExitCode;}
+    bool Terminate = !EventList.empty() && LocateEvents();
+    Record(CurrentT, CurrentY);
+    return Terminate ? Terminated : 0;
+}
+
+bool __Dense_Ordinary_Differential_Equation::LocateEvents()
+{
+    const uint64 n = EquationCount;
+    const float64 Sign = Direction ? -1. : 1.;
+    ValueArray Buffer(n);
+    // 与SciPy相同，求根的绝对和相对容差都取4倍机器精度，绝对容差再乘以步长使其与时间的尺度无关
+    const float64 RootToler = 4. * DOUBLE_EPSILON;
+    const float64 RootAbsNLog = -log(RootToler * abs(CurrentT - PrevT));
+    const float64 RootRelNLog = -log(RootToler);
+
+    // 找出符号改变的事件，在插值多项式上求根
+    std::vector<std::pair<float64, uint64>> Found;
+    for (uint64 i = 0; i < EventList.size(); ++i)
+    {
+        float64 Old = EventValues[i];
+        float64 New = EventValues[i] = EventList[i].Function(CurrentT, CurrentY);
+        bool Up = Old < 0 && New >= 0, Down = Old > 0 && New <= 0;
+        int Dir = EventList[i].Direction;
+        if (!((Up && Dir >= 0) || (Down && Dir <= 0))) {continue;}
+
+        float64 Root = CurrentT;
+        if (New != 0)
+        {
+            Root = BrentInverseFunction::QSolve([&](float64 t)
+            {
+                InterpolateStep(t, Buffer);
+                return EventList[i].Function(t, Buffer);
+            }, {PrevT, CurrentT}, RootAbsNLog, RootRelNLog);
+        }
+        Found.push_back({Root, i});
+    }
+    if (Found.empty()) {return false;}
+
+    std::stable_sort(Found.begin(), Found.end(), [Sign](const auto& a, const auto& b)
+    {
+        return Sign * a.first < Sign * b.first;
+    });
+
+    bool Terminate = false;
+    float64 TerminalPoint = 0;
+    for (const auto& [Root, i] : Found)
+    {
+        // 终止事件之后的事件不会发生，同一时刻的其他事件仍然记录
+        if (Terminate && Root != TerminalPoint) {break;}
+        InterpolateStep(Root, Buffer);
+        EventLog.push_back({i, Root, Buffer});
+        if (EventList[i].Terminal && !Terminate)
+        {
+            Terminate = true;
+            TerminalPoint = Root;
+        }
+    }
+    if (!Terminate || TerminalPoint == CurrentT) {return Terminate;}
+
+    // 把这一步截短到事件时刻，插值系数按新的步长缩放：Q'[k] = Q[k] * r^k
+    InterpolateStep(TerminalPoint, Buffer);
+    float64 r = (TerminalPoint - PrevT) / (CurrentT - PrevT);
+    for (uint64 j = 0; j < n; ++j)
+    {
+        float64 Scale = 1;
+        for (uint64 k = 0; k < DenseOutputOrder; ++k)
+        {
+            StepCoeffs[j * DenseOutputOrder + k] *= Scale;
+            Scale *= r;
+        }
+    }
+    CurrentT = StepCoeffsPoint = TerminalPoint;
+    CurrentY = Buffer;
+    for (uint64 i = 0; i < EventList.size(); ++i) {EventValues[i] = EventList[i].Function(CurrentT, CurrentY);}
+    return true;
+}
+
+__Dense_Ordinary_Differential_Equation::StateCode __Dense_Ordinary_Differential_Equation::Step()
+{
+    if (State != Processing) {throw std::logic_error("Engine is finished.");}
+    if (CurrentT == EndPoint)
+    {
+        State = Succeeded;
+        return State;
+    }
+    int ExitCode = Advance();
+    if (!ExitCode && !EventList.empty() && LocateEvents()) {ExitCode = Terminated;}
+    if (ExitCode) {State = StateCode(ExitCode);}
+    else if (CurrentT == EndPoint) {State = Succeeded;}
+    return State;
+}
+
+uint64 __Dense_Ordinary_Differential_Equation::SegmentSlot(uint64 Index)const
+{
+    return (SegmentHead + Index) % SegmentStarts.size();
+}
+
+float64* __Dense_Ordinary_Differential_Equation::AppendSegment()
+{
+    const uint64 n = EquationCount, Order = DenseOutputOrder;
+    uint64 Capacity = 1;
+    if (Output.Mode == OutputPolicy::KeepAll) {Capacity = 0;}
+    else if (Output.Mode == OutputPolicy::RingBuffer) {Capacity = Output.Capacity;}
+
+    uint64 Slot;
+    if (!Capacity || SegmentStarts.size() < Capacity)
+    {
+        Slot = SegmentStarts.size();
+        SegmentStarts.push_back(PrevT);
+        SegmentEnds.push_back(CurrentT);
+        SegmentBase.resize(SegmentBase.size() + n);
+        SegmentCoeffs.resize(SegmentCoeffs.size() + n * Order);
+    }
+    else
+    {
+        // 缓冲区已满，覆盖最早的一段
+        Slot = SegmentHead;
+        SegmentHead = (SegmentHead + 1) % Capacity;
+        SegmentStarts[Slot] = PrevT;
+        SegmentEnds[Slot] = CurrentT;
+    }
+    std::copy(PrevY.begin(), PrevY.end(), SegmentBase.begin() + Slot * n);
+    return SegmentCoeffs.data() + Slot * n * Order;
+}
+
+void __Dense_Ordinary_Differential_Equation::SaveDenseOutput()
+{
+    float64* Q = AppendSegment();
+    // 插值系数已经由InterpolateStep算出(或因终止事件被截短)时直接使用
+    if (StepCoeffsPoint == CurrentT) {std::copy(StepCoeffs.begin(), StepCoeffs.end(), Q);}
+    else {BuildSegment(Q);}
+    if (Output.Mode == OutputPolicy::Stream && Output.SegmentCallback)
+    {
+        Output.SegmentCallback(PrevT, CurrentT, PrevY,
+            std::span<const float64>(Q, EquationCount * DenseOutputOrder));
+    }
+}
+
+// y = Base + h * s * (Q[0] + s * (Q[1] + ...))
+static void __Dense_Output_Horner(const float64* Base, const float64* Q, uint64 n, uint64 Order,
+    float64 h, float64 s, float64* Out)
+{
+    for (uint64 j = 0; j < n; ++j)
+    {
+        const float64* q = Q + j * Order;
+        float64 Sum = 0;
+        for (uint64 k = Order; k > 0; --k) {Sum = Sum * s + q[k - 1];}
+        Out[j] = Base[j] + h * s * Sum;
+    }
+}
+
+void __Dense_Ordinary_Differential_Equation::InterpolateStep(float64 x, std::span<float64> Out)
+{
+    // 同一步内的多个输出时刻共用一组系数
+    if (StepCoeffsPoint != CurrentT)
+    {
+        BuildSegment(StepCoeffs.data());
+        StepCoeffsPoint = CurrentT;
+    }
+    float64 h = CurrentT - PrevT;
+    __Dense_Output_Horner(PrevY.data(), StepCoeffs.data(), EquationCount, DenseOutputOrder,
+        h, (x - PrevT) / h, Out.data());
+}
+
+uint64 __Dense_Ordinary_Differential_Equation::FindSegment(float64 x, uint64 Hint)const
+{
+    const uint64 Count = SegmentEnds.size();
+    if (!Count) {throw std::logic_error("Point is out of range.");}
+
+    // 在求解方向上，若第i段的终点在x之前则Before(i)为真，所求即第一个使其为假的段
+    const float64 Sign = Direction ? -1. : 1.;
+    auto Before = [&](uint64 i) {return Sign * SegmentEnds[SegmentSlot(i)] < Sign * x;};
+
+    uint64 Lo = 0, Hi = Count;
+    if (Hint < Count)
+    {
+        uint64 Step = 1;
+        if (Before(Hint))
+        {
+            Lo = Hint + 1;
+            Hi = Lo;
+            while (Hi < Count && Before(Hi))
+            {
+                Lo = Hi + 1;
+                Hi = min(Count, Hi + Step);
+                Step *= 2;
+            }
+        }
+        else
+        {
+            Lo = Hi = Hint;
+            while (Lo > 0)
+            {
+                uint64 Probe = Lo > Step ? Lo - Step : 0;
+                if (Before(Probe))
+                {
+                    Lo = Probe + 1;
+                    break;
+                }
+                Lo = Hi = Probe;
+                Step *= 2;
+            }
+        }
+    }
+
+    while (Lo < Hi)
+    {
+        uint64 Mid = Lo + (Hi - Lo) / 2;
+        if (Before(Mid)) {Lo = Mid + 1;}
+        else {Hi = Mid;}
+    }
+
+    if (Lo == Count || Sign * SegmentStarts[SegmentSlot(Lo)] > Sign * x)
+    {
+        throw std::logic_error("Point is out of range.");
+    }
+    return Lo;
+}
+
+void __Dense_Ordinary_Differential_Equation::EvaluateSegment(uint64 Index, float64 x, float64* Out)const
+{
+    const uint64 n = EquationCount, Order = DenseOutputOrder;
+    uint64 Slot = SegmentSlot(Index);
+    float64 h = SegmentEnds[Slot] - SegmentStarts[Slot];
+    __Dense_Output_Horner(SegmentBase.data() + Slot * n, SegmentCoeffs.data() + Slot * n * Order,
+        n, Order, h, (x - SegmentStarts[Slot]) / h, Out);
+}
+
+__Dense_Ordinary_Differential_Equation::ValueArray __Dense_Ordinary_Differential_Equation::operator()(float64 _Xx) const
+{
+    ValueArray Result(EquationCount);
+    EvaluateSegment(FindSegment(_Xx, -1), _Xx, Result.data());
+    return Result;
+}
+
+void __Dense_Ordinary_Differential_Equation::Evaluate(std::span<const float64> Times, std::span<float64> Output)const
+{
+    if (Output.size() != Times.size() * EquationCount)
+    {
+        throw std::logic_error("Output size is not equal to time count times equation count.");
+    }
+    uint64 Index = 0;
+    for (uint64 i = 0; i < Times.size(); ++i)
+    {
+        Index = FindSegment(Times[i], Index);
+        EvaluateSegment(Index, Times[i], Output.data() + i * EquationCount);
+    }
+}
+
 ////////////////////////////////// 龙格-库塔引擎 /////////////////////////////////
 
 #include "ODEs_RungeKutta.tbl"
@@ -62,11 +483,7 @@ void RungeKuttaODEEngine::Init(ValueArray InitState, float64 First, float64 Last
 
 void RungeKuttaODEEngine::Clear()
 {
-    State = Processing;
-    EndPoint = 0;
-    Direction = 0;
-    StateBuffer.clear();
-    Interpolants.clear();
+    Mybase::Clear();
     CurrentFx = ValueArray(0.);
     KTable.fill(0);
     AbsStep = 0;
@@ -81,54 +498,48 @@ float64 RungeKuttaODEEngine::RMSNorm(std::vector<float64> Input)
 
 void RungeKuttaODEEngine::Init(ValueArray InitState, float64 First, float64 Last, float64 InitStep)
 {
-    StateBuffer.insert({First, InitState});
-    EndPoint = Last;
-    CurrentFx = Invoker(First, InitState);
-    if (CurrentFx.size() != InitState.size())
+    if (InitState.size() != EquationCount)
     {
         throw std::logic_error("Solution count is not equal to parameter count.");
     }
-    Direction = __Float64(EndPoint - CurrentPoint()).Negative;
-    State = Processing;
+    BeginIntegration(InitState, First, Last);
+
+    // 分配工作空间
+    NewY.resize(EquationCount);
+    StageY.resize(EquationCount);
+    ErrorScale.resize(EquationCount);
+    CurrentFx.resize(EquationCount);
+    Evaluate(First, CurrentY, CurrentFx);
+
     if (isnan(InitStep)){SetInitStep();}
     else {AbsStep = InitStep;}
 }
 
 void RungeKuttaODEEngine::SetInitStep()
 {
-    if (StateBuffer.empty()) {AbsStep = __Float64::FromBytes(POS_INF_DOUBLE);}
-
-    float64 RelToler = pow(10, -RelTolerNLog);
-    float64 AbsToler = pow(10, -AbsTolerNLog);
+    AbsStep = SelectInitialStep(CurrentFx, ErrorEsitmatorOrder,
+        pow(10, -RelTolerNLog), pow(10, -AbsTolerNLog));
+}
 
-    ValueArray y0 = StateBuffer.begin()->second;
-    ValueArray Scale;
-    for (uint64 i = 0; i < EquationCount; ++i)
+float64 RungeKuttaODEEngine::ErrorNorm(float64 h)const
+{
+    const uint64 n = EquationCount;
+    const float64* K = &KTable.at(0, 0);
+    float64 EENTempSum = 0;
+    for (uint64 j = 0; j < n; ++j)
     {
-        Scale.push_back(AbsToler + abs(y0[i]) * RelToler);
+        float64 Error = 0;
+        for (uint64 k = 0; k <= NStages; ++k) {Error += K[k * n + j] * ETable[k];}
+        EENTempSum += pow(Error * h / ErrorScale[j], 2);
     }
-
-    float64 d0 = RMSNorm(y0 / Scale), d1 = RMSNorm(CurrentFx / Scale), h0;
-
-    if (d0 < 1E-5 || d1 < 1E-5) {h0 = 1E-6;}
-    else {h0 = 0.01 * d0 / d1;}
-
-    ValueArray y1 = y0 + h0 * (Direction ? -1 : 1) * CurrentFx, f1;
-    f1 = Invoker(CurrentPoint() + h0 * (Direction ? -1 : 1), y1);
-
-    float64 d2 = RMSNorm((f1 - CurrentFx) / Scale) / h0;
-
-    float64 h1;
-    if (d1 <= 1E-15 && d2 <= 1E-15){h1 = max(1E-6, h0 * 1E-3);}
-    else {h1 = yroot((0.01 / max(d1, d2)), ErrExponent);}
-
-    AbsStep = min(100 * h0, h1);
+    return sqrt(EENTempSum / float64(n));
 }
 
-int RungeKuttaODEEngine::Run()
+int RungeKuttaODEEngine::Advance()
 {
-    auto t = CurrentPoint();
-    ValueArray y = Direction ? StateBuffer.begin()->second : (--StateBuffer.end())->second;
+    float64 t = CurrentT;
+    const ValueArray& y = CurrentY;
+    const uint64 n = EquationCount;
 
     float64 RelToler = pow(10, -RelTolerNLog);
     float64 AbsToler = pow(10, -AbsTolerNLog);
@@ -142,7 +553,7 @@ int RungeKuttaODEEngine::Run()
 
     bool Accept = 0, Reject = 0;
     float64 h, NextT;
-    ValueArray NewY, NewF;
+    float64* K = &KTable.at(0, 0); // 第k级导数的第j个分量为K[k * n + j]
 
     while (!Accept)
     {
@@ -157,51 +568,36 @@ int RungeKuttaODEEngine::Run()
         }
 
         h = NextT - t;
-        float64 NewAbsStep = abs(h);
 
-        KTable.SetColumn(0, CurrentFx);
-        for (int i = 1; i < NStages; ++i)
+        std::copy(CurrentFx.begin(), CurrentFx.end(), K);
+        for (uint64 i = 1; i < NStages; ++i)
         {
-            ValueArray dy(EquationCount);
-            for (int j = 0; j < EquationCount; ++j)
+            const float64* a = ATable + i * ATableStride;
+            for (uint64 j = 0; j < n; ++j)
             {
-                dy[j] = 0;
-                for (int k = 0; k < i; ++k)
-                {
-                    dy[j] += KTable.at(k, j) * ATable[i * StepTakenOrder + k];
-                }
-                dy[j] *= h;
+                float64 dy = 0;
+                for (uint64 k = 0; k < i; ++k) {dy += K[k * n + j] * a[k];}
+                StageY[j] = y[j] + h * dy;
             }
-            KTable.SetColumn(i, Invoker(t + CTable[i] * h, y + dy));
+            Evaluate(t + CTable[i] * h, StageY, std::span<float64>(K + i * n, n));
         }
 
-        DynamicMatrix<float64> KTableWithoutBack(KTable);
-        KTableWithoutBack.DeleteColumn(NStages);
-        DynamicMatrix<float64> BTable((float64*)(this->BTable), {1, NStages});
-        auto YScale = KTableWithoutBack * BTable;
-        NewY = y + h * YScale[0];
-        NewF = Invoker(t + h, NewY);
-        KTable.SetColumn(NStages, NewF);
+        for (uint64 j = 0; j < n; ++j)
+        {
+            float64 dy = 0;
+            for (uint64 k = 0; k < NStages; ++k) {dy += K[k * n + j] * BTable[k];}
+            NewY[j] = y[j] + h * dy;
+        }
+        Evaluate(t + h, NewY, std::span<float64>(K + NStages * n, n));
 
         // ---------- Runge-Kutta solver End ---------- //
 
-        ValueArray Scale;
-        for (uint64 i = 0; i < y.size(); ++i)
+        for (uint64 j = 0; j < n; ++j)
         {
-            Scale.push_back(AbsToler + max(y[i], NewY[i]) * RelToler);
+            ErrorScale[j] = AbsToler + max(abs(y[j]), abs(NewY[j])) * RelToler;
         }
 
-        // ---------- Error Esitmator Begin ---------- //
-
-        DynamicMatrix<float64> ETable((float64*)(this->ETable), {1, NStages + 1});
-        auto EstmErrorMat = KTable * ETable;
-        ValueArray EstmError = (EstmErrorMat[0] * h) / Scale;
-
-        float64 EstmErrNorm, EENTempSum = 0;
-        for (size_t i = 0; i < EquationCount; ++i) {EENTempSum += pow(EstmError[i], 2);}
-        EstmErrNorm = sqrt(EENTempSum / float64(EstmError.size()));
-
-        // ---------- Error Esitmator End ---------- //
+        float64 EstmErrNorm = ErrorNorm(h);
 
         float64 Factor;
         if (EstmErrNorm < 1)
@@ -219,67 +615,2434 @@ int RungeKuttaODEEngine::Run()
         }
     }
 
-    StateBuffer.insert({NextT, NewY});
+    // 轮换缓冲区，不复制也不分配
+    PrevT = t;
+    CurrentT = NextT;
+    std::swap(PrevY, CurrentY);
+    std::swap(CurrentY, NewY);
+    std::copy(K + NStages * n, K + (NStages + 1) * n, CurrentFx.begin());
     AbsStep = AbsH;
-    CurrentFx = NewF;
 
     return 0;
 }
 
-void RungeKuttaODEEngine::SaveDenseOutput()
+void RungeKuttaODEEngine::BuildSegment(float64* Q)
+{
+    // Q = K * P
+    const float64* K = &KTable.at(0, 0);
+    for (uint64 j = 0; j < EquationCount; ++j)
+    {
+        for (uint64 i = 0; i < DenseOutputOrder; ++i)
+        {
+            float64 Sum = 0;
+            for (uint64 k = 0; k <= NStages; ++k)
+            {
+                Sum += K[k * EquationCount + j] * PTable[k * DenseOutputOrder + i];
+            }
+            Q[j * DenseOutputOrder + i] = Sum;
+        }
+    }
+}
+
+//////////////////////////////////// DOP853 ////////////////////////////////////
+
+float64 RungeKutta8thOrderODEEngine::ErrorNorm(float64 h)const
 {
-    DynamicMatrix<float64> PTable({DenseOutputOrder, NStages + 1});
-    for (int i = 0; i < DenseOutputOrder; ++i)
+    // SciPy Function (BSD3 License)
+    const uint64 n = EquationCount;
+    const float64* K = &KTable.at(0, 0);
+    float64 Err5 = 0, Err3 = 0;
+    for (uint64 j = 0; j < n; ++j)
     {
-        for (int j = 0; j < NStages + 1; ++j)
+        float64 e5 = 0, e3 = 0;
+        for (uint64 k = 0; k <= NStages; ++k)
         {
-            PTable.at(i, j) = *(this->PTable + (DenseOutputOrder) * j + i);
+            e5 += K[k * n + j] * __DOP853_E5_Table[k];
+            e3 += K[k * n + j] * __DOP853_E3_Table[k];
         }
+        Err5 += pow(e5 / ErrorScale[j], 2);
+        Err3 += pow(e3 / ErrorScale[j], 2);
     }
+    if (Err5 == 0 && Err3 == 0) {return 0;}
+    return abs(h) * Err5 / sqrt((Err5 + 0.01 * Err3) * float64(n));
+}
 
-    decltype(StateBuffer.begin()) PrevState;
-    if (Direction)
+void RungeKutta8thOrderODEEngine::BuildSegment(float64* Q)
+{
+    const uint64 n = EquationCount, Order = DenseOutputOrder;
+    const float64* K = &KTable.at(0, 0);
+    float64 h = CurrentT - PrevT;
+    auto Stage = [&](uint64 k, uint64 j)
+    {
+        return k <= NStages ? K[k * n + j] : ExtraK[(k - NStages - 1) * n + j];
+    };
+
+    // 计算附加的3级
+    for (uint64 s = NStages + 1; s < 16; ++s)
     {
-        PrevState = ++StateBuffer.begin();
+        const float64* a = ATable + s * ATableStride;
+        for (uint64 j = 0; j < n; ++j)
+        {
+            float64 dy = 0;
+            for (uint64 k = 0; k < s; ++k) {dy += Stage(k, j) * a[k];}
+            StageY[j] = PrevY[j] + h * dy;
+        }
+        Evaluate(PrevT + CTable[s] * h, StageY,
+            std::span<float64>(ExtraK.data() + (s - NStages - 1) * n, n));
     }
-    else
+
+    // SciPy中的插值多项式为 y = y_old + F0 * x + F1 * x(1 - x) + F2 * x^2(1 - x) + ...，
+    // 这里展开为x的幂级数，存入Q
+    for (uint64 j = 0; j < n; ++j)
+    {
+        float64 F[7];
+        float64 dy = CurrentY[j] - PrevY[j];
+        F[0] = dy;
+        F[1] = h * Stage(0, j) - dy;
+        F[2] = 2. * dy - h * (Stage(NStages, j) + Stage(0, j));
+        for (uint64 r = 0; r < 4; ++r)
+        {
+            float64 Sum = 0;
+            for (uint64 k = 0; k < 16; ++k) {Sum += __DOP853_D_Table[r * 16 + k] * Stage(k, j);}
+            F[3 + r] = h * Sum;
+        }
+
+        // 由内向外逐项累加，偶数次乘x，奇数次乘(1 - x)
+        float64 Poly[8] = {0};
+        for (uint64 i = 0; i < 7; ++i)
+        {
+            Poly[0] += F[6 - i];
+            if (i % 2 == 0)
+            {
+                for (uint64 d = 7; d > 0; --d) {Poly[d] = Poly[d - 1];}
+                Poly[0] = 0;
+            }
+            else
+            {
+                for (uint64 d = 7; d > 0; --d) {Poly[d] -= Poly[d - 1];}
+            }
+        }
+        for (uint64 i = 0; i < Order; ++i) {Q[j * Order + i] = Poly[i + 1] / h;}
+    }
+}
+
+///////////////////////////////////// 隐式方法 ////////////////////////////////////
+
+/**
+ * @brief 带部分选主元的LU分解，A按行存放，分解结果原位覆盖A
+ * @return 矩阵奇异时返回false，此时分解仍然完成，但求解结果中会出现非有限值
+ */
+template<typename _Ty>
+static bool __LU_Decompose(_Ty* A, uint64* Pivots, uint64 n)
+{
+    bool Regular = true;
+    for (uint64 k = 0; k < n; ++k)
+    {
+        uint64 p = k;
+        float64 MaxAbs = std::abs(A[k * n + k]);
+        for (uint64 i = k + 1; i < n; ++i)
+        {
+            float64 Value = std::abs(A[i * n + k]);
+            if (Value > MaxAbs) {MaxAbs = Value; p = i;}
+        }
+        Pivots[k] = p;
+        if (p != k) {std::swap_ranges(A + k * n, A + (k + 1) * n, A + p * n);}
+        if (MaxAbs == 0) {Regular = false; continue;}
+        _Ty Inv = _Ty(1) / A[k * n + k];
+        for (uint64 i = k + 1; i < n; ++i)
+        {
+            _Ty l = (A[i * n + k] *= Inv);
+            if (l == _Ty(0)) {continue;}
+            for (uint64 j = k + 1; j < n; ++j) {A[i * n + j] -= l * A[k * n + j];}
+        }
+    }
+    return Regular;
+}
+
+/**
+ * @brief 用__LU_Decompose的结果求解Ax = b，b原位覆盖为x
+ */
+template<typename _Ty>
+static void __LU_Solve(const _Ty* LU, const uint64* Pivots, _Ty* b, uint64 n)
+{
+    for (uint64 k = 0; k < n; ++k)
+    {
+        if (Pivots[k] != k) {std::swap(b[k], b[Pivots[k]]);}
+        for (uint64 j = 0; j < k; ++j) {b[k] -= LU[k * n + j] * b[j];}
+    }
+    for (uint64 k = n; k-- > 0;)
     {
-        auto end = --StateBuffer.end();
-        PrevState = --end;
+        for (uint64 j = k + 1; j < n; ++j) {b[k] -= LU[k * n + j] * b[j];}
+        b[k] /= LU[k * n + k];
     }
+}
 
-    Interpolants.insert({CurrentPoint(),
-        DenseOutput(DenseOutputOrder, PrevState->first, CurrentPoint(),
-        PrevState->second, KTable * PTable)});
+void __Implicit_Ordinary_Differential_Equation::Clear()
+{
+    Mybase::Clear();
+    Jacobian.fill(0);
+    CurrentFx.clear();
+    JacobianCount = DecompositionCount = 0;
+    AbsStep = 0;
 }
 
-inline OrdinaryDifferentialEquation::DenseOutput::ValueArray
-RungeKuttaODEEngine::DenseOutput::operator()(float64 _Xx) const
+float64 __Implicit_Ordinary_Differential_Equation::RMSNorm(std::span<const float64> x, std::span<const float64> Scale)const
 {
-    float64 x = (_Xx - First) / size();
-    std::vector<float64> p;
-    for (int i = 0; i < DenseOutputOrder; ++i)
+    const uint64 n = Scale.size();
+    float64 Sum = 0;
+    for (uint64 i = 0; i < x.size(); ++i)
     {
-        p.push_back(pow(x, i + 1));
+        float64 Value = x[i] / Scale[i % n];
+        Sum += Value * Value;
     }
-    auto y = size() * (QTable * DynamicMatrix<float64>{p});
-    return (DynamicMatrix<float64>{Base} + y).GetColumn(0);
+    return sqrt(Sum / float64(x.size()));
 }
 
-RungeKuttaODEEngine::ValueArray RungeKuttaODEEngine::operator()(float64 _Xx) const
+void __Implicit_Ordinary_Differential_Equation::UpdateJacobian(float64 t, std::span<const float64> y, std::span<const float64> fx)
 {
-    DenseOutput Segment;
-    for (auto i : Interpolants)
+    ++JacobianCount;
+    if (JacobianFunction)
     {
-        float64 Min = min(i.second.first(), i.second.last());
-        float64 Max = max(i.second.first(), i.second.last());
-        if (Min <= _Xx && _Xx <= Max)
-        {
-            Segment = i.second;
-            break;
-        }
+        JacobianFunction(t, y, Jacobian);
+        return;
+    }
+    JacobianEngine Engine([this, t](std::span<const float64> x, std::span<float64> Out)
+    {
+        Evaluate(t, x, Out);
+    }, EquationCount, EquationCount);
+    Engine.Method = JacobianEngine::Forward;
+    Engine.Threads = 1;
+    Engine(y, Jacobian, fx);
+}
+
+void __Implicit_Ordinary_Differential_Equation::BeginImplicit(const ValueArray& InitState,
+    float64 First, float64 Last, float64 ErrorOrder)
+{
+    if (InitState.size() != EquationCount)
+    {
+        throw std::logic_error("Solution count is not equal to parameter count.");
+    }
+    BeginIntegration(InitState, First, Last);
+    JacobianCount = DecompositionCount = 0;
+
+    float64 RelToler = pow(10, -RelTolerNLog);
+    float64 AbsToler = pow(10, -AbsTolerNLog);
+    NewtonToler = max(10. * std::numeric_limits<float64>::epsilon() / RelToler, min(0.03, sqrt(RelToler)));
+
+    CurrentFx.resize(EquationCount);
+    Evaluate(First, CurrentY, CurrentFx);
+    AbsStep = SelectInitialStep(CurrentFx, ErrorOrder, RelToler, AbsToler);
+    UpdateJacobian(First, CurrentY, CurrentFx);
+}
+
+// ---------------------------------------------- Radau IIA ---------------------------------------------- //
+
+// 常数取自SciPy(scipy/integrate/_ivp/radau.py)，由Radau IIA的Butcher表导出
+static const float64 __Radau_S6 = 2.449489742783178098197284074705891391965947480656670128432692567;
+static const float64 __Radau_C[3] = {(4. - __Radau_S6) / 10., (4. + __Radau_S6) / 10., 1.};
+static const float64 __Radau_E[3] = {(-13. - 7. * __Radau_S6) / 3., (-13. + 7. * __Radau_S6) / 3., -1. / 3.};
+
+// 配置方程组系数矩阵的特征值，一个实数和一对共轭复数
+static const float64 __Radau_MuReal = 3.637834252744495538;  // 3 + 3^(2/3) - 3^(1/3)
+static const complex64 __Radau_MuComplex = {2.681082873627752231, -3.050430199247410569};
+
+// 特征向量组成的变换矩阵及其逆
+static const float64 __Radau_T[3][3] =
+{
+    {0.09443876248897524, -0.14125529502095421, 0.03002919410514742},
+    {0.25021312296533332, 0.20412935229379994, -0.38294211275726192},
+    {1., 1., 0.}
+};
+static const float64 __Radau_TI[3][3] =
+{
+    {4.17871859155190428, 0.32768282076106237, 0.52337644549944951},
+    {-4.17871859155190428, -0.32768282076106237, 0.47662355450055044},
+    {0.50287263494578682, -2.57192694985560522, 0.59603920482822492}
+};
+
+// 稠密输出多项式的系数
+static const float64 __Radau_P[3][3] =
+{
+    {13. / 3. + 7. * __Radau_S6 / 3., -23. / 3. - 22. * __Radau_S6 / 3., 10. / 3. + 5. * __Radau_S6},
+    {13. / 3. - 7. * __Radau_S6 / 3., -23. / 3. + 22. * __Radau_S6 / 3., 10. / 3. - 5. * __Radau_S6},
+    {1. / 3., -8. / 3., 10. / 3.}
+};
+
+static float64 __Radau_Predict_Factor(float64 AbsH, float64 AbsHOld, float64 ErrNorm, float64 ErrNormOld)
+{
+    // Gustafsson的预测步长控制
+    float64 Multiplier = 1;
+    if (!isnan(ErrNormOld) && !isnan(AbsHOld) && ErrNorm != 0)
+    {
+        Multiplier = AbsH / AbsHOld * std::pow(ErrNormOld / ErrNorm, 0.25);
+    }
+    if (ErrNorm == 0) {return __Float64::FromBytes(POS_INF_DOUBLE);}
+    return min(1., Multiplier) * std::pow(ErrNorm, -0.25);
+}
+
+void RadauIIAODEEngine::Init(ValueArray InitState, float64 First, float64 Last)
+{
+    const uint64 n = EquationCount;
+    BeginImplicit(InitState, First, Last, 3);
+
+    LUReal.resize(n * n);
+    LUComplex.resize(n * n);
+    PivotsReal.resize(n);
+    PivotsComplex.resize(n);
+    LUValid = false;
+    CurrentJacobian = true;
+    HasDenseOutput = false;
+    AbsStepOld = ErrorNormOld = __Float64::FromBytes(BIG_NAN_DOUBLE);
+
+    Z.resize(3 * n);
+    Z0.resize(3 * n);
+    W.resize(3 * n);
+    DeltaW.resize(3 * n);
+    F.resize(3 * n);
+    Scale.resize(n);
+    NewY.resize(n);
+    NewFx.resize(n);
+    ErrorVec.resize(n);
+    Tmp.resize(n);
+    ComplexTmp.resize(n);
+    DenseQ.resize(3 * n);
+}
+
+void RadauIIAODEEngine::Decompose(float64 h)
+{
+    const uint64 n = EquationCount;
+    float64 MuReal = __Radau_MuReal / h;
+    complex64 MuComplex = __Radau_MuComplex / h;
+    for (uint64 i = 0; i < n; ++i)
+    {
+        for (uint64 j = 0; j < n; ++j)
+        {
+            float64 Jij = Jacobian.at(j, i);
+            LUReal[i * n + j] = (i == j ? MuReal : 0.) - Jij;
+            LUComplex[i * n + j] = (i == j ? MuComplex : complex64(0.)) - Jij;
+        }
+    }
+    __LU_Decompose(LUReal.data(), PivotsReal.data(), n);
+    __LU_Decompose(LUComplex.data(), PivotsComplex.data(), n);
+    DecompositionCount += 2;
+    LUValid = true;
+}
+
+bool RadauIIAODEEngine::SolveCollocation(float64 t, float64 h, uint64& Iterations, float64& Rate)
+{
+    const uint64 n = EquationCount;
+    const float64 NaN = __Float64::FromBytes(BIG_NAN_DOUBLE);
+    float64 MuReal = __Radau_MuReal / h;
+    complex64 MuComplex = __Radau_MuComplex / h;
+
+    // W = TI·Z0，Z = Z0
+    for (uint64 i = 0; i < 3; ++i)
+    {
+        for (uint64 j = 0; j < n; ++j)
+        {
+            W[i * n + j] = __Radau_TI[i][0] * Z0[j] + __Radau_TI[i][1] * Z0[n + j] + __Radau_TI[i][2] * Z0[2 * n + j];
+        }
+    }
+    Z = Z0;
+
+    float64 DeltaNormOld = NaN;
+    Rate = NaN;
+    for (uint64 k = 0; k < NewtonMaxIter; ++k)
+    {
+        Iterations = k + 1;
+        for (uint64 i = 0; i < 3; ++i)
+        {
+            for (uint64 j = 0; j < n; ++j) {Tmp[j] = CurrentY[j] + Z[i * n + j];}
+            Evaluate(t + h * __Radau_C[i], Tmp, std::span<float64>(F.data() + i * n, n));
+        }
+        for (float64 Value : F) {if (!std::isfinite(Value)) {return false;}}
+
+        for (uint64 j = 0; j < n; ++j)
+        {
+            float64 f0 = F[j], f1 = F[n + j], f2 = F[2 * n + j];
+            DeltaW[j] = __Radau_TI[0][0] * f0 + __Radau_TI[0][1] * f1 + __Radau_TI[0][2] * f2 - MuReal * W[j];
+            ComplexTmp[j] = complex64(
+                __Radau_TI[1][0] * f0 + __Radau_TI[1][1] * f1 + __Radau_TI[1][2] * f2,
+                __Radau_TI[2][0] * f0 + __Radau_TI[2][1] * f1 + __Radau_TI[2][2] * f2)
+                - MuComplex * complex64(W[n + j], W[2 * n + j]);
+        }
+        __LU_Solve(LUReal.data(), PivotsReal.data(), DeltaW.data(), n);
+        __LU_Solve(LUComplex.data(), PivotsComplex.data(), ComplexTmp.data(), n);
+        for (uint64 j = 0; j < n; ++j)
+        {
+            DeltaW[n + j] = ComplexTmp[j].real();
+            DeltaW[2 * n + j] = ComplexTmp[j].imag();
+        }
+
+        float64 DeltaNorm = RMSNorm(DeltaW, Scale);
+        if (!isnan(DeltaNormOld)) {Rate = DeltaNorm / DeltaNormOld;}
+        if (!isnan(Rate) && (Rate >= 1 ||
+            std::pow(Rate, float64(NewtonMaxIter - k)) / (1 - Rate) * DeltaNorm > NewtonToler))
+        {
+            return false;
+        }
+
+        for (uint64 i = 0; i < 3 * n; ++i) {W[i] += DeltaW[i];}
+        for (uint64 i = 0; i < 3; ++i)
+        {
+            for (uint64 j = 0; j < n; ++j)
+            {
+                Z[i * n + j] = __Radau_T[i][0] * W[j] + __Radau_T[i][1] * W[n + j] + __Radau_T[i][2] * W[2 * n + j];
+            }
+        }
+
+        if (DeltaNorm == 0 || (!isnan(Rate) && Rate / (1 - Rate) * DeltaNorm < NewtonToler)) {return true;}
+        DeltaNormOld = DeltaNorm;
+    }
+    return false;
+}
+
+int RadauIIAODEEngine::Advance()
+{
+    const uint64 n = EquationCount;
+    const float64 NaN = __Float64::FromBytes(BIG_NAN_DOUBLE);
+    const float64 Sign = Direction ? -1 : 1;
+    const float64 t = CurrentT;
+    float64 RelToler = pow(10, -RelTolerNLog);
+    float64 AbsToler = pow(10, -AbsTolerNLog);
+    float64 MinStep = 10. * abs(std::nextafter(t, Sign * __Float64::FromBytes(POS_INF_DOUBLE)) - t);
+
+    float64 AbsH, AbsHOld = AbsStepOld, ErrNormOld = ErrorNormOld;
+    if (AbsStep > MaxStep)
+    {
+        AbsH = MaxStep;
+        AbsHOld = ErrNormOld = NaN;
+    }
+    else if (AbsStep < MinStep)
+    {
+        AbsH = MinStep;
+        AbsHOld = ErrNormOld = NaN;
+    }
+    else {AbsH = AbsStep;}
+
+    bool Rejected = false, Accepted = false;
+    float64 h, NextT, ErrNorm, Safety, Rate = NaN;
+    uint64 Iterations = 0;
+    while (!Accepted)
+    {
+        if (AbsH < MinStep) {return 1;}
+
+        h = AbsH * Sign;
+        NextT = t + h;
+        if (Sign * (NextT - EndPoint) > 0) {NextT = EndPoint;}
+        h = NextT - t;
+        AbsH = abs(h);
+
+        // 用上一步的稠密输出外推作为牛顿迭代的初值
+        if (!HasDenseOutput) {std::fill(Z0.begin(), Z0.end(), 0.);}
+        else
+        {
+            for (uint64 i = 0; i < 3; ++i)
+            {
+                float64 x = (t + h * __Radau_C[i] - PrevT) / (t - PrevT);
+                for (uint64 j = 0; j < n; ++j)
+                {
+                    const float64* Q = DenseQ.data() + j * 3;
+                    Z0[i * n + j] = PrevY[j] + x * (Q[0] + x * (Q[1] + x * Q[2])) - CurrentY[j];
+                }
+            }
+        }
+        for (uint64 j = 0; j < n; ++j) {Scale[j] = AbsToler + abs(CurrentY[j]) * RelToler;}
+
+        bool Converged = false;
+        while (!Converged)
+        {
+            if (!LUValid) {Decompose(h);}
+            Converged = SolveCollocation(t, h, Iterations, Rate);
+            if (!Converged)
+            {
+                if (CurrentJacobian) {break;}
+                UpdateJacobian(t, CurrentY, CurrentFx);
+                CurrentJacobian = true;
+                LUValid = false;
+            }
+        }
+        if (!Converged)
+        {
+            AbsH *= 0.5;
+            LUValid = false;
+            continue;
+        }
+
+        // 误差估计
+        for (uint64 j = 0; j < n; ++j)
+        {
+            NewY[j] = CurrentY[j] + Z[2 * n + j];
+            float64 ZE = (Z[j] * __Radau_E[0] + Z[n + j] * __Radau_E[1] + Z[2 * n + j] * __Radau_E[2]) / h;
+            Tmp[j] = ZE;
+            ErrorVec[j] = CurrentFx[j] + ZE;
+            Scale[j] = AbsToler + max(abs(CurrentY[j]), abs(NewY[j])) * RelToler;
+        }
+        __LU_Solve(LUReal.data(), PivotsReal.data(), ErrorVec.data(), n);
+        ErrNorm = RMSNorm(ErrorVec, Scale);
+        Safety = 0.9 * (2. * NewtonMaxIter + 1.) / (2. * NewtonMaxIter + float64(Iterations));
+
+        if (Rejected && ErrNorm > 1)
+        {
+            // 被拒绝过的步用改进的误差估计，避免刚性问题中误差被高估
+            for (uint64 j = 0; j < n; ++j) {NewFx[j] = CurrentY[j] + ErrorVec[j];}
+            Evaluate(t, NewFx, ErrorVec);
+            for (uint64 j = 0; j < n; ++j) {ErrorVec[j] += Tmp[j];}
+            __LU_Solve(LUReal.data(), PivotsReal.data(), ErrorVec.data(), n);
+            ErrNorm = RMSNorm(ErrorVec, Scale);
+        }
+
+        if (ErrNorm > 1)
+        {
+            float64 Factor = __Radau_Predict_Factor(AbsH, AbsHOld, ErrNorm, ErrNormOld);
+            AbsH *= max(MinFactor, Safety * Factor);
+            LUValid = false;
+            Rejected = true;
+        }
+        else {Accepted = true;}
+    }
+
+    // 收敛变慢时重新计算雅可比矩阵，步长变化不大时保留LU分解
+    bool RecomputeJacobian = Iterations > 2 && Rate > 1E-3;
+    float64 Factor = min(MaxFactor, Safety * __Radau_Predict_Factor(AbsH, AbsHOld, ErrNorm, ErrNormOld));
+    if (!RecomputeJacobian && Factor < 1.2) {Factor = 1;}
+    else {LUValid = false;}
+
+    Evaluate(NextT, NewY, NewFx);
+    if (RecomputeJacobian)
+    {
+        UpdateJacobian(NextT, NewY, NewFx);
+        CurrentJacobian = true;
+    }
+    else {CurrentJacobian = false;}
+
+    AbsStepOld = AbsH;
+    ErrorNormOld = ErrNorm;
+    AbsStep = AbsH * Factor;
+
+    for (uint64 j = 0; j < n; ++j)
+    {
+        for (uint64 k = 0; k < 3; ++k)
+        {
+            DenseQ[j * 3 + k] = Z[j] * __Radau_P[0][k] + Z[n + j] * __Radau_P[1][k] + Z[2 * n + j] * __Radau_P[2][k];
+        }
+    }
+    HasDenseOutput = true;
+
+    PrevT = t;
+    CurrentT = NextT;
+    std::swap(PrevY, CurrentY);
+    std::swap(CurrentY, NewY);
+    std::swap(CurrentFx, NewFx);
+    return 0;
+}
+
+void RadauIIAODEEngine::BuildSegment(float64* Q)
+{
+    // 段内的多项式为y = Base + h·s·ΣQ[k]s^k，故系数需除以步长
+    float64 h = CurrentT - PrevT;
+    for (uint64 i = 0; i < 3 * EquationCount; ++i) {Q[i] = DenseQ[i] / h;}
+}
+
+// --------------------------------------------- 后向差分公式 --------------------------------------------- //
+
+// NDF修正系数(Shampine, Reichelt, 1997)，以及由其导出的各阶系数
+static const float64 __BDF_Kappa[6] = {0, -0.1850, -1. / 9., -0.0823, -0.0415, 0};
+static const std::array<float64, 6> __BDF_Gamma = []()
+{
+    std::array<float64, 6> Gamma{0};
+    for (uint64 i = 1; i < 6; ++i) {Gamma[i] = Gamma[i - 1] + 1. / float64(i);}
+    return Gamma;
+}();
+static const std::array<float64, 6> __BDF_Alpha = []()
+{
+    std::array<float64, 6> Alpha;
+    for (uint64 i = 0; i < 6; ++i) {Alpha[i] = (1. - __BDF_Kappa[i]) * __BDF_Gamma[i];}
+    return Alpha;
+}();
+static const std::array<float64, 6> __BDF_ErrorConst = []()
+{
+    std::array<float64, 6> ErrorConst;
+    for (uint64 i = 0; i < 6; ++i) {ErrorConst[i] = __BDF_Kappa[i] * __BDF_Gamma[i] + 1. / float64(i + 1);}
+    return ErrorConst;
+}();
+
+void BackwardDifferentiationODEEngine::Init(ValueArray InitState, float64 First, float64 Last)
+{
+    const uint64 n = EquationCount;
+    BeginImplicit(InitState, First, Last, 1);
+
+    Differences.assign((MaxOrder + 3) * n, 0.);
+    float64 h = AbsStep * (Direction ? -1 : 1);
+    for (uint64 j = 0; j < n; ++j)
+    {
+        Differences[j] = CurrentY[j];
+        Differences[n + j] = CurrentFx[j] * h;
+    }
+    Order = 1;
+    EqualSteps = 0;
+    LU.resize(n * n);
+    Pivots.resize(n);
+    LUValid = false;
+
+    YPredict.resize(n);
+    Psi.resize(n);
+    Scale.resize(n);
+    NewY.resize(n);
+    Correction.resize(n);
+    Delta.resize(n);
+    F.resize(n);
+    DenseD.resize((MaxOrder + 1) * n);
+    DenseOrder = 1;
+}
+
+void BackwardDifferentiationODEEngine::ChangeDifferences(uint64 Order, float64 Factor)
+{
+    // 步长变为Factor倍时，D[0..Order]变换为(RU)^T·D，其中R和U由ComputeR给出
+    const uint64 n = EquationCount;
+    auto ComputeR = [Order](float64 Factor, float64 (&R)[MaxOrder + 1][MaxOrder + 1])
+    {
+        for (uint64 j = 0; j <= Order; ++j) {R[0][j] = 1;}
+        for (uint64 i = 1; i <= Order; ++i)
+        {
+            R[i][0] = 0;
+            for (uint64 j = 1; j <= Order; ++j)
+            {
+                R[i][j] = R[i - 1][j] * (float64(i) - 1. - Factor * float64(j)) / float64(i);
+            }
+        }
+    };
+    float64 R[MaxOrder + 1][MaxOrder + 1], U[MaxOrder + 1][MaxOrder + 1], RU[MaxOrder + 1][MaxOrder + 1];
+    ComputeR(Factor, R);
+    ComputeR(1, U);
+    for (uint64 i = 0; i <= Order; ++i)
+    {
+        for (uint64 j = 0; j <= Order; ++j)
+        {
+            RU[i][j] = 0;
+            for (uint64 k = 0; k <= Order; ++k) {RU[i][j] += R[i][k] * U[k][j];}
+        }
+    }
+
+    float64 Column[MaxOrder + 1];
+    for (uint64 c = 0; c < n; ++c)
+    {
+        for (uint64 k = 0; k <= Order; ++k) {Column[k] = Differences[k * n + c];}
+        for (uint64 k = 0; k <= Order; ++k)
+        {
+            float64 Sum = 0;
+            for (uint64 i = 0; i <= Order; ++i) {Sum += RU[i][k] * Column[i];}
+            Differences[k * n + c] = Sum;
+        }
+    }
+}
+
+bool BackwardDifferentiationODEEngine::SolveSystem(float64 t, float64 c, uint64& Iterations)
+{
+    const uint64 n = EquationCount;
+    std::fill(Correction.begin(), Correction.end(), 0.);
+    NewY = YPredict;
+    float64 DeltaNormOld = __Float64::FromBytes(BIG_NAN_DOUBLE);
+    for (uint64 k = 0; k < NewtonMaxIter; ++k)
+    {
+        Iterations = k + 1;
+        Evaluate(t, NewY, F);
+        for (float64 Value : F) {if (!std::isfinite(Value)) {return false;}}
+
+        for (uint64 j = 0; j < n; ++j) {Delta[j] = c * F[j] - Psi[j] - Correction[j];}
+        __LU_Solve(LU.data(), Pivots.data(), Delta.data(), n);
+        float64 DeltaNorm = RMSNorm(Delta, Scale);
+        float64 Rate = DeltaNorm / DeltaNormOld; // 第一次迭代时为NaN
+        if (!isnan(Rate) && (Rate >= 1 ||
+            std::pow(Rate, float64(NewtonMaxIter - k)) / (1 - Rate) * DeltaNorm > NewtonToler))
+        {
+            return false;
+        }
+
+        for (uint64 j = 0; j < n; ++j)
+        {
+            NewY[j] += Delta[j];
+            Correction[j] += Delta[j];
+        }
+
+        if (DeltaNorm == 0 || (!isnan(Rate) && Rate / (1 - Rate) * DeltaNorm < NewtonToler)) {return true;}
+        DeltaNormOld = DeltaNorm;
+    }
+    return false;
+}
+
+int BackwardDifferentiationODEEngine::Advance()
+{
+    const uint64 n = EquationCount;
+    const float64 Inf = __Float64::FromBytes(POS_INF_DOUBLE);
+    const float64 Sign = Direction ? -1 : 1;
+    const float64 t = CurrentT;
+    float64 RelToler = pow(10, -RelTolerNLog);
+    float64 AbsToler = pow(10, -AbsTolerNLog);
+    float64 MinStep = 10. * abs(std::nextafter(t, Sign * Inf) - t);
+    float64* D = Differences.data();
+
+    float64 AbsH;
+    if (AbsStep > MaxStep)
+    {
+        AbsH = MaxStep;
+        ChangeDifferences(Order, MaxStep / AbsStep);
+        EqualSteps = 0;
+    }
+    else if (AbsStep < MinStep)
+    {
+        AbsH = MinStep;
+        ChangeDifferences(Order, MinStep / AbsStep);
+        EqualSteps = 0;
+    }
+    else {AbsH = AbsStep;}
+
+    bool CurrentJacobian = false, Accepted = false;
+    float64 h, NextT, ErrNorm, Safety;
+    uint64 Iterations = 0;
+    while (!Accepted)
+    {
+        if (AbsH < MinStep) {return 1;}
+
+        h = AbsH * Sign;
+        NextT = t + h;
+        if (Sign * (NextT - EndPoint) > 0)
+        {
+            NextT = EndPoint;
+            ChangeDifferences(Order, abs(NextT - t) / AbsH);
+            EqualSteps = 0;
+            LUValid = false;
+        }
+        h = NextT - t;
+        AbsH = abs(h);
+
+        for (uint64 j = 0; j < n; ++j)
+        {
+            float64 Predict = 0, PsiSum = 0;
+            for (uint64 k = 0; k <= Order; ++k) {Predict += D[k * n + j];}
+            for (uint64 k = 1; k <= Order; ++k) {PsiSum += D[k * n + j] * __BDF_Gamma[k];}
+            YPredict[j] = Predict;
+            Psi[j] = PsiSum / __BDF_Alpha[Order];
+            Scale[j] = AbsToler + abs(Predict) * RelToler;
+        }
+
+        float64 c = h / __BDF_Alpha[Order];
+        bool Converged = false;
+        while (!Converged)
+        {
+            if (!LUValid)
+            {
+                for (uint64 i = 0; i < n; ++i)
+                {
+                    for (uint64 j = 0; j < n; ++j) {LU[i * n + j] = (i == j ? 1. : 0.) - c * Jacobian.at(j, i);}
+                }
+                __LU_Decompose(LU.data(), Pivots.data(), n);
+                ++DecompositionCount;
+                LUValid = true;
+            }
+            Converged = SolveSystem(NextT, c, Iterations);
+            if (!Converged)
+            {
+                if (CurrentJacobian) {break;}
+                UpdateJacobian(NextT, YPredict);
+                LUValid = false;
+                CurrentJacobian = true;
+            }
+        }
+        if (!Converged)
+        {
+            AbsH *= 0.5;
+            ChangeDifferences(Order, 0.5);
+            EqualSteps = 0;
+            LUValid = false;
+            continue;
+        }
+
+        Safety = 0.9 * (2. * NewtonMaxIter + 1.) / (2. * NewtonMaxIter + float64(Iterations));
+        for (uint64 j = 0; j < n; ++j)
+        {
+            Scale[j] = AbsToler + abs(NewY[j]) * RelToler;
+            Delta[j] = __BDF_ErrorConst[Order] * Correction[j];
+        }
+        ErrNorm = RMSNorm(Delta, Scale);
+
+        if (ErrNorm > 1)
+        {
+            // 牛顿迭代收敛正常，此处不重新分解
+            float64 Factor = max(MinFactor, Safety * std::pow(ErrNorm, -1. / float64(Order + 1)));
+            AbsH *= Factor;
+            ChangeDifferences(Order, Factor);
+            EqualSteps = 0;
+        }
+        else {Accepted = true;}
+    }
+
+    ++EqualSteps;
+    PrevT = t;
+    CurrentT = NextT;
+    std::swap(PrevY, CurrentY);
+    std::swap(CurrentY, NewY);
+    AbsStep = AbsH;
+
+    // 更新差分：D^{j+1}y_n = D^j y_n - D^j y_{n-1}，Correction即为D^{k+1}y_n
+    for (uint64 j = 0; j < n; ++j)
+    {
+        D[(Order + 2) * n + j] = Correction[j] - D[(Order + 1) * n + j];
+        D[(Order + 1) * n + j] = Correction[j];
+    }
+    for (uint64 k = Order + 1; k-- > 0;)
+    {
+        for (uint64 j = 0; j < n; ++j) {D[k * n + j] += D[(k + 1) * n + j];}
+    }
+
+    // 保存本步的插值多项式，之后的变阶和变步长不影响本步
+    DenseOrder = Order;
+    std::copy(D, D + (Order + 1) * n, DenseD.begin());
+
+    if (EqualSteps < Order + 1) {return 0;}
+
+    // 连续Order + 1步等步长后，比较相邻阶的误差选择新的阶数和步长
+    float64 ErrorNorms[3] = {Inf, ErrNorm, Inf};
+    if (Order > 1)
+    {
+        for (uint64 j = 0; j < n; ++j) {Delta[j] = __BDF_ErrorConst[Order - 1] * D[Order * n + j];}
+        ErrorNorms[0] = RMSNorm(Delta, Scale);
+    }
+    if (Order < MaxOrder)
+    {
+        for (uint64 j = 0; j < n; ++j) {Delta[j] = __BDF_ErrorConst[Order + 1] * D[(Order + 2) * n + j];}
+        ErrorNorms[2] = RMSNorm(Delta, Scale);
+    }
+
+    uint64 Best = 0;
+    float64 Factors[3];
+    for (uint64 i = 0; i < 3; ++i)
+    {
+        Factors[i] = ErrorNorms[i] == 0 ? Inf : std::pow(ErrorNorms[i], -1. / float64(Order + i));
+        if (Factors[i] > Factors[Best]) {Best = i;}
+    }
+    Order = Order + Best - 1;
+
+    float64 Factor = min(MaxFactor, Safety * Factors[Best]);
+    AbsStep *= Factor;
+    ChangeDifferences(Order, Factor);
+    EqualSteps = 0;
+    LUValid = false;
+    return 0;
+}
+
+void BackwardDifferentiationODEEngine::BuildSegment(float64* Q)
+{
+    // 插值多项式y(s) = D0 + Σ_k D_k·Π_{m<k}(s - 1 + m) / (m + 1)，展开为s的幂级数
+    const uint64 n = EquationCount;
+    const float64 h = CurrentT - PrevT;
+    float64 Basis[MaxOrder + 1][MaxOrder + 1] = {}; // Basis[k]为第k个乘积的系数
+    Basis[0][0] = 1;
+    for (uint64 k = 1; k <= DenseOrder; ++k)
+    {
+        float64 a = (float64(k) - 2.) / float64(k), b = 1. / float64(k);
+        for (uint64 p = 0; p <= k; ++p)
+        {
+            Basis[k][p] = (p < k ? Basis[k - 1][p] * a : 0.) + (p > 0 ? Basis[k - 1][p - 1] * b : 0.);
+        }
+    }
+    for (uint64 j = 0; j < n; ++j)
+    {
+        for (uint64 p = 1; p <= MaxOrder; ++p)
+        {
+            float64 Sum = 0;
+            for (uint64 k = p; k <= DenseOrder; ++k) {Sum += DenseD[k * n + j] * Basis[k][p];}
+            Q[j * MaxOrder + p - 1] = Sum / h;
+        }
+    }
+}
+
+///////////////////////////////////// 亚当斯方法 ////////////////////////////////////
+
+// 亚当斯-莫尔顿公式的误差常数γ*，q阶公式的局部截断误差为γ*[q] * h^(q+1) * y^(q+1)
+static const std::array<float64, AdamsODEEngine::MaxOrder + 2> __Adams_Gamma = []()
+{
+    std::array<float64, AdamsODEEngine::MaxOrder + 2> Gamma;
+    Gamma[0] = 1;
+    for (uint64 m = 1; m < Gamma.size(); ++m)
+    {
+        float64 Sum = 0;
+        for (uint64 j = 0; j < m; ++j) {Sum += Gamma[j] / float64(m + 1 - j);}
+        Gamma[m] = -Sum;
+    }
+    return Gamma;
+}();
+
+// Nordsieck形式的校正系数l，q阶时为多项式1 + ∫(0, x)m(u)du / ∫(-1, 0)m(u)du的系数，
+// 其中m(x) = (x + 1)(x + 2)...(x + q - 1)，归一化为l[0] = 1
+static const auto __Adams_L = []()
+{
+    constexpr uint64 Size = AdamsODEEngine::MaxOrder + 1;
+    std::array<std::array<float64, Size>, Size> L{};
+    for (uint64 q = 1; q < Size; ++q)
+    {
+        float64 m[Size] = {1};
+        for (uint64 i = 1; i < q; ++i)
+        {
+            for (uint64 k = i; k > 0; --k) {m[k] = m[k] * float64(i) + m[k - 1];}
+            m[0] *= float64(i);
+        }
+        float64 M0 = 0;
+        for (uint64 k = 0; k < q; ++k) {M0 += m[k] * ((k % 2) ? -1. : 1.) / float64(k + 1);}
+        L[q][0] = 1;
+        for (uint64 i = 1; i <= q; ++i) {L[q][i] = m[i - 1] / (float64(i) * M0);}
+    }
+    return L;
+}();
+
+// 由校正量估计误差：h^(q+1) * y^(q+1) ≈ q! * l[q] * e
+static float64 __Adams_Error_Const(uint64 q, int Shift)
+{
+    float64 Factorial = 1;
+    for (uint64 i = 2; i <= q; ++i) {Factorial *= float64(i);}
+    float64 Gamma = abs(__Adams_Gamma[q + Shift]);
+    return Shift < 0 ? Gamma * Factorial : Gamma * Factorial * __Adams_L[q][q];
+}
+
+void AdamsODEEngine::Init(ValueArray InitState, float64 First, float64 Last)
+{
+    if (InitState.size() != EquationCount)
+    {
+        throw std::logic_error("Solution count is not equal to parameter count.");
+    }
+    const uint64 n = EquationCount;
+    BeginIntegration(InitState, First, Last);
+
+    Nordsieck.assign((MaxOrder + 2) * n, 0.);
+    Predicted.resize((MaxOrder + 1) * n);
+    Correction.assign(n, 0.);
+    PrevCorrection.assign(n, 0.);
+    NewFx.resize(n);
+    Scale.resize(n);
+    StartupT.resize(StartupOrder);
+    StartupY.resize(StartupOrder * n);
+    StartupFx.resize(StartupOrder * n);
+
+    if (!Startup()) {State = Failed;}
+}
+
+void AdamsODEEngine::Clear()
+{
+    Mybase::Clear();
+    Nordsieck.clear();
+    StartupY.clear();
+    StartupFx.clear();
+    StepSize = 0;
+}
+
+bool AdamsODEEngine::Startup()
+{
+    const uint64 n = EquationCount, Steps = StartupOrder - 1;
+    const float64 Sign = Direction ? -1 : 1;
+    const float64 t0 = CurrentT;
+    float64 RelToler = pow(10, -RelTolerNLog);
+    float64 AbsToler = pow(10, -AbsTolerNLog);
+    float64 MinStep = 10. * abs(std::nextafter(t0, Sign * __Float64::FromBytes(POS_INF_DOUBLE)) - t0);
+
+    StartupT[0] = t0;
+    std::copy(CurrentY.begin(), CurrentY.end(), StartupY.begin());
+    Evaluate(t0, CurrentY, std::span<float64>(StartupFx.data(), n));
+    float64 AbsH = min(SelectInitialStep(std::span<const float64>(StartupFx.data(), n), 4, RelToler, AbsToler), MaxStep);
+
+    ValueArray K(7 * n), StageY(n);
+    bool Accept = false;
+    while (!Accept)
+    {
+        if (AbsH < MinStep) {return false;}
+        float64 h = Sign * AbsH;
+        if (Sign * (t0 + float64(Steps) * h - EndPoint) > 0) {h = (EndPoint - t0) / float64(Steps);}
+
+        // 等步长的Dormand-Prince步，任意一步误差过大则缩小步长重新开始
+        Accept = true;
+        for (uint64 i = 0; i < Steps && Accept; ++i)
+        {
+            const float64 t = t0 + float64(i) * h;
+            const float64* y = StartupY.data() + i * n;
+            float64* NewY = StartupY.data() + (i + 1) * n;
+            std::copy(StartupFx.begin() + i * n, StartupFx.begin() + (i + 1) * n, K.begin());
+            for (uint64 s = 1; s < 6; ++s)
+            {
+                const float64* a = __RK45_A_Table + s * 5;
+                for (uint64 j = 0; j < n; ++j)
+                {
+                    float64 dy = 0;
+                    for (uint64 k = 0; k < s; ++k) {dy += K[k * n + j] * a[k];}
+                    StageY[j] = y[j] + h * dy;
+                }
+                Evaluate(t + __RK45_C_Table[s] * h, StageY, std::span<float64>(K.data() + s * n, n));
+            }
+            for (uint64 j = 0; j < n; ++j)
+            {
+                float64 dy = 0;
+                for (uint64 k = 0; k < 6; ++k) {dy += K[k * n + j] * __RK45_B_Table[k];}
+                NewY[j] = y[j] + h * dy;
+            }
+            StartupT[i + 1] = (i + 1 == Steps && Sign * (t0 + float64(Steps) * h - EndPoint) >= 0) ?
+                EndPoint : t0 + float64(i + 1) * h;
+            Evaluate(StartupT[i + 1], std::span<const float64>(NewY, n), std::span<float64>(K.data() + 6 * n, n));
+            std::copy(K.begin() + 6 * n, K.end(), StartupFx.begin() + (i + 1) * n);
+
+            float64 Sum = 0;
+            for (uint64 j = 0; j < n; ++j)
+            {
+                float64 Error = 0;
+                for (uint64 k = 0; k < 7; ++k) {Error += K[k * n + j] * __RK45_E_Table[k];}
+                float64 Sc = AbsToler + max(abs(y[j]), abs(NewY[j])) * RelToler;
+                Sum += pow(Error * h / Sc, 2);
+            }
+            float64 ErrNorm = sqrt(Sum / float64(n));
+            if (!(ErrNorm <= 1))
+            {
+                AbsH = abs(h) * (ErrNorm > 0 ? max(0.2, 0.9 * yroot(ErrNorm, -5)) : 0.2);
+                Accept = false;
+            }
+        }
+        StartupStep = h;
+    }
+
+    // 由4个等距点的导数插值，构造末点处的Nordsieck向量
+    const float64* f0 = StartupFx.data(), *f1 = f0 + n, *f2 = f1 + n, *f3 = f2 + n;
+    const float64 h = StartupStep;
+    for (uint64 j = 0; j < n; ++j)
+    {
+        float64 D1 = f3[j] - f2[j], D2 = f3[j] - 2. * f2[j] + f1[j];
+        float64 D3 = f3[j] - 3. * f2[j] + 3. * f1[j] - f0[j];
+        Nordsieck[j] = StartupY[Steps * n + j];
+        Nordsieck[n + j] = h * f3[j];
+        Nordsieck[2 * n + j] = h * (D1 + D2 / 2. + D3 / 3.) / 2.;
+        Nordsieck[3 * n + j] = h * (D2 / 2. + D3 / 2.) / 3.;
+        Nordsieck[4 * n + j] = h * (D3 / 6.) / 4.;
+    }
+    StepSize = h;
+    Order = PendingOrder = StartupOrder;
+    StepsAtOrder = 0;
+    PendingEta = 1;
+    StartupIndex = 0;
+    return true;
+}
+
+void AdamsODEEngine::Rescale(float64 Eta)
+{
+    const uint64 n = EquationCount;
+    float64 Factor = 1;
+    for (uint64 k = 1; k <= Order; ++k)
+    {
+        Factor *= Eta;
+        for (uint64 j = 0; j < n; ++j) {Nordsieck[k * n + j] *= Factor;}
+    }
+    StepSize *= Eta;
+}
+
+int AdamsODEEngine::Advance()
+{
+    const uint64 n = EquationCount;
+    const float64 Sign = Direction ? -1 : 1;
+
+    // 起步阶段，逐步返回预先算好的点
+    if (StartupIndex < StartupOrder - 1)
+    {
+        ++StartupIndex;
+        PrevT = CurrentT;
+        CurrentT = StartupT[StartupIndex];
+        std::swap(PrevY, CurrentY);
+        CurrentY.assign(StartupY.begin() + StartupIndex * n, StartupY.begin() + (StartupIndex + 1) * n);
+        return 0;
+    }
+    StartupIndex = StartupOrder;
+
+    // 应用上一步决定的阶数和步长
+    Order = PendingOrder;
+    if (PendingEta != 1)
+    {
+        Rescale(PendingEta);
+        PendingEta = 1;
+    }
+
+    const float64 t = CurrentT;
+    float64 RelToler = pow(10, -RelTolerNLog);
+    float64 AbsToler = pow(10, -AbsTolerNLog);
+    float64 MinStep = 10. * abs(std::nextafter(t, Sign * __Float64::FromBytes(POS_INF_DOUBLE)) - t);
+    if (abs(StepSize) > MaxStep)
+    {
+        Rescale(MaxStep / abs(StepSize));
+        StepsAtOrder = 0;
+    }
+
+    uint64 Failures = 0;
+    float64 NextT, ErrNorm;
+    for (;;)
+    {
+        NextT = t + StepSize;
+        if (Sign * (NextT - EndPoint) >= 0)
+        {
+            if (NextT != EndPoint)
+            {
+                Rescale((EndPoint - t) / StepSize);
+                StepsAtOrder = 0;
+            }
+            NextT = EndPoint;
+        }
+        const float64 h = StepSize, q = Order;
+        if (abs(h) < MinStep) {return 1;}
+
+        // 预测：Nordsieck向量乘以帕斯卡矩阵
+        std::copy(Nordsieck.begin(), Nordsieck.begin() + (Order + 1) * n, Predicted.begin());
+        for (uint64 k = 1; k <= Order; ++k)
+        {
+            for (uint64 i = Order; i >= k; --i)
+            {
+                for (uint64 j = 0; j < n; ++j) {Predicted[(i - 1) * n + j] += Predicted[i * n + j];}
+            }
+        }
+
+        // 两次校正，每次求解h * f(y) - Zp[1] = l[1] * e
+        const float64 l1 = __Adams_L[Order][1];
+        bool Finite = true;
+        CurrentY.swap(PrevY); // PrevY暂存为工作空间，失败时恢复
+        std::copy(Predicted.begin(), Predicted.begin() + n, CurrentY.begin());
+        for (uint64 m = 0; m < 2 && Finite; ++m)
+        {
+            Evaluate(NextT, CurrentY, NewFx);
+            for (uint64 j = 0; j < n; ++j)
+            {
+                Correction[j] = (h * NewFx[j] - Predicted[n + j]) / l1;
+                CurrentY[j] = Predicted[j] + Correction[j];
+                Finite = Finite && std::isfinite(CurrentY[j]);
+            }
+        }
+        CurrentY.swap(PrevY);
+
+        ErrNorm = __Float64::FromBytes(POS_INF_DOUBLE);
+        if (Finite)
+        {
+            float64 Sum = 0;
+            for (uint64 j = 0; j < n; ++j)
+            {
+                float64 NewY = Predicted[j] + Correction[j];
+                Scale[j] = AbsToler + max(abs(CurrentY[j]), abs(NewY)) * RelToler;
+                Sum += pow(Correction[j] / Scale[j], 2);
+            }
+            ErrNorm = __Adams_Error_Const(Order, 0) * sqrt(Sum / float64(n));
+        }
+        if (ErrNorm <= 1) {break;}
+
+        // 拒绝此步，连续失败3次时降到1阶
+        ++Failures;
+        float64 Eta = std::isfinite(ErrNorm) ? max(0.2, 0.9 * yroot(ErrNorm, -(q + 1))) : 0.25;
+        if (Failures >= 3 && Order > 1)
+        {
+            Order = 1;
+            Eta = min(Eta, 0.1);
+        }
+        Rescale(Eta);
+        PendingOrder = Order;
+        StepsAtOrder = 0;
+    }
+
+    // 校正Nordsieck向量
+    for (uint64 k = 0; k <= Order; ++k)
+    {
+        const float64 l = __Adams_L[Order][k];
+        for (uint64 j = 0; j < n; ++j) {Nordsieck[k * n + j] = Predicted[k * n + j] + l * Correction[j];}
+    }
+    PrevT = t;
+    CurrentT = NextT;
+    std::swap(PrevY, CurrentY);
+    std::copy(Nordsieck.begin(), Nordsieck.begin() + n, CurrentY.begin());
+    ++StepsAtOrder;
+
+    // 同一阶数和步长下走过Order + 1步后，比较相邻阶的误差以决定新的阶数和步长
+    if (StepsAtOrder > Order)
+    {
+        auto RMS = [&](auto&& Func)
+        {
+            float64 Sum = 0;
+            for (uint64 j = 0; j < n; ++j) {Sum += pow(Func(j) / Scale[j], 2);}
+            return sqrt(Sum / float64(n));
+        };
+        const float64 q = Order;
+        float64 EtaSame = 1. / (1.2 * yroot(ErrNorm, q + 1) + 1.2E-6), EtaDown = 0, EtaUp = 0;
+        if (Order > 1)
+        {
+            float64 ErrDown = __Adams_Error_Const(Order, -1) * RMS([&](uint64 j){return Nordsieck[Order * n + j];});
+            EtaDown = 1. / (1.3 * yroot(ErrDown, q) + 1.3E-6);
+        }
+        if (Order < MaxOrder)
+        {
+            float64 ErrUp = __Adams_Error_Const(Order, 1) * RMS([&](uint64 j){return Correction[j] - PrevCorrection[j];});
+            EtaUp = 1. / (1.4 * yroot(ErrUp, q + 2) + 1.4E-6);
+        }
+
+        float64 Eta = max(EtaSame, max(EtaDown, EtaUp));
+        if (Failures) {Eta = min(Eta, 1.);}
+        if (Eta >= 1.1)
+        {
+            if (Eta == EtaUp)
+            {
+                // 新增的一行由本步的校正量估计：h^(q+1) * y^(q+1) / (q+1)! ≈ l[q] * e / (q + 1)
+                const float64 l = __Adams_L[Order][Order];
+                for (uint64 j = 0; j < n; ++j) {Nordsieck[(Order + 1) * n + j] = l * Correction[j] / (q + 1);}
+                PendingOrder = Order + 1;
+            }
+            else if (Eta == EtaDown) {PendingOrder = Order - 1;}
+            PendingEta = min(Eta, 10.);
+            StepsAtOrder = 0;
+        }
+    }
+    std::swap(Correction, PrevCorrection);
+    return 0;
+}
+
+void AdamsODEEngine::BuildSegment(float64* Q)
+{
+    const uint64 n = EquationCount;
+    const float64 H = CurrentT - PrevT;
+    std::fill(Q, Q + n * MaxOrder, 0.);
+
+    if (StartupIndex < StartupOrder)
+    {
+        // 起步的龙格-库塔步，用两端的值和导数做三次埃尔米特插值
+        const float64* f0 = StartupFx.data() + (StartupIndex - 1) * n, *f1 = f0 + n;
+        for (uint64 j = 0; j < n; ++j)
+        {
+            float64 Slope = (CurrentY[j] - PrevY[j]) / H;
+            Q[j * MaxOrder] = f0[j];
+            Q[j * MaxOrder + 1] = 3. * Slope - 2. * f0[j] - f1[j];
+            Q[j * MaxOrder + 2] = f0[j] + f1[j] - 2. * Slope;
+        }
+        return;
+    }
+
+    // Nordsieck多项式y = Σ z[k] * (s - 1)^k，展开为s的幂级数。段的常数项取PrevY而不是多项式
+    // 在s = 0处的值，两者之差线性地并入一次项，使段在s = 1处等于CurrentY，相邻的段首尾相接
+    for (uint64 j = 0; j < n; ++j)
+    {
+        float64 Total = 0;
+        for (uint64 p = 1; p <= Order; ++p)
+        {
+            float64 Sum = 0, Binomial = 1; // C(k, p)
+            for (uint64 k = p; k <= Order; ++k)
+            {
+                Sum += Nordsieck[k * n + j] * Binomial * (((k - p) % 2) ? -1. : 1.);
+                Binomial = Binomial * float64(k + 1) / float64(k + 1 - p);
+            }
+            Q[j * MaxOrder + p - 1] = Sum / H;
+            Total += Sum;
+        }
+        Q[j * MaxOrder] += (CurrentY[j] - PrevY[j] - Total) / H;
+    }
+}
+
+/////////////////////////////////// 辛积分器 ///////////////////////////////////
+
+__Symplectic_Ordinary_Differential_Equation::__Symplectic_Ordinary_Differential_Equation(float64 StepSize)
+    : StepSize(abs(StepSize))
+{
+    if (!(this->StepSize > 0) || isinf(this->StepSize))
+    {
+        throw std::logic_error("Step size must be positive and finite.");
+    }
+}
+
+void __Symplectic_Ordinary_Differential_Equation::Init(ValueArray InitState, float64 First, float64 Last)
+{
+    EndPoint = Last;
+    PrevT = CurrentT = First;
+    PrevY = CurrentY = InitState;
+    Direction = __Float64(EndPoint - First).Negative;
+    BeginRecord(First, InitState);
+    State = Processing;
+}
+
+void __Symplectic_Ordinary_Differential_Equation::Clear()
+{
+    State = Processing;
+    EndPoint = 0;
+    Direction = 0;
+    StateBuffer.clear();
+    PrevT = CurrentT = 0;
+    PrevY.clear();
+    CurrentY.clear();
+    LastPoint = PrevLastPoint = __Float64::FromBytes(BIG_NAN_DOUBLE);
+    NextOutput = 0;
+}
+
+void __Symplectic_Ordinary_Differential_Equation::NextStep()
+{
+    PrevT = CurrentT;
+    std::copy(CurrentY.begin(), CurrentY.end(), PrevY.begin());
+    float64 Remain = EndPoint - CurrentT;
+    if (abs(Remain) <= StepSize)
+    {
+        // 最后一步截短，直接落在终点上
+        Advance(Remain);
+        CurrentT = EndPoint;
+        return;
+    }
+    float64 h = Direction ? -StepSize : StepSize;
+    Advance(h);
+    CurrentT += h;
+}
+
+int __Symplectic_Ordinary_Differential_Equation::Run()
+{
+    NextStep();
+    Record(CurrentT, CurrentY);
+    return 0;
+}
+
+__Symplectic_Ordinary_Differential_Equation::StateCode __Symplectic_Ordinary_Differential_Equation::Step()
+{
+    if (State != Processing) {throw std::logic_error("Engine is finished.");}
+    if (CurrentT == EndPoint)
+    {
+        State = Succeeded;
+        return State;
+    }
+    NextStep();
+    if (CurrentT == EndPoint) {State = Succeeded;}
+    return State;
+}
+
+void __Symplectic_Ordinary_Differential_Equation::Hermite(float64 t0, std::span<const float64> y0,
+    float64 t1, std::span<const float64> y1, float64 x, std::span<float64> Out)const
+{
+    uint64 n = y0.size();
+    ValueArray D0(n), D1(n);
+    Derivatives(t0, y0, D0);
+    Derivatives(t1, y1, D1);
+    float64 h = t1 - t0;
+    float64 s = (x - t0) / h;
+    float64 H00 = (1. + 2. * s) * (1. - s) * (1. - s);
+    float64 H10 = s * (1. - s) * (1. - s);
+    float64 H01 = s * s * (3. - 2. * s);
+    float64 H11 = s * s * (s - 1.);
+    for (uint64 i = 0; i < n; ++i)
+    {
+        Out[i] = H00 * y0[i] + H10 * h * D0[i] + H01 * y1[i] + H11 * h * D1[i];
+    }
+}
+
+void __Symplectic_Ordinary_Differential_Equation::InterpolateStep(float64 x, std::span<float64> Out)
+{
+    Hermite(PrevT, PrevY, CurrentT, CurrentY, x, Out);
+}
+
+__Symplectic_Ordinary_Differential_Equation::ValueArray
+__Symplectic_Ordinary_Differential_Equation::operator()(float64 _Xx)const
+{
+    auto Upper = StateBuffer.lower_bound(_Xx);
+    if (Upper != StateBuffer.end() && Upper->first == _Xx) {return Upper->second;}
+    if (Upper == StateBuffer.begin() || Upper == StateBuffer.end())
+    {
+        throw std::logic_error("Point is out of range.");
+    }
+    auto Lower = std::prev(Upper);
+    ValueArray Result(Lower->second.size());
+    Hermite(Lower->first, Lower->second, Upper->first, Upper->second, _Xx, Result);
+    return Result;
+}
+
+// ---------------------------------------------------------------------------- //
+
+// 吉田的组合系数，按w1, w2, ...排列，w0 = 1 - 2 * Σwi
+static const float64 __Yoshida6_Weights[3] =
+{
+    -1.17767998417887, 0.235573213359357, 0.784513610477560
+};
+
+static const float64 __Yoshida8_Weights[7] =
+{
+    0.102799849391985, -1.96061023297549, 1.93813913762276, -0.158240635368243,
+    -1.44485223686048, 0.253693336566229, 0.914844246229740
+};
+
+SymplecticODEEngine::SymplecticODEEngine(std::function<SplitFty> DriftFunc, std::function<SplitFty> KickFunc,
+    uint64 Dimensions, float64 StepSize, SchemeType Scheme)
+    : Mybase(StepSize), Drift(DriftFunc), Kick(KickFunc), Dimensions(Dimensions), Scheme(Scheme),
+    Increment(Dimensions)
+{
+    // 组合的蛙跳步长权重，序列对称：wm, ..., w1, w0, w1, ..., wm
+    ValueArray Weights;
+    auto Compose = [&Weights](const float64* W, uint64 m)
+    {
+        float64 w0 = 1;
+        for (uint64 i = 0; i < m; ++i) {w0 -= 2. * W[i];}
+        for (uint64 i = m; i > 0; --i) {Weights.push_back(W[i - 1]);}
+        Weights.push_back(w0);
+        for (uint64 i = 0; i < m; ++i) {Weights.push_back(W[i]);}
+    };
+
+    switch (Scheme)
+    {
+    case Leapfrog:
+        Weights = {1};
+        break;
+    case ForestRuth:
+    {
+        float64 w1 = 1. / (2. - cbrt(2.));
+        Compose(&w1, 1);
+        break;
+    }
+    case Yoshida6:
+        Compose(__Yoshida6_Weights, 3);
+        break;
+    case Yoshida8:
+        Compose(__Yoshida8_Weights, 7);
+        break;
+    default:
+        throw std::logic_error("Unknown symplectic scheme.");
+    }
+
+    // 相邻两次蛙跳的半步漂移合并为一次
+    uint64 s = Weights.size();
+    KickCoeffs = Weights;
+    DriftCoeffs.resize(s + 1);
+    DriftCoeffs[0] = Weights[0] / 2.;
+    for (uint64 i = 1; i < s; ++i) {DriftCoeffs[i] = (Weights[i - 1] + Weights[i]) / 2.;}
+    DriftCoeffs[s] = Weights[s - 1] / 2.;
+}
+
+int SymplecticODEEngine::SymplecticOrder()const
+{
+    switch (Scheme)
+    {
+    case Leapfrog:
+        return 2;
+    case ForestRuth:
+        return 4;
+    case Yoshida6:
+        return 6;
+    case Yoshida8:
+        return 8;
+    }
+    return 0;
+}
+
+void SymplecticODEEngine::Init(ValueArray InitState, float64 First, float64 Last)
+{
+    if (InitState.size() != 2 * Dimensions)
+    {
+        throw std::logic_error("Solution count is not equal to parameter count.");
+    }
+    Mybase::Init(InitState, First, Last);
+}
+
+void SymplecticODEEngine::Advance(float64 h)
+{
+    std::span<float64> q(CurrentY.data(), Dimensions);
+    std::span<float64> p(CurrentY.data() + Dimensions, Dimensions);
+    float64 t = CurrentT;
+    for (uint64 i = 0; i < DriftCoeffs.size(); ++i)
+    {
+        float64 dt = DriftCoeffs[i] * h;
+        Drift(t, p, Increment);
+        for (uint64 j = 0; j < Dimensions; ++j) {q[j] += dt * Increment[j];}
+        t += dt;
+
+        if (i == KickCoeffs.size()) {break;}
+        Kick(t, q, Increment);
+        float64 dp = KickCoeffs[i] * h;
+        for (uint64 j = 0; j < Dimensions; ++j) {p[j] += dp * Increment[j];}
+    }
+}
+
+void SymplecticODEEngine::Derivatives(float64 t, std::span<const float64> y, std::span<float64> Out)const
+{
+    Drift(t, y.subspan(Dimensions, Dimensions), Out.first(Dimensions));
+    Kick(t, y.first(Dimensions), Out.subspan(Dimensions, Dimensions));
+}
+
+// ---------------------------------------------------------------------------- //
+
+// 斯通普夫函数C(z)和S(z)，|z|较小时用级数避免相消
+static void __Stumpff_Functions(float64 z, float64* C, float64* S)
+{
+    if (abs(z) < 0.1)
+    {
+        float64 CTerm = 1. / 2., STerm = 1. / 6.;
+        *C = 0;
+        *S = 0;
+        for (int k = 0; k < 8; ++k)
+        {
+            *C += CTerm;
+            *S += STerm;
+            CTerm *= -z / ((2. * k + 3.) * (2. * k + 4.));
+            STerm *= -z / ((2. * k + 4.) * (2. * k + 5.));
+        }
+    }
+    else if (z > 0)
+    {
+        float64 sz = sqrt(z);
+        *C = (1. - cos(Angle::FromRadians(sz))) / z;
+        *S = (sz - sin(Angle::FromRadians(sz))) / (z * sz);
+    }
+    else
+    {
+        float64 sz = sqrt(-z);
+        *C = (cosh(sz) - 1.) / -z;
+        *S = (sinh(sz) - sz) / (-z * sz);
+    }
+}
+
+WisdomHolmanEngine::WisdomHolmanEngine(std::function<SplitFty> Perturbation, ValueArray GravParams, float64 StepSize)
+    : Mybase(StepSize), Perturbation(Perturbation), GravParams(GravParams), BodyCount(GravParams.size()) {}
+
+void WisdomHolmanEngine::KeplerDrift(float64 GravParam, float64* Position, float64* Velocity, float64 dt)
+{
+    if (dt == 0) {return;}
+    float64* R = Position;
+    float64* V = Velocity;
+    float64 r0 = sqrt(R[0] * R[0] + R[1] * R[1] + R[2] * R[2]);
+    float64 v2 = V[0] * V[0] + V[1] * V[1] + V[2] * V[2];
+    float64 rv = R[0] * V[0] + R[1] * V[1] + R[2] * V[2];
+    float64 SqrtMu = sqrt(GravParam);
+    float64 Alpha = 2. / r0 - v2 / GravParam; // 半长轴的倒数
+
+    // 椭圆轨道先去掉整周期，保证牛顿迭代的初值足够好
+    if (Alpha > 0)
+    {
+        float64 Period = 2. * CSE_PI / (SqrtMu * Alpha * sqrt(Alpha));
+        if (abs(dt) > Period) {dt -= Period * float64(int64(dt / Period));}
+    }
+
+    // 用Laguerre-Conway方法解普适开普勒方程，它对任意偏心率都能收敛，而牛顿法在偏心率很大或
+    // 双曲轨道上常常发散。F的各项相互抵消时其舍入误差可能远大于χ的ulp(例如从远处反向经过近心点)，
+    // 因此残差降到F的舍入误差水平时也视为收敛
+    const float64 LaguerreN = 5;
+    float64 Chi = Alpha > 0 ? SqrtMu * Alpha * dt : SqrtMu * dt / r0;
+    if (Alpha <= 0)
+    {
+        // 抛物线和双曲轨道上χ分别按时间的立方根和对数增长，线性的初值可能使Stumpff函数溢出
+        float64 Sign = dt < 0 ? -1 : 1;
+        float64 Guess = min(abs(Chi), cbrt(6. * SqrtMu * abs(dt)));
+        if (Alpha < 0)
+        {
+            float64 SqrtA = sqrt(-1. / Alpha);
+            float64 Ratio = -2. * GravParam * Alpha * dt / (rv + Sign * SqrtMu * SqrtA * (1. - r0 * Alpha));
+            if (Ratio > 1) {Guess = min(Guess, SqrtA * ln(Ratio));}
+        }
+        Chi = Sign * Guess;
+    }
+    float64 z, C, S;
+    bool Converged = false;
+    for (int i = 0; i < 64; ++i)
+    {
+        z = Alpha * Chi * Chi;
+        __Stumpff_Functions(z, &C, &S);
+        float64 Chi2 = Chi * Chi;
+        float64 Terms[4] = {rv / SqrtMu * Chi2 * C, (1. - Alpha * r0) * Chi2 * Chi * S, r0 * Chi, -SqrtMu * dt};
+        float64 F = Terms[0] + Terms[1] + Terms[2] + Terms[3];
+        float64 Noise = 8. * DOUBLE_EPSILON * (abs(Terms[0]) + abs(Terms[1]) + abs(Terms[2]) + abs(Terms[3]));
+        float64 dF = rv / SqrtMu * Chi * (1. - z * S) + (1. - Alpha * r0) * Chi2 * C + r0;
+        float64 d2F = rv / SqrtMu * (1. - z * C) + (1. - Alpha * r0) * Chi * (1. - z * S);
+        float64 Root = sqrt(abs((LaguerreN - 1.) * (LaguerreN - 1.) * dF * dF
+            - LaguerreN * (LaguerreN - 1.) * F * d2F));
+        float64 Delta = LaguerreN * F / (dF + (dF < 0 ? -Root : Root));
+        Chi -= Delta;
+        if (abs(Delta) <= 8. * DOUBLE_EPSILON * abs(Chi) || abs(F) <= Noise)
+        {
+            Converged = true;
+            break;
+        }
+    }
+    if (!Converged) {throw std::logic_error("Kepler equation is not converged.");}
+
+    // 拉格朗日系数f, g及其导数
+    z = Alpha * Chi * Chi;
+    __Stumpff_Functions(z, &C, &S);
+    float64 Chi2 = Chi * Chi;
+    float64 f = 1. - Chi2 / r0 * C;
+    float64 g = dt - Chi2 * Chi / SqrtMu * S;
+    float64 NewR[3] = {f * R[0] + g * V[0], f * R[1] + g * V[1], f * R[2] + g * V[2]};
+    float64 r = sqrt(NewR[0] * NewR[0] + NewR[1] * NewR[1] + NewR[2] * NewR[2]);
+    float64 fdot = SqrtMu / (r * r0) * (z * Chi * S - Chi);
+    float64 gdot = 1. - Chi2 / r * C;
+    for (int i = 0; i < 3; ++i)
+    {
+        V[i] = fdot * R[i] + gdot * V[i];
+        R[i] = NewR[i];
+    }
+}
+
+void WisdomHolmanEngine::Init(ValueArray InitState, float64 First, float64 Last)
+{
+    if (InitState.size() != 6 * BodyCount)
+    {
+        throw std::logic_error("Solution count is not equal to parameter count.");
+    }
+    Mybase::Init(InitState, First, Last);
+    Acceleration.resize(3 * BodyCount);
+    Perturbation(First, std::span<const float64>(CurrentY.data(), 3 * BodyCount), Acceleration);
+}
+
+void WisdomHolmanEngine::Advance(float64 h)
+{
+    uint64 n = 3 * BodyCount;
+    float64* R = CurrentY.data();
+    float64* V = CurrentY.data() + n;
+
+    for (uint64 i = 0; i < n; ++i) {V[i] += h / 2. * Acceleration[i];}
+    for (uint64 i = 0; i < BodyCount; ++i) {KeplerDrift(GravParams[i], R + 3 * i, V + 3 * i, h);}
+    Perturbation(CurrentT + h, std::span<const float64>(R, n), Acceleration);
+    for (uint64 i = 0; i < n; ++i) {V[i] += h / 2. * Acceleration[i];}
+}
+
+void WisdomHolmanEngine::Derivatives(float64 t, std::span<const float64> y, std::span<float64> Out)const
+{
+    uint64 n = 3 * BodyCount;
+    std::copy(y.begin() + n, y.end(), Out.begin());
+    Perturbation(t, y.first(n), Out.subspan(n));
+    for (uint64 i = 0; i < BodyCount; ++i)
+    {
+        const float64* R = y.data() + 3 * i;
+        float64 r = sqrt(R[0] * R[0] + R[1] * R[1] + R[2] * R[2]);
+        float64 k = -GravParams[i] / (r * r * r);
+        for (int j = 0; j < 3; ++j) {Out[n + 3 * i + j] += k * R[j];}
+    }
+}
+
+/////////////////////////////////// 系综积分 ///////////////////////////////////
+
+EnsembleODEEngine::EnsembleODEEngine(std::function<InPlaceFty> Func, uint64 EquationCount)
+    : EquationCount(EquationCount)
+{
+    Function = [Func, EquationCount](std::span<const float64> Times,
+        std::span<const float64> States, std::span<float64> Derivatives)
+    {
+        const uint64 n = EquationCount, m = Times.size();
+        ValueArray y(n), dy(n);
+        for (uint64 i = 0; i < m; ++i)
+        {
+            for (uint64 j = 0; j < n; ++j) {y[j] = States[j * m + i];}
+            Func(Times[i], y, dy);
+            for (uint64 j = 0; j < n; ++j) {Derivatives[j * m + i] = dy[j];}
+        }
+    };
+}
+
+void EnsembleODEEngine::Init(std::span<const float64> InitStates, uint64 MemberCount, float64 First, float64 Last)
+{
+    if (InitStates.size() != MemberCount * EquationCount)
+    {
+        throw std::logic_error("Solution count is not equal to parameter count.");
+    }
+    this->MemberCount = MemberCount;
+    FirstPoint = First;
+    EndPoint = Last;
+    States.assign(InitStates.begin(), InitStates.end());
+    Times.assign(MemberCount, First);
+    MemberStates.assign(MemberCount, OrdinaryDifferentialEquation::Processing);
+    StepCounts.assign(MemberCount, 0);
+}
+
+void EnsembleODEEngine::Run()
+{
+    if (!BlockSize) {throw std::logic_error("Block size must be positive.");}
+    uint64 BlockCount = (MemberCount + BlockSize - 1) / BlockSize;
+    __Parallel_For(BlockCount, [this](uint64 Block, uint64)
+    {
+        RunBlock(Block * BlockSize, min(MemberCount, (Block + 1) * BlockSize));
+    }, Threads);
+}
+
+EnsembleODEEngine::ValueArray EnsembleODEEngine::Solution(uint64 Member)const
+{
+    ValueArray Result(EquationCount);
+    for (uint64 j = 0; j < EquationCount; ++j) {Result[j] = States[j * MemberCount + Member];}
+    return Result;
+}
+
+void EnsembleODEEngine::RunBlock(uint64 Begin, uint64 End)
+{
+    // RK45，系数同RungeKutta4thOrderODEEngine
+    const uint64 n = EquationCount, NStages = 6, M = MemberCount;
+    const float64* CTable = __RK45_C_Table;
+    const float64* ATable = __RK45_A_Table;
+    const float64* BTable = __RK45_B_Table;
+    const float64* ETable = __RK45_E_Table;
+    const uint64   ATableStride = 5;
+    const float64  ErrExponent = 5;
+
+    const float64 Sign = __Float64(EndPoint - FirstPoint).Negative ? -1. : 1.;
+    const float64 RelToler = pow(10, -RelTolerNLog);
+    const float64 AbsToler = pow(10, -AbsTolerNLog);
+
+    // 组内工作空间，第i个活跃成员的第j个分量位于[j * m + i]，m随成员的退出而减小
+    uint64 m = End - Begin;
+    std::vector<uint64> Ids(m);
+    std::vector<uint8_t> Reject(m, 0);
+    std::vector<uint64> Steps(m);
+    ValueArray T(m), AbsH(m), NextT(m), H(m), StageT(m), ErrSum(m);
+    ValueArray Y(n * m), Fx(n * m), StageY(n * m), NewY(n * m), K((NStages + 1) * n * m);
+    for (uint64 i = 0; i < m; ++i)
+    {
+        Ids[i] = Begin + i;
+        T[i] = Times[Begin + i];
+        Steps[i] = StepCounts[Begin + i];
+        for (uint64 j = 0; j < n; ++j) {Y[j * m + i] = States[j * M + Begin + i];}
+    }
+    if (!m) {return;}
+    Function(T, Y, Fx);
+
+    // ---------- 初始步长，同RungeKuttaODEEngine::SetInitStep ---------- //
+
+    {
+        ValueArray d0(m, 0), d1(m, 0), d2(m, 0), h0(m);
+        for (uint64 j = 0; j < n; ++j)
+        {
+            for (uint64 i = 0; i < m; ++i)
+            {
+                float64 Scale = AbsToler + abs(Y[j * m + i]) * RelToler;
+                float64 q0 = Y[j * m + i] / Scale, q1 = Fx[j * m + i] / Scale;
+                d0[i] += q0 * q0;
+                d1[i] += q1 * q1;
+            }
+        }
+        for (uint64 i = 0; i < m; ++i)
+        {
+            d0[i] = sqrt(d0[i] / float64(n));
+            d1[i] = sqrt(d1[i] / float64(n));
+            if (d0[i] < 1E-5 || d1[i] < 1E-5) {h0[i] = 1E-6;}
+            else {h0[i] = 0.01 * d0[i] / d1[i];}
+            StageT[i] = T[i] + h0[i] * Sign;
+        }
+        for (uint64 j = 0; j < n; ++j)
+        {
+            for (uint64 i = 0; i < m; ++i) {StageY[j * m + i] = Y[j * m + i] + h0[i] * Sign * Fx[j * m + i];}
+        }
+        Function(StageT, StageY, NewY);
+        for (uint64 j = 0; j < n; ++j)
+        {
+            for (uint64 i = 0; i < m; ++i)
+            {
+                float64 Scale = AbsToler + abs(Y[j * m + i]) * RelToler;
+                float64 q = (NewY[j * m + i] - Fx[j * m + i]) / Scale;
+                d2[i] += q * q;
+            }
+        }
+        for (uint64 i = 0; i < m; ++i)
+        {
+            d2[i] = sqrt(d2[i] / float64(n)) / h0[i];
+            float64 h1;
+            if (d1[i] <= 1E-15 && d2[i] <= 1E-15) {h1 = max(1E-6, h0[i] * 1E-3);}
+            else {h1 = yroot((0.01 / max(d1[i], d2[i])), ErrExponent);}
+            AbsH[i] = min(100 * h0[i], h1);
+        }
+    }
+
+    // ---------- 同步推进，每轮每个成员尝试一步 ---------- //
+
+    std::vector<uint8_t> Finished(m);
+    while (m)
+    {
+        // 确定各成员的步长，新的一步开始时限制在[MinStep, MaxStep]内
+        bool AnyFinished = false;
+        for (uint64 i = 0; i < m; ++i)
+        {
+            float64 MinStep = 10. * abs(nextafter(T[i], Sign * std::numeric_limits<float64>::infinity()) - T[i]);
+            if (!Reject[i])
+            {
+                if (AbsH[i] > MaxStep) {AbsH[i] = MaxStep;}
+                else if (AbsH[i] < MinStep) {AbsH[i] = MinStep;}
+            }
+            Finished[i] = AbsH[i] < MinStep;
+            if (Finished[i])
+            {
+                MemberStates[Ids[i]] = OrdinaryDifferentialEquation::Failed;
+                AnyFinished = true;
+            }
+            NextT[i] = T[i] + Sign * AbsH[i];
+            if (Sign * (NextT[i] - EndPoint) > 0) {NextT[i] = EndPoint;}
+            H[i] = NextT[i] - T[i];
+        }
+
+        std::copy(Fx.begin(), Fx.begin() + n * m, K.begin());
+        for (uint64 s = 1; s < NStages; ++s)
+        {
+            const float64* a = ATable + s * ATableStride;
+            for (uint64 j = 0; j < n; ++j)
+            {
+                float64* dy = StageY.data() + j * m;
+                std::fill(dy, dy + m, 0.);
+                for (uint64 k = 0; k < s; ++k)
+                {
+                    const float64* Kk = K.data() + (k * n + j) * m;
+                    for (uint64 i = 0; i < m; ++i) {dy[i] += Kk[i] * a[k];}
+                }
+                for (uint64 i = 0; i < m; ++i) {dy[i] = Y[j * m + i] + H[i] * dy[i];}
+            }
+            for (uint64 i = 0; i < m; ++i) {StageT[i] = T[i] + CTable[s] * H[i];}
+            Function(std::span<const float64>(StageT.data(), m), std::span<const float64>(StageY.data(), n * m),
+                std::span<float64>(K.data() + s * n * m, n * m));
+        }
+
+        for (uint64 j = 0; j < n; ++j)
+        {
+            float64* dy = NewY.data() + j * m;
+            std::fill(dy, dy + m, 0.);
+            for (uint64 k = 0; k < NStages; ++k)
+            {
+                const float64* Kk = K.data() + (k * n + j) * m;
+                for (uint64 i = 0; i < m; ++i) {dy[i] += Kk[i] * BTable[k];}
+            }
+            for (uint64 i = 0; i < m; ++i) {dy[i] = Y[j * m + i] + H[i] * dy[i];}
+        }
+        Function(std::span<const float64>(NextT.data(), m), std::span<const float64>(NewY.data(), n * m),
+            std::span<float64>(K.data() + NStages * n * m, n * m));
+
+        // 误差估计
+        std::fill(ErrSum.begin(), ErrSum.begin() + m, 0.);
+        for (uint64 j = 0; j < n; ++j)
+        {
+            float64* Error = StageY.data(); // 各级已算完，借用为临时空间
+            std::fill(Error, Error + m, 0.);
+            for (uint64 k = 0; k <= NStages; ++k)
+            {
+                const float64* Kk = K.data() + (k * n + j) * m;
+                for (uint64 i = 0; i < m; ++i) {Error[i] += Kk[i] * ETable[k];}
+            }
+            for (uint64 i = 0; i < m; ++i)
+            {
+                float64 Scale = AbsToler + max(abs(Y[j * m + i]), abs(NewY[j * m + i])) * RelToler;
+                float64 q = Error[i] * H[i] / Scale;
+                ErrSum[i] += q * q;
+            }
+        }
+
+        // 逐成员接受或拒绝
+        for (uint64 i = 0; i < m; ++i)
+        {
+            if (Finished[i]) {continue;}
+            float64 EstmErrNorm = sqrt(ErrSum[i] / float64(n));
+            if (EstmErrNorm < 1)
+            {
+                float64 Factor;
+                if (EstmErrNorm == 0) {Factor = MaxFactor;}
+                else {Factor = min(MaxFactor, FactorSafe * yroot(EstmErrNorm, -ErrExponent));}
+                if (Reject[i]) {Factor = min(1, Factor);}
+                AbsH[i] *= Factor;
+                Reject[i] = 0;
+
+                T[i] = NextT[i];
+                for (uint64 j = 0; j < n; ++j)
+                {
+                    Y[j * m + i] = NewY[j * m + i];
+                    Fx[j * m + i] = K[(NStages * n + j) * m + i];
+                }
+                ++Steps[i];
+                if (T[i] == EndPoint)
+                {
+                    Finished[i] = 1;
+                    MemberStates[Ids[i]] = OrdinaryDifferentialEquation::Succeeded;
+                    AnyFinished = true;
+                }
+            }
+            else
+            {
+                AbsH[i] *= max(MinFactor, FactorSafe * yroot(EstmErrNorm, -ErrExponent));
+                Reject[i] = 1;
+            }
+        }
+
+        if (!AnyFinished) {continue;}
+
+        // 写回退出的成员，并把剩余的成员原地压缩到前面，新的位置总不超过旧的位置
+        uint64 Active = 0;
+        for (uint64 i = 0; i < m; ++i)
+        {
+            if (!Finished[i]) {++Active;}
+        }
+        for (uint64 j = 0; j < n; ++j)
+        {
+            uint64 Dest = 0;
+            for (uint64 i = 0; i < m; ++i)
+            {
+                if (Finished[i]) {States[j * M + Ids[i]] = Y[j * m + i];}
+                else
+                {
+                    Y[j * Active + Dest] = Y[j * m + i];
+                    Fx[j * Active + Dest] = Fx[j * m + i];
+                    ++Dest;
+                }
+            }
+        }
+        uint64 Dest = 0;
+        for (uint64 i = 0; i < m; ++i)
+        {
+            if (Finished[i])
+            {
+                Times[Ids[i]] = T[i];
+                StepCounts[Ids[i]] = Steps[i];
+                continue;
+            }
+            Ids[Dest] = Ids[i];
+            T[Dest] = T[i];
+            AbsH[Dest] = AbsH[i];
+            Reject[Dest] = Reject[i];
+            Steps[Dest] = Steps[i];
+            ++Dest;
+        }
+        m = Active;
+    }
+}
+
+//////////////////////////////////// 时间并行 /////////////////////////////////////
+
+PararealODESolver::ValueArray PararealODESolver::Propagate(OrdinaryDifferentialEquation& Engine,
+    const ValueArray& y0, float64 t0, float64 t1)
+{
+    OrdinaryDifferentialEquation::OutputPolicy Policy;
+    Policy.Mode = Policy.KeepLast;
+    Engine.SetOutputPolicy(std::move(Policy));
+    Engine.Init(y0, t0, t1);
+    while (Engine.CurrentState() == Engine.Processing) {Engine.InvokeRun();}
+    if (Engine.CurrentState() != Engine.Succeeded)
+    {
+        throw std::logic_error("Parareal: propagator failed.");
+    }
+    return Engine.Solutions().rbegin()->second;
+}
+
+PararealODESolver::ValueArray PararealODESolver::State(uint64 Slice)const
+{
+    if (Slice >= SliceTimes.size()) {throw std::logic_error("Slice is out of range.");}
+    return ValueArray(SliceStates.begin() + Slice * EquationCount,
+        SliceStates.begin() + (Slice + 1) * EquationCount);
+}
+
+bool PararealODESolver::Run(ValueArray InitState, float64 First, float64 Last)
+{
+    auto Start = std::chrono::steady_clock::now();
+    const uint64 n = EquationCount = InitState.size();
+    const uint64 Workers = Threads ? Threads : max(uint64(1), uint64(std::thread::hardware_concurrency()));
+    const uint64 N = Slices ? Slices : Workers;
+    const uint64 MaxIter = MaxIterations ? min(MaxIterations, N) : N;
+    float64 RelToler = pow(10, -RelTolerNLog);
+    float64 AbsToler = pow(10, -AbsTolerNLog);
+
+    SliceTimes.resize(N + 1);
+    for (uint64 i = 0; i < N; ++i) {SliceTimes[i] = First + (Last - First) * float64(i) / float64(N);}
+    SliceTimes[N] = Last;
+
+    auto Coarse = CoarseFactory();
+    std::vector<std::unique_ptr<OrdinaryDifferentialEquation>> Fine(min(Workers, N));
+    for (auto& Engine : Fine) {Engine = FineFactory();}
+
+    // 粗求解给出各段的初值
+    ValueArray Coarses(N * n), Fines(N * n), SliceSeconds(N);
+    SliceStates.resize((N + 1) * n);
+    std::copy(InitState.begin(), InitState.end(), SliceStates.begin());
+    for (uint64 i = 0; i < N; ++i)
+    {
+        ValueArray y = Propagate(*Coarse, State(i), SliceTimes[i], SliceTimes[i + 1]);
+        std::copy(y.begin(), y.end(), Coarses.begin() + i * n);
+        std::copy(y.begin(), y.end(), SliceStates.begin() + (i + 1) * n);
+    }
+
+    Iterations = 0;
+    IsConverged = false;
+    SerialSeconds = 0;
+    for (uint64 k = 0; k < MaxIter && !IsConverged; ++k)
+    {
+        // 前k段已经收敛，只需细求解其余各段
+        std::vector<ValueArray> Inputs(N - k);
+        for (uint64 i = k; i < N; ++i) {Inputs[i - k] = State(i);}
+        __Parallel_For(N - k, [&](uint64 Task, uint64 Worker)
+        {
+            uint64 i = k + Task;
+            auto SliceStart = std::chrono::steady_clock::now();
+            ValueArray y = Propagate(*Fine[Worker], Inputs[Task], SliceTimes[i], SliceTimes[i + 1]);
+            std::copy(y.begin(), y.end(), Fines.begin() + i * n);
+            SliceSeconds[i] = std::chrono::duration<float64>(std::chrono::steady_clock::now() - SliceStart).count();
+        }, Fine.size());
+        if (!k) {for (float64 Seconds : SliceSeconds) {SerialSeconds += Seconds;}}
+        ++Iterations;
+
+        // 串行修正，记录各段初值的最大变化
+        float64 MaxChange = 0;
+        for (uint64 i = k; i < N; ++i)
+        {
+            float64* Next = SliceStates.data() + (i + 1) * n;
+            ValueArray NewCoarse;
+            if (i > k) {NewCoarse = Propagate(*Coarse, State(i), SliceTimes[i], SliceTimes[i + 1]);}
+            float64 Sum = 0;
+            for (uint64 j = 0; j < n; ++j)
+            {
+                float64 Value = Fines[i * n + j];
+                if (i > k)
+                {
+                    Value += NewCoarse[j] - Coarses[i * n + j];
+                    Coarses[i * n + j] = NewCoarse[j];
+                }
+                float64 Scale = AbsToler + max(abs(Value), abs(Next[j])) * RelToler;
+                Sum += pow((Value - Next[j]) / Scale, 2);
+                Next[j] = Value;
+            }
+            MaxChange = max(MaxChange, sqrt(Sum / float64(n)));
+        }
+        IsConverged = MaxChange <= 1 || k + 1 == N;
+    }
+
+    WallSeconds = std::chrono::duration<float64>(std::chrono::steady_clock::now() - Start).count();
+    return IsConverged;
+}
+
+//////////////////////////////////// 断点续算 /////////////////////////////////////
+
+// 快照依次为标识、版本号、引擎的类型名和各层SaveState写入的内容。标量按本机的内存表示写入，
+// 数组先写长度再写元素，因此只能在相同的平台上读回。
+
+static const char     __ODE_Snapshot_Magic[8] = {'C', 'S', 'E', 'O', 'D', 'E', 'S', 'S'};
+static const uint32_t __ODE_Snapshot_Version  = 1;
+
+template<typename _Ty> requires std::is_trivially_copyable_v<_Ty>
+static void __Snapshot_Write(std::ostream& Out, const _Ty& Value)
+{
+    Out.write(reinterpret_cast<const char*>(&Value), sizeof(_Ty));
+}
+
+template<typename _Ty> requires std::is_trivially_copyable_v<_Ty>
+static void __Snapshot_Write(std::ostream& Out, const std::vector<_Ty>& Values)
+{
+    __Snapshot_Write(Out, uint64(Values.size()));
+    Out.write(reinterpret_cast<const char*>(Values.data()), Values.size() * sizeof(_Ty));
+}
+
+static void __Snapshot_Write(std::ostream& Out, const DynamicMatrix<float64>& Matrix)
+{
+    __Snapshot_Write(Out, uint64(Matrix.size().x));
+    __Snapshot_Write(Out, uint64(Matrix.size().y));
+    for (uint64 col = 0; col < Matrix.size().x; ++col)
+    {
+        for (uint64 row = 0; row < Matrix.size().y; ++row) {__Snapshot_Write(Out, Matrix.at(col, row));}
+    }
+}
+
+static void __Snapshot_Check(std::istream& In)
+{
+    if (!In) {throw std::logic_error("Snapshot is truncated or unreadable.");}
+}
+
+template<typename _Ty> requires std::is_trivially_copyable_v<_Ty>
+static void __Snapshot_Read(std::istream& In, _Ty& Value)
+{
+    In.read(reinterpret_cast<char*>(&Value), sizeof(_Ty));
+    __Snapshot_Check(In);
+}
+
+template<typename _Ty> requires std::is_trivially_copyable_v<_Ty>
+static void __Snapshot_Read(std::istream& In, std::vector<_Ty>& Values)
+{
+    uint64 Size;
+    __Snapshot_Read(In, Size);
+    Values.resize(Size);
+    In.read(reinterpret_cast<char*>(Values.data()), Size * sizeof(_Ty));
+    __Snapshot_Check(In);
+}
+
+// 矩阵的大小由构造函数决定，只读回元素
+static void __Snapshot_Read(std::istream& In, DynamicMatrix<float64>& Matrix)
+{
+    uint64 Cols, Rows;
+    __Snapshot_Read(In, Cols);
+    __Snapshot_Read(In, Rows);
+    if (Cols != Matrix.size().x || Rows != Matrix.size().y)
+    {
+        throw std::logic_error("Snapshot does not match the size of this engine.");
+    }
+    for (uint64 col = 0; col < Cols; ++col)
+    {
+        for (uint64 row = 0; row < Rows; ++row) {__Snapshot_Read(In, Matrix.at(col, row));}
+    }
+}
+
+void OrdinaryDifferentialEquation::Snapshot(std::ostream& Out)const
+{
+    std::string_view TypeName = typeid(*this).name();
+    Out.write(__ODE_Snapshot_Magic, sizeof(__ODE_Snapshot_Magic));
+    __Snapshot_Write(Out, __ODE_Snapshot_Version);
+    __Snapshot_Write(Out, std::vector<char>(TypeName.begin(), TypeName.end()));
+    SaveState(Out);
+    if (!Out) {throw std::logic_error("Failed to write snapshot.");}
+}
+
+void OrdinaryDifferentialEquation::Restore(std::istream& In)
+{
+    char Magic[sizeof(__ODE_Snapshot_Magic)];
+    In.read(Magic, sizeof(Magic));
+    __Snapshot_Check(In);
+    if (!std::equal(Magic, Magic + sizeof(Magic), __ODE_Snapshot_Magic))
+    {
+        throw std::logic_error("Stream is not a snapshot of ODE engine.");
+    }
+    uint32_t Version;
+    __Snapshot_Read(In, Version);
+    if (Version != __ODE_Snapshot_Version)
+    {
+        throw std::logic_error("Unsupported snapshot version.");
+    }
+    std::vector<char> TypeName;
+    __Snapshot_Read(In, TypeName);
+    if (std::string_view(TypeName.data(), TypeName.size()) != typeid(*this).name())
+    {
+        throw std::logic_error("Snapshot was taken from a different type of engine.");
+    }
+    LoadState(In);
+}
+
+void OrdinaryDifferentialEquation::SaveState(std::ostream& Out)const
+{
+    __Snapshot_Write(Out, State);
+    __Snapshot_Write(Out, EndPoint);
+    __Snapshot_Write(Out, Direction);
+    __Snapshot_Write(Out, uint64(StateBuffer.size()));
+    for (const auto& [x, y] : StateBuffer)
+    {
+        __Snapshot_Write(Out, x);
+        __Snapshot_Write(Out, y);
+    }
+    __Snapshot_Write(Out, Output.Mode);
+    __Snapshot_Write(Out, Output.Capacity);
+    __Snapshot_Write(Out, Output.Times);
+    __Snapshot_Write(Out, NextOutput);
+    __Snapshot_Write(Out, LastPoint);
+    __Snapshot_Write(Out, PrevLastPoint);
+}
+
+void OrdinaryDifferentialEquation::LoadState(std::istream& In)
+{
+    __Snapshot_Read(In, State);
+    __Snapshot_Read(In, EndPoint);
+    __Snapshot_Read(In, Direction);
+    uint64 Count;
+    __Snapshot_Read(In, Count);
+    StateBuffer.clear();
+    for (uint64 i = 0; i < Count; ++i)
+    {
+        float64 x;
+        __Snapshot_Read(In, x);
+        __Snapshot_Read(In, StateBuffer[x]);
+    }
+    __Snapshot_Read(In, Output.Mode);
+    __Snapshot_Read(In, Output.Capacity);
+    __Snapshot_Read(In, Output.Times);
+    __Snapshot_Read(In, NextOutput);
+    __Snapshot_Read(In, LastPoint);
+    __Snapshot_Read(In, PrevLastPoint);
+}
+
+// ---------------------------------------------------------------------------- //
+
+void __Dense_Ordinary_Differential_Equation::SaveState(std::ostream& Out)const
+{
+    Mybase::SaveState(Out);
+    __Snapshot_Write(Out, EquationCount);
+    __Snapshot_Write(Out, DenseOutputOrder);
+    __Snapshot_Write(Out, uint64(EventList.size()));
+    __Snapshot_Write(Out, SegmentStarts);
+    __Snapshot_Write(Out, SegmentEnds);
+    __Snapshot_Write(Out, SegmentBase);
+    __Snapshot_Write(Out, SegmentCoeffs);
+    __Snapshot_Write(Out, SegmentHead);
+    __Snapshot_Write(Out, PrevT);
+    __Snapshot_Write(Out, CurrentT);
+    __Snapshot_Write(Out, PrevY);
+    __Snapshot_Write(Out, CurrentY);
+    __Snapshot_Write(Out, StepCoeffs);
+    __Snapshot_Write(Out, StepCoeffsPoint);
+    __Snapshot_Write(Out, EventValues);
+    __Snapshot_Write(Out, uint64(EventLog.size()));
+    for (const auto& Record : EventLog)
+    {
+        __Snapshot_Write(Out, Record.Index);
+        __Snapshot_Write(Out, Record.Time);
+        __Snapshot_Write(Out, Record.State);
+    }
+}
+
+void __Dense_Ordinary_Differential_Equation::LoadState(std::istream& In)
+{
+    Mybase::LoadState(In);
+    uint64 Equations, Order, Events;
+    __Snapshot_Read(In, Equations);
+    __Snapshot_Read(In, Order);
+    __Snapshot_Read(In, Events);
+    if (Equations != EquationCount || Order != DenseOutputOrder)
+    {
+        throw std::logic_error("Snapshot does not match the size of this engine.");
+    }
+    if (Events != EventList.size())
+    {
+        throw std::logic_error("Snapshot does not match the events of this engine.");
+    }
+    __Snapshot_Read(In, SegmentStarts);
+    __Snapshot_Read(In, SegmentEnds);
+    __Snapshot_Read(In, SegmentBase);
+    __Snapshot_Read(In, SegmentCoeffs);
+    __Snapshot_Read(In, SegmentHead);
+    __Snapshot_Read(In, PrevT);
+    __Snapshot_Read(In, CurrentT);
+    __Snapshot_Read(In, PrevY);
+    __Snapshot_Read(In, CurrentY);
+    __Snapshot_Read(In, StepCoeffs);
+    __Snapshot_Read(In, StepCoeffsPoint);
+    __Snapshot_Read(In, EventValues);
+    uint64 Count;
+    __Snapshot_Read(In, Count);
+    EventLog.resize(Count);
+    for (auto& Record : EventLog)
+    {
+        __Snapshot_Read(In, Record.Index);
+        __Snapshot_Read(In, Record.Time);
+        __Snapshot_Read(In, Record.State);
+    }
+}
+
+void RungeKuttaODEEngine::SaveState(std::ostream& Out)const
+{
+    Mybase::SaveState(Out);
+    __Snapshot_Write(Out, NewY);
+    __Snapshot_Write(Out, CurrentFx);
+    __Snapshot_Write(Out, StageY);
+    __Snapshot_Write(Out, ErrorScale);
+    __Snapshot_Write(Out, KTable);
+    __Snapshot_Write(Out, RelTolerNLog);
+    __Snapshot_Write(Out, AbsTolerNLog);
+    __Snapshot_Write(Out, MaxStep);
+    __Snapshot_Write(Out, AbsStep);
+}
+
+void RungeKuttaODEEngine::LoadState(std::istream& In)
+{
+    Mybase::LoadState(In);
+    __Snapshot_Read(In, NewY);
+    __Snapshot_Read(In, CurrentFx);
+    __Snapshot_Read(In, StageY);
+    __Snapshot_Read(In, ErrorScale);
+    __Snapshot_Read(In, KTable);
+    __Snapshot_Read(In, RelTolerNLog);
+    __Snapshot_Read(In, AbsTolerNLog);
+    __Snapshot_Read(In, MaxStep);
+    __Snapshot_Read(In, AbsStep);
+}
+
+void RungeKutta8thOrderODEEngine::SaveState(std::ostream& Out)const
+{
+    Mybase::SaveState(Out);
+    __Snapshot_Write(Out, ExtraK);
+}
+
+void RungeKutta8thOrderODEEngine::LoadState(std::istream& In)
+{
+    Mybase::LoadState(In);
+    __Snapshot_Read(In, ExtraK);
+}
+
+void __Implicit_Ordinary_Differential_Equation::SaveState(std::ostream& Out)const
+{
+    Mybase::SaveState(Out);
+    __Snapshot_Write(Out, Jacobian);
+    __Snapshot_Write(Out, CurrentFx);
+    __Snapshot_Write(Out, JacobianCount);
+    __Snapshot_Write(Out, DecompositionCount);
+    __Snapshot_Write(Out, RelTolerNLog);
+    __Snapshot_Write(Out, AbsTolerNLog);
+    __Snapshot_Write(Out, MaxStep);
+    __Snapshot_Write(Out, AbsStep);
+    __Snapshot_Write(Out, NewtonToler);
+}
+
+void __Implicit_Ordinary_Differential_Equation::LoadState(std::istream& In)
+{
+    Mybase::LoadState(In);
+    __Snapshot_Read(In, Jacobian);
+    __Snapshot_Read(In, CurrentFx);
+    __Snapshot_Read(In, JacobianCount);
+    __Snapshot_Read(In, DecompositionCount);
+    __Snapshot_Read(In, RelTolerNLog);
+    __Snapshot_Read(In, AbsTolerNLog);
+    __Snapshot_Read(In, MaxStep);
+    __Snapshot_Read(In, AbsStep);
+    __Snapshot_Read(In, NewtonToler);
+}
+
+void RadauIIAODEEngine::SaveState(std::ostream& Out)const
+{
+    Mybase::SaveState(Out);
+    __Snapshot_Write(Out, LUReal);
+    __Snapshot_Write(Out, LUComplex);
+    __Snapshot_Write(Out, PivotsReal);
+    __Snapshot_Write(Out, PivotsComplex);
+    __Snapshot_Write(Out, LUValid);
+    __Snapshot_Write(Out, CurrentJacobian);
+    __Snapshot_Write(Out, HasDenseOutput);
+    __Snapshot_Write(Out, AbsStepOld);
+    __Snapshot_Write(Out, ErrorNormOld);
+    for (const ValueArray* Array : {&Z, &Z0, &W, &DeltaW, &F, &Scale, &NewY, &NewFx, &ErrorVec, &Tmp, &DenseQ})
+    {
+        __Snapshot_Write(Out, *Array);
+    }
+    __Snapshot_Write(Out, ComplexTmp);
+}
+
+void RadauIIAODEEngine::LoadState(std::istream& In)
+{
+    Mybase::LoadState(In);
+    __Snapshot_Read(In, LUReal);
+    __Snapshot_Read(In, LUComplex);
+    __Snapshot_Read(In, PivotsReal);
+    __Snapshot_Read(In, PivotsComplex);
+    __Snapshot_Read(In, LUValid);
+    __Snapshot_Read(In, CurrentJacobian);
+    __Snapshot_Read(In, HasDenseOutput);
+    __Snapshot_Read(In, AbsStepOld);
+    __Snapshot_Read(In, ErrorNormOld);
+    for (ValueArray* Array : {&Z, &Z0, &W, &DeltaW, &F, &Scale, &NewY, &NewFx, &ErrorVec, &Tmp, &DenseQ})
+    {
+        __Snapshot_Read(In, *Array);
+    }
+    __Snapshot_Read(In, ComplexTmp);
+}
+
+void BackwardDifferentiationODEEngine::SaveState(std::ostream& Out)const
+{
+    Mybase::SaveState(Out);
+    __Snapshot_Write(Out, Differences);
+    __Snapshot_Write(Out, Order);
+    __Snapshot_Write(Out, EqualSteps);
+    __Snapshot_Write(Out, LU);
+    __Snapshot_Write(Out, Pivots);
+    __Snapshot_Write(Out, LUValid);
+    for (const ValueArray* Array : {&YPredict, &Psi, &Scale, &NewY, &Correction, &Delta, &F, &DenseD})
+    {
+        __Snapshot_Write(Out, *Array);
+    }
+    __Snapshot_Write(Out, DenseOrder);
+}
+
+void BackwardDifferentiationODEEngine::LoadState(std::istream& In)
+{
+    Mybase::LoadState(In);
+    __Snapshot_Read(In, Differences);
+    __Snapshot_Read(In, Order);
+    __Snapshot_Read(In, EqualSteps);
+    __Snapshot_Read(In, LU);
+    __Snapshot_Read(In, Pivots);
+    __Snapshot_Read(In, LUValid);
+    for (ValueArray* Array : {&YPredict, &Psi, &Scale, &NewY, &Correction, &Delta, &F, &DenseD})
+    {
+        __Snapshot_Read(In, *Array);
+    }
+    __Snapshot_Read(In, DenseOrder);
+}
+
+void AdamsODEEngine::SaveState(std::ostream& Out)const
+{
+    Mybase::SaveState(Out);
+    for (const ValueArray* Array : {&Nordsieck, &Predicted, &Correction, &PrevCorrection, &NewFx, &Scale,
+        &StartupT, &StartupY, &StartupFx})
+    {
+        __Snapshot_Write(Out, *Array);
+    }
+    __Snapshot_Write(Out, StepSize);
+    __Snapshot_Write(Out, Order);
+    __Snapshot_Write(Out, StepsAtOrder);
+    __Snapshot_Write(Out, PendingEta);
+    __Snapshot_Write(Out, PendingOrder);
+    __Snapshot_Write(Out, StartupStep);
+    __Snapshot_Write(Out, StartupIndex);
+    __Snapshot_Write(Out, RelTolerNLog);
+    __Snapshot_Write(Out, AbsTolerNLog);
+    __Snapshot_Write(Out, MaxStep);
+}
+
+void AdamsODEEngine::LoadState(std::istream& In)
+{
+    Mybase::LoadState(In);
+    for (ValueArray* Array : {&Nordsieck, &Predicted, &Correction, &PrevCorrection, &NewFx, &Scale,
+        &StartupT, &StartupY, &StartupFx})
+    {
+        __Snapshot_Read(In, *Array);
+    }
+    __Snapshot_Read(In, StepSize);
+    __Snapshot_Read(In, Order);
+    __Snapshot_Read(In, StepsAtOrder);
+    __Snapshot_Read(In, PendingEta);
+    __Snapshot_Read(In, PendingOrder);
+    __Snapshot_Read(In, StartupStep);
+    __Snapshot_Read(In, StartupIndex);
+    __Snapshot_Read(In, RelTolerNLog);
+    __Snapshot_Read(In, AbsTolerNLog);
+    __Snapshot_Read(In, MaxStep);
+}
+
+// ---------------------------------------------------------------------------- //
+
+void __Symplectic_Ordinary_Differential_Equation::SaveState(std::ostream& Out)const
+{
+    OrdinaryDifferentialEquation::SaveState(Out);
+    __Snapshot_Write(Out, StepSize);
+    __Snapshot_Write(Out, PrevT);
+    __Snapshot_Write(Out, CurrentT);
+    __Snapshot_Write(Out, PrevY);
+    __Snapshot_Write(Out, CurrentY);
+}
+
+void __Symplectic_Ordinary_Differential_Equation::LoadState(std::istream& In)
+{
+    OrdinaryDifferentialEquation::LoadState(In);
+    __Snapshot_Read(In, StepSize);
+    __Snapshot_Read(In, PrevT);
+    __Snapshot_Read(In, CurrentT);
+    __Snapshot_Read(In, PrevY);
+    __Snapshot_Read(In, CurrentY);
+}
+
+void SymplecticODEEngine::SaveState(std::ostream& Out)const
+{
+    Mybase::SaveState(Out);
+    __Snapshot_Write(Out, Dimensions);
+    __Snapshot_Write(Out, Scheme);
+    __Snapshot_Write(Out, Increment);
+}
+
+void SymplecticODEEngine::LoadState(std::istream& In)
+{
+    Mybase::LoadState(In);
+    uint64 Dims;
+    SchemeType Sch;
+    __Snapshot_Read(In, Dims);
+    __Snapshot_Read(In, Sch);
+    if (Dims != Dimensions || Sch != Scheme)
+    {
+        throw std::logic_error("Snapshot does not match the size or scheme of this engine.");
+    }
+    __Snapshot_Read(In, Increment);
+}
+
+void WisdomHolmanEngine::SaveState(std::ostream& Out)const
+{
+    Mybase::SaveState(Out);
+    __Snapshot_Write(Out, GravParams);
+    __Snapshot_Write(Out, Acceleration);
+}
+
+void WisdomHolmanEngine::LoadState(std::istream& In)
+{
+    Mybase::LoadState(In);
+    ValueArray Params;
+    __Snapshot_Read(In, Params);
+    if (Params != GravParams)
+    {
+        throw std::logic_error("Snapshot does not match the gravitational parameters of this engine.");
     }
-    return Segment(_Xx);
+    __Snapshot_Read(In, Acceleration);
 }
 
 _SCICXX_END
@@ -1,4 +1,5 @@
 #include "CSE/Base/Random.h"
+#include <algorithm>
 
 _CSE_BEGIN
 
@@ -8,4 +9,199 @@ Probability::_CSE_Random_Engine<std::mersenne_twister_engine
     0x5555555555555555ULL, 17, 0x71D67FFFEDA60000ULL, 37, 0xFFF7EEE000000000ULL, 43, 0x5851F42D4C957F2DULL>>
     random(_Rd());
 
+namespace Probability {
+
+_Tabulated_Inverse_CDF::_Tabulated_Inverse_CDF(_SCICXX Function1D CDF, vec2 Domain, float64 TolerNLog)
+{
+    OriginalFunction = CDF;
+    if (Domain[0] > Domain[1]) {std::swap(Domain[0], Domain[1]);}
+    float64 Toler = pow(10, -TolerNLog);
+
+    // 按定义域两端归一化，无穷远处取累积分布函数的极限0和1
+    float64 Min = isinf(Domain[0]) ? 0. : CDF(Domain[0]);
+    float64 Max = isinf(Domain[1]) ? 1. : CDF(Domain[1]);
+    if (!(Max > Min)) {throw std::logic_error("Distribution has no probability in the domain.");}
+    auto Normalized = [&](float64 x)
+    {
+        float64 u = (CDF(x) - Min) / (Max - Min);
+        return u < 0. ? 0. : (u > 1. ? 1. : u);
+    };
+
+    // ---------- 截断无穷的定义域 ---------- //
+
+    vec2 Bounds = Domain;
+    if (isinf(Bounds[0]))
+    {
+        float64 Ref = isinf(Bounds[1]) ? 0. : Bounds[1];
+        for (float64 Step = 1; isinf(Bounds[0]) || Normalized(Bounds[0]) > TailMass; Step *= 2)
+        {
+            Bounds[0] = Ref - Step;
+            if (isinf(Bounds[0])) {throw std::logic_error("Failed to truncate the lower tail of the distribution.");}
+        }
+    }
+    if (isinf(Bounds[1]))
+    {
+        for (float64 Step = 1; isinf(Bounds[1]) || 1. - Normalized(Bounds[1]) > TailMass; Step *= 2)
+        {
+            Bounds[1] = Bounds[0] + Step;
+            if (isinf(Bounds[1])) {throw std::logic_error("Failed to truncate the upper tail of the distribution.");}
+        }
+    }
+
+    // ---------- 自适应加密 ---------- //
+
+    for (uint64 i = 0; i < InitialNodes; ++i)
+    {
+        float64 x = i + 1 == InitialNodes ? Bounds[1] :
+            Bounds[0] + (Bounds[1] - Bounds[0]) * (float64(i) / float64(InitialNodes - 1));
+        Values.push_back(x);
+        Nodes.push_back(Normalized(x));
+    }
+
+    // 区间的插值只依赖于自身和相邻的区间，相邻区间都未加密时已检查过的区间不必重新检查。
+    // 只检查一个点是不够的：窄峰恰好位于区间中点时，对称的插值在中点处也是准确的
+    const float64 Checkpoints[3] = {0.25, 0.5, 0.75};
+    std::vector<float64> NewValues, NewNodes, Errors(Values.size() - 1, 0), NewErrors;
+    std::vector<uint8_t> Checked(Values.size() - 1, 0), NewChecked;
+    for (;;)
+    {
+        ComputeSlopes();
+        NewValues.clear();
+        NewNodes.clear();
+        std::vector<uint8_t> Split(Values.size() - 1, 0);
+        for (uint64 i = 0; i + 1 < Values.size(); ++i)
+        {
+            NewValues.push_back(Values[i]);
+            NewNodes.push_back(Nodes[i]);
+            if (Checked[i]) {continue;}
+
+            // x(u)落在区间内，所以误差不超过区间概率的一半
+            float64 Mass = Nodes[i + 1] - Nodes[i];
+            Errors[i] = Mass / 2.;
+            if (Errors[i] > Toler && Mass <= MaxIntervalMass)
+            {
+                Errors[i] = 0;
+                for (float64 t : Checkpoints)
+                {
+                    Errors[i] = max(Errors[i], abs(Normalized(Interpolate(i, t)) - (Nodes[i] + Mass * t)));
+                }
+            }
+            if (Errors[i] <= Toler) {continue;}
+
+            float64 Mid = Values[i] + (Values[i + 1] - Values[i]) / 2.;
+            if (Mid <= Values[i] || Mid >= Values[i + 1]) {continue;} // 已无法再分
+            if (Values.size() + NewValues.size() - i - 1 >= MaxNodes) {continue;}
+            NewValues.push_back(Mid);
+            NewNodes.push_back(Normalized(Mid));
+            Split[i] = 1;
+        }
+        if (std::find(Split.begin(), Split.end(), 1) == Split.end()) {break;}
+        NewValues.push_back(Values.back());
+        NewNodes.push_back(Nodes.back());
+
+        NewChecked.clear();
+        NewErrors.clear();
+        for (uint64 i = 0; i < Split.size(); ++i)
+        {
+            if (Split[i])
+            {
+                NewChecked.insert(NewChecked.end(), {0, 0});
+                NewErrors.insert(NewErrors.end(), {0., 0.});
+                continue;
+            }
+            bool Neighbors = (i > 0 && Split[i - 1]) || (i + 1 < Split.size() && Split[i + 1]);
+            NewChecked.push_back(!Neighbors);
+            NewErrors.push_back(Errors[i]);
+        }
+        std::swap(Values, NewValues);
+        std::swap(Nodes, NewNodes);
+        std::swap(Checked, NewChecked);
+        std::swap(Errors, NewErrors);
+    }
+    ErrorEstimate = *std::max_element(Errors.begin(), Errors.end());
+
+    BuildAliasTable();
+}
+
+void _Tabulated_Inverse_CDF::ComputeSlopes()
+{
+    // Fritsch-Carlson方法(与SciPy的PchipInterpolator相同)，自变量为u，因变量为x。
+    // 概率为0的区间是反函数的间断处，两侧的节点按端点处理
+    uint64 n = Values.size() - 1;
+    auto Valid = [&](uint64 i) {return i < n && Nodes[i + 1] > Nodes[i];};
+    auto Secant = [&](uint64 i) {return (Values[i + 1] - Values[i]) / (Nodes[i + 1] - Nodes[i]);};
+    auto EndSlope = [&](uint64 i, uint64 j) // i为端点所在的区间，j为与其相邻的区间
+    {
+        float64 h0 = Nodes[i + 1] - Nodes[i], h1 = Nodes[j + 1] - Nodes[j];
+        float64 d0 = Secant(i), d1 = Secant(j);
+        float64 d = ((2. * h0 + h1) * d0 - h0 * d1) / (h0 + h1);
+        return d > 0. ? d : 0.;
+    };
+
+    Slopes.assign(2 * n, 0.);
+    for (uint64 k = 0; k <= n; ++k)
+    {
+        bool Left = k > 0 && Valid(k - 1), Right = Valid(k);
+        float64 d = 0;
+        if (Left && Right)
+        {
+            float64 h0 = Nodes[k] - Nodes[k - 1], h1 = Nodes[k + 1] - Nodes[k];
+            float64 w1 = 2. * h1 + h0, w2 = h1 + 2. * h0;
+            d = (w1 + w2) / (w1 / Secant(k - 1) + w2 / Secant(k));
+        }
+        else if (Right) {d = Valid(k + 1) ? EndSlope(k, k + 1) : Secant(k);}
+        else if (Left) {d = k > 1 && Valid(k - 2) ? EndSlope(k - 1, k - 2) : Secant(k - 1);}
+        if (k > 0) {Slopes[2 * (k - 1) + 1] = d * (Nodes[k] - Nodes[k - 1]);}
+        if (k < n) {Slopes[2 * k] = d * (Nodes[k + 1] - Nodes[k]);}
+    }
+}
+
+void _Tabulated_Inverse_CDF::BuildAliasTable()
+{
+    // Vose, 1991, A linear algorithm for generating random numbers with a given distribution
+    uint64 n = Values.size() - 1;
+    float64 Total = Nodes.back() - Nodes.front();
+    Probs.resize(n);
+    Aliases.resize(n);
+    std::vector<uint64> Small, Large;
+    uint64 Heaviest = 0;
+    for (uint64 i = 0; i < n; ++i)
+    {
+        if (Nodes[i + 1] - Nodes[i] > Nodes[Heaviest + 1] - Nodes[Heaviest]) {Heaviest = i;}
+        Probs[i] = (Nodes[i + 1] - Nodes[i]) / Total * float64(n);
+        Aliases[i] = i;
+        (Probs[i] < 1. ? Small : Large).push_back(i);
+    }
+    while (!Small.empty() && !Large.empty())
+    {
+        uint64 s = Small.back(), l = Large.back();
+        Small.pop_back();
+        Aliases[s] = l;
+        Probs[l] -= 1. - Probs[s];
+        if (Probs[l] < 1.)
+        {
+            Large.pop_back();
+            Small.push_back(l);
+        }
+    }
+    // 剩余的项只差舍入误差，但概率为0的区间仍不能被选中
+    for (uint64 i : Large) {Probs[i] = 1.;}
+    for (uint64 i : Small)
+    {
+        Probs[i] = Nodes[i + 1] > Nodes[i] ? 1. : 0.;
+        Aliases[i] = Heaviest;
+    }
+}
+
+float64 _Tabulated_Inverse_CDF::operator()(float64 u)const
+{
+    // 两端概率为0的部分取最靠内的节点
+    if (u < Nodes.front()) {return Values.front();}
+    if (u >= Nodes.back()) {return Values[std::lower_bound(Nodes.begin(), Nodes.end(), Nodes.back()) - Nodes.begin()];}
+    uint64 i = std::upper_bound(Nodes.begin(), Nodes.end(), u) - Nodes.begin() - 1;
+    return Interpolate(i, (u - Nodes[i]) / (Nodes[i + 1] - Nodes[i]));
+}
+
+} // End Probability
+
 _CSE_END